@@ -0,0 +1,864 @@
+/*
+*   codec and DSP benchmarks, e.g. ./sbc_bench -m 1000000 -k brr > bench.json
+*
+*   every kernel runs on the same synthetic signals at 1K..100M samples and reports
+*   ns per sample and MB/s of input as JSON on stdout. built by `make bench`, which
+*   also links the waveform drawing code when SDL2 and GTK are installed.
+*/
+
+#include <math.h>
+
+#include "sbc_core.h"
+
+#ifdef SBC_BENCH_GUI
+#include "sbc_screen.h"
+#include "sbc_waveform.h"
+#endif
+
+#define BENCH_RATE          32000
+#define BENCH_OUT_RATE      48000
+#define BENCH_RESAMPLE_RATE 22050
+
+#define BENCH_MIN_SIZE      1000
+#define BENCH_MAX_SIZE      100000000
+#define BENCH_MAX_REPS      100
+
+/* samples encoded once and repeated to build the BRR decoder input */
+#define BENCH_BRR_TILE      16384
+
+/* find_chunk_name and wavparse's smpl lookup read a little past the end of the file */
+#define BENCH_FILE_PAD      64
+
+typedef struct Bench_Ctx_s
+{
+    const int16_t *signal;
+    int length;
+
+    /* borrows signal, never freed */
+    Sample_t src;
+
+    /* whatever the kernel decoded or produced, freed between reps */
+    Sample_t out;
+
+    char *file_buf;
+    int file_len;
+    const char *name_hint;
+
+    InterpolationType_t interp;
+    CompandCurve_t curve;
+
+    size_t bytes;
+    double sink;
+} bench_ctx_t;
+
+typedef struct Bench_Case_s
+{
+    const char *name;
+    int max_len;
+
+    /* builds the kernel's input from ctx->signal and sets ctx->bytes */
+    bool (*prepare)(bench_ctx_t *ctx);
+
+    /* untimed, runs before every rep */
+    void (*reset)(bench_ctx_t *ctx);
+
+    bool (*run)(bench_ctx_t *ctx);
+} bench_case_t;
+
+typedef struct Bench_Signal_s
+{
+    const char *name;
+    void (*generate)(int16_t *buf, const int len);
+} bench_signal_t;
+
+static volatile double bench_sink = 0.0;
+static bool first_result = true;
+
+/* ---------------------------------------------------------------- signals */
+
+static void gen_sine(int16_t *buf, const int len)
+{
+    const double step = 2.0 * M_PI * 440.0 / BENCH_RATE;
+
+    for(int i = 0; i < len; i++)
+        buf[i] = (int16_t) lrint(sin(step * (i % BENCH_RATE)) * 26214.0);
+}
+
+static void gen_noise(int16_t *buf, const int len)
+{
+    uint32_t x = 0x9E3779B9;
+
+    for(int i = 0; i < len; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+
+        buf[i] = (int16_t) (x >> 16);
+    }
+}
+
+/* 20Hz to 16kHz linear sweep, repeating every second */
+static void gen_chirp(int16_t *buf, const int len)
+{
+    const double f0 = 20.0, f1 = 16000.0, sweep = 1.0;
+
+    for(int i = 0; i < len; i++)
+    {
+        const double t = (double) (i % BENCH_RATE) / BENCH_RATE;
+
+        buf[i] = (int16_t) lrint(sin(2.0 * M_PI * (f0 * t + (f1 - f0) * t * t / (2.0 * sweep))) * 26214.0);
+    }
+}
+
+static void gen_silence(int16_t *buf, const int len)
+{
+    memset(buf, 0, (size_t) len * sizeof *buf);
+}
+
+static const bench_signal_t bench_signals[] =
+{
+    { "sine",    gen_sine    },
+    { "noise",   gen_noise   },
+    { "chirp",   gen_chirp   },
+    { "silence", gen_silence },
+};
+
+/* ---------------------------------------------------------------- file builders */
+
+static void put16le(char *b, const int i, const uint16_t v) { b[i] = (char) v; b[i + 1] = (char) (v >> 8); }
+static void put32le(char *b, const int i, const uint32_t v) { put16le(b, i, (uint16_t) v); put16le(b, i + 2, (uint16_t) (v >> 16)); }
+static void put16be(char *b, const int i, const uint16_t v) { b[i] = (char) (v >> 8); b[i + 1] = (char) v; }
+static void put32be(char *b, const int i, const uint32_t v) { put16be(b, i, (uint16_t) (v >> 16)); put16be(b, i + 2, (uint16_t) v); }
+
+static char *alloc_file(bench_ctx_t *ctx, const int len, const char *name_hint)
+{
+    SBC_CALLOC((size_t) len + BENCH_FILE_PAD, sizeof *ctx->file_buf, ctx->file_buf);
+
+    ctx->file_len  = len;
+    ctx->name_hint = name_hint;
+    ctx->bytes     = (size_t) len;
+
+    return ctx->file_buf;
+}
+
+static bool prepare_wav(bench_ctx_t *ctx, const int bit_depth, const int num_chan)
+{
+    const int bytes = bit_depth / 8, frame = bytes * num_chan, data_len = ctx->length * frame;
+    char *b = alloc_file(ctx, 44 + data_len, "bench.wav");
+
+    memcpy(b, "RIFF", 4);
+    put32le(b, 4, (uint32_t) (36 + data_len));
+    memcpy(b + 8, "WAVEfmt ", 8);
+    put32le(b, 16, 16);
+    put16le(b, 20, 1);
+    put16le(b, 22, (uint16_t) num_chan);
+    put32le(b, 24, BENCH_RATE);
+    put32le(b, 28, (uint32_t) (BENCH_RATE * frame));
+    put16le(b, 32, (uint16_t) frame);
+    put16le(b, 34, (uint16_t) bit_depth);
+    memcpy(b + 36, "data", 4);
+    put32le(b, 40, (uint32_t) data_len);
+
+    /* 24-bit samples get a zero low byte, odd channels are inverted so side isn't silent */
+    for(int i = 0; i < ctx->length; i++)
+        for(int c = 0; c < num_chan; c++)
+            put16le(b, 44 + i * frame + c * bytes + bytes - 2, (uint16_t) (c & 1 ? ~ctx->signal[i] : ctx->signal[i]));
+
+    return true;
+}
+
+static bool prepare_wav16(bench_ctx_t *ctx) { return prepare_wav(ctx, 16, 1); }
+static bool prepare_wav24(bench_ctx_t *ctx) { return prepare_wav(ctx, 24, 1); }
+static bool prepare_stereo(bench_ctx_t *ctx) { return prepare_wav(ctx, 16, 2); }
+static bool prepare_5_1(bench_ctx_t *ctx)    { return prepare_wav(ctx, 24, 6); }
+
+static bool prepare_wavf32(bench_ctx_t *ctx)
+{
+    prepare_wav(ctx, 32, 1);
+    put16le(ctx->file_buf, 20, 3);
+
+    for(int i = 0; i < ctx->length; i++)
+    {
+        const float f = (float) ctx->signal[i] / 32768.f;
+        memcpy(ctx->file_buf + 44 + i * 4, &f, sizeof f);
+    }
+
+    return true;
+}
+
+static bool prepare_aif(bench_ctx_t *ctx)
+{
+    const int data_len = ctx->length * 2;
+    char *b = alloc_file(ctx, 54 + data_len, "bench.aif");
+
+    /* 32000 as an 80-bit extended float */
+    const uint8_t rate[10] = { 0x40, 0x0D, 0xFA, 0x00, 0, 0, 0, 0, 0, 0 };
+
+    memcpy(b, "FORM", 4);
+    put32be(b, 4, (uint32_t) (46 + data_len));
+    memcpy(b + 8, "AIFFCOMM", 8);
+    put32be(b, 16, 18);
+    put16be(b, 20, 1);
+    put32be(b, 22, (uint32_t) ctx->length);
+    put16be(b, 26, 16);
+    memcpy(b + 28, rate, 10);
+    memcpy(b + 38, "SSND", 4);
+    put32be(b, 42, (uint32_t) (data_len + 8));
+    put32be(b, 46, 0);
+    put32be(b, 50, 0);
+
+    for(int i = 0; i < ctx->length; i++)
+        put16be(b, 54 + i * 2, (uint16_t) ctx->signal[i]);
+
+    return true;
+}
+
+static bool prepare_iff(bench_ctx_t *ctx)
+{
+    char *b = alloc_file(ctx, 48 + ctx->length, "bench.iff");
+
+    memcpy(b, "FORM", 4);
+    put32be(b, 4, (uint32_t) (40 + ctx->length));
+    memcpy(b + 8, "8SVXVHDR", 8);
+    put32be(b, 16, 20);
+    put32be(b, 20, (uint32_t) ctx->length);
+    put16be(b, 32, BENCH_RATE);
+    b[34] = 1;
+    put32be(b, 36, 0x10000);
+    memcpy(b + 40, "BODY", 4);
+    put32be(b, 44, (uint32_t) ctx->length);
+
+    for(int i = 0; i < ctx->length; i++)
+        b[48 + i] = (char) (ctx->signal[i] >> 8);
+
+    return true;
+}
+
+static bool prepare_mulaw(bench_ctx_t *ctx)
+{
+    char *b = alloc_file(ctx, ctx->length, "bench.bin");
+
+    for(int i = 0; i < ctx->length; i++)
+        b[i] = (char) ((ctx->signal[i] >> 8) ^ 0x80);
+
+    return true;
+}
+
+static bool prepare_alaw(bench_ctx_t *ctx)
+{
+    prepare_mulaw(ctx);
+    ctx->name_hint = "bench.al";
+
+    return true;
+}
+
+/* file_buf is only the output here, ctx->bytes counts the 16-bit input */
+static bool prepare_compand(bench_ctx_t *ctx, const CompandCurve_t curve)
+{
+    alloc_file(ctx, ctx->length, "bench.bin");
+
+    ctx->curve = curve;
+    ctx->bytes = (size_t) ctx->length * sizeof *ctx->signal;
+
+    return true;
+}
+
+static bool prepare_linn_enc(bench_ctx_t *ctx) { return prepare_compand(ctx, COMPAND_LINN); }
+static bool prepare_ulaw_enc(bench_ctx_t *ctx) { return prepare_compand(ctx, COMPAND_ULAW); }
+static bool prepare_alaw_enc(bench_ctx_t *ctx) { return prepare_compand(ctx, COMPAND_ALAW); }
+
+/* encodes the first BENCH_BRR_TILE samples and repeats the blocks, only the last one ends the sample */
+static bool prepare_brr(bench_ctx_t *ctx)
+{
+    const int num_blocks = (ctx->length + 15) / 16;
+
+    Sample_t tile = ctx->src;
+    uint8_t *tile_buf = NULL;
+    size_t tile_len = 0;
+    int tile_blocks = 0;
+
+    char *b = NULL;
+
+    tile.audio.length = ctx->length < BENCH_BRR_TILE ? ctx->length : BENCH_BRR_TILE;
+    tile.is_looped = false;
+
+    if((tile_buf = encodeBrrBuffer(&tile, &tile_len, BRR_ENCODE_FAST)) == NULL) return false;
+
+    tile_blocks = (int) (tile_len / 9);
+    b = alloc_file(ctx, num_blocks * 9, "bench.brr");
+
+    for(int i = 0; i < num_blocks; i++)
+    {
+        memcpy(b + i * 9, tile_buf + (i % tile_blocks) * 9, 9);
+        b[i * 9] &= ~0x03;
+    }
+
+    b[(num_blocks - 1) * 9] |= 0x01;
+
+    SBC_FREE(tile_buf);
+
+    return true;
+}
+
+static bool prepare_pcm(bench_ctx_t *ctx)
+{
+    ctx->bytes = (size_t) ctx->length * sizeof *ctx->signal;
+    return true;
+}
+
+/* ---------------------------------------------------------------- kernels */
+
+static void free_out(bench_ctx_t *ctx)
+{
+    SBC_FREE(ctx->out.audio.buffer);
+}
+
+static void reset_wav(bench_ctx_t *ctx)
+{
+    free_out(ctx);
+    setLoadDither(false);
+    setDownmixMode(DOWNMIX_LEFT);
+}
+
+static void reset_wav_dither(bench_ctx_t *ctx)
+{
+    free_out(ctx);
+    setLoadDither(true);
+}
+
+static void reset_wav_right(bench_ctx_t *ctx)
+{
+    reset_wav(ctx);
+    setDownmixMode(DOWNMIX_RIGHT);
+}
+
+static void reset_wav_mid(bench_ctx_t *ctx)
+{
+    reset_wav(ctx);
+    setDownmixMode(DOWNMIX_MID);
+}
+
+/* 5.1 folded down with the usual -3dB centre and surrounds, LFE left out */
+static void reset_wav_mix(bench_ctx_t *ctx)
+{
+    reset_wav(ctx);
+    setDownmixWeights((const float[]) { 0.5f, 0.5f, 0.354f, 0.f, 0.354f, 0.354f }, 6);
+    setDownmixMode(DOWNMIX_WEIGHTED);
+}
+
+static void reset_brr_classic(bench_ctx_t *ctx)
+{
+    free_out(ctx);
+    setBrrDecodeMode(BRR_DECODE_CLASSIC);
+}
+
+static void reset_brr_sdsp(bench_ctx_t *ctx)
+{
+    free_out(ctx);
+    setBrrDecodeMode(BRR_DECODE_SDSP);
+}
+
+static bool run_decode(bench_ctx_t *ctx)
+{
+    if(decodeSampleBuffer(ctx->file_buf, ctx->file_len, ctx->name_hint, &ctx->out) == SAMP_FILE_ERROR) return false;
+
+    ctx->sink += ctx->out.audio.buffer[ctx->out.audio.length - 1];
+    return true;
+}
+
+static bool run_brr_encode(bench_ctx_t *ctx)
+{
+    size_t brr_len = 0;
+    uint8_t *brr_buf = encodeBrrBuffer(&ctx->src, &brr_len, getBrrEncodeMode());
+
+    if(brr_buf == NULL) return false;
+
+    ctx->sink += brr_buf[brr_len - 1];
+    SBC_FREE(brr_buf);
+
+    return true;
+}
+
+static bool run_compand(bench_ctx_t *ctx)
+{
+    compressFromS16(ctx->signal, (uint8_t*) ctx->file_buf, ctx->length, ctx->curve);
+
+    ctx->sink += ctx->file_buf[ctx->length - 1];
+    return true;
+}
+
+/* 
+*   writeSampleFile into the current directory, name_hint is the file it writes.
+*   the file is synced before it's renamed into place, so this includes the fsync
+*/
+static bool run_export(bench_ctx_t *ctx, const bool bit16)
+{
+    const bool saved = writeSampleFile(ctx->name_hint, &ctx->src, bit16);
+
+    remove(ctx->name_hint);
+    return saved;
+}
+
+static bool prepare_export_wav(bench_ctx_t *ctx) { ctx->name_hint = "sbc_bench_export.wav"; return prepare_pcm(ctx); }
+static bool prepare_export_aif(bench_ctx_t *ctx) { ctx->name_hint = "sbc_bench_export.aif"; return prepare_pcm(ctx); }
+
+static bool run_export_8(bench_ctx_t *ctx)  { return run_export(ctx, false); }
+static bool run_export_16(bench_ctx_t *ctx) { return run_export(ctx, true); }
+
+static void reset_brr_fast(bench_ctx_t *ctx)
+{
+    (void) ctx;
+    setBrrEncodeMode(BRR_ENCODE_FAST);
+}
+
+/* no time budget, so the whole sample goes through the beam search */
+static void reset_brr_hq(bench_ctx_t *ctx)
+{
+    (void) ctx;
+    setBrrEncodeMode(BRR_ENCODE_QUALITY);
+    setBrrTimeBudget(0);
+}
+
+static void reset_resample(bench_ctx_t *ctx)
+{
+    setSampleEdit(&ctx->src);
+    setResampleRate(BENCH_RESAMPLE_RATE);
+    setResampleQuality(RESAMPLE_GOOD);
+}
+
+static void reset_resample_nearest(bench_ctx_t *ctx) { reset_resample(ctx); setResampleQuality(RESAMPLE_NEAREST); }
+static void reset_resample_fast(bench_ctx_t *ctx)    { reset_resample(ctx); setResampleQuality(RESAMPLE_FAST); }
+static void reset_resample_best(bench_ctx_t *ctx)    { reset_resample(ctx); setResampleQuality(RESAMPLE_BEST); }
+
+static bool run_resample(bench_ctx_t *ctx)
+{
+    if(!handleResample()) return false;
+
+    ctx->sink += (*getSampleEditBuffer())[0];
+    return true;
+}
+
+/* same stepping as incrementSample in sbc_audio.c, one input sample per shift */
+static bool run_interp(bench_ctx_t *ctx)
+{
+    const double delta = (double) BENCH_RATE / BENCH_OUT_RATE;
+
+    Interpolation_t interp;
+    double pos = 0.0, sum = 0.0;
+
+    interp.type = ctx->interp;
+    clearInterpolation(&interp);
+
+    while(pos < (double) ctx->length)
+    {
+        const int curr = (int) pos;
+        double outL = 0.0, outR = 0.0;
+
+        applySampleInterpolation(&interp, &outL, &outR, pos - (double) curr);
+        sum += outL + outR;
+
+        pos += delta;
+
+        if((int) pos > curr) shiftFilterCoeff(&interp, (float) ctx->signal[curr]);
+    }
+
+    ctx->sink += sum;
+    return true;
+}
+
+/* the block renderer audioCallback uses, without the device around it */
+static bool run_render(bench_ctx_t *ctx)
+{
+    const RenderKernel_t render = getRenderKernel(ctx->interp);
+
+    Voice_t voice;
+    float block[256];
+    double sum = 0.0;
+
+    memset(&voice, 0, sizeof voice);
+
+    voice.type   = ctx->interp;
+    voice.buffer = ctx->signal;
+    voice.length = ctx->length;
+    voice.step   = getVoiceStep(BENCH_RATE, BENCH_OUT_RATE, ctx->interp);
+
+    while(!voice.ended)
+    {
+        const int n = render(&voice, block, 256);
+
+        for(int i = 0; i < n; i++) sum += block[i];
+    }
+
+    ctx->sink += sum;
+    return true;
+}
+
+/* the BRR decoder input played through one S-DSP voice at pitch 0x1000, a sample out per sample in */
+static bool run_sdsp_voice(bench_ctx_t *ctx)
+{
+    Sdsp_t dsp;
+    int16_t block[256];
+    double sum = 0.0;
+
+    resetSdsp(&dsp);
+    keyOnSdspVoice(&dsp.voices[0], (const uint8_t*) ctx->file_buf, (size_t) ctx->file_len, 0x1000, (Sdsp_Envelope_t) { 0x00, 0x00, 0x7F });
+
+    /* prepare_brr clears the end flags, so the voice wraps around instead of stopping at the end */
+    for(int done = 0; done < ctx->length; done += 256)
+    {
+        const int n = ctx->length - done < 256 ? ctx->length - done : 256;
+
+        renderSdsp(&dsp, block, n);
+
+        for(int i = 0; i < n; i++) sum += block[i];
+    }
+
+    ctx->sink += sum;
+    return true;
+}
+
+/* a held eight note chord on the looped signal, as many outputs as there are samples */
+static bool run_poly(bench_ctx_t *ctx)
+{
+    Poly_Mixer_t mixer;
+    Voice_t source;
+    float block[256];
+    double sum = 0.0;
+
+    memset(&mixer, 0, sizeof mixer);
+    memset(&source, 0, sizeof source);
+
+    source.type     = ctx->interp;
+    source.buffer   = ctx->signal;
+    source.length   = ctx->length;
+    source.loop_end = ctx->length;
+    source.looped   = true;
+
+    setPolySource(&mixer, &source, BENCH_RATE, BENCH_OUT_RATE);
+
+    for(int i = 0; i < POLY_NUM_VOICES; i++) keyOnPolyNote(&mixer, (uint8_t) (POLY_ROOT_NOTE - 12 + i * 3), 100, 0);
+
+    for(int done = 0; done < ctx->length; done += 256)
+    {
+        const int n = ctx->length - done < 256 ? ctx->length - done : 256;
+
+        memset(block, 0, sizeof block);
+        mixPolyVoices(&mixer, block, n);
+
+        for(int i = 0; i < n; i++) sum += block[i];
+    }
+
+    ctx->sink += sum;
+    return true;
+}
+
+/*
+*   queueNote's order: a note keyed on into a mixer that's never had a source, then the source set by
+*   the next callback. a new note every 4096 outputs, and any of them coming out silent is a failure
+*/
+static bool run_poly_first_note(bench_ctx_t *ctx)
+{
+    Poly_Mixer_t mixer;
+    Voice_t source;
+    float block[256];
+    double sum = 0.0;
+
+    memset(&mixer, 0, sizeof mixer);
+    memset(&source, 0, sizeof source);
+
+    source.type   = ctx->interp;
+    source.buffer = ctx->signal;
+    source.length = ctx->length;
+
+    for(int done = 0; done < ctx->length; done += 256)
+    {
+        const int n = ctx->length - done < 256 ? ctx->length - done : 256;
+        const bool key_on = (done & 4095) == 0;
+        double level = 0.0, input = 0.0;
+
+        if(key_on) keyOnPolyNote(&mixer, POLY_ROOT_NOTE, 100, done);
+
+        setPolySource(&mixer, &source, BENCH_RATE, BENCH_OUT_RATE);
+
+        memset(block, 0, sizeof block);
+        mixPolyVoices(&mixer, block, n);
+
+        for(int i = 0; i < n; i++) level += fabs(block[i]);
+        for(int i = 0; i < n / 2; i++) input += abs(ctx->signal[done + i]);
+
+        /* the block only plays n * 2 / 3 inputs from where the note started, and silence is allowed to stay silent */
+        if(key_on && level == 0.0 && input > 0.0) return false;
+
+        sum += level;
+    }
+
+    ctx->sink += sum;
+    return true;
+}
+
+static bool prepare_nearest(bench_ctx_t *ctx) { ctx->interp = NEAREST; return prepare_pcm(ctx); }
+static bool prepare_linear(bench_ctx_t *ctx)  { ctx->interp = LINEAR;  return prepare_pcm(ctx); }
+static bool prepare_cubic(bench_ctx_t *ctx)   { ctx->interp = CUBIC;   return prepare_pcm(ctx); }
+static bool prepare_gauss(bench_ctx_t *ctx)   { ctx->interp = GAUSS;   return prepare_pcm(ctx); }
+
+static bool run_pitch(bench_ctx_t *ctx)
+{
+    ctx->sink += detectSampleRate(ctx->signal, ctx->length);
+    return true;
+}
+
+/* what the instrumentation adds to each 256 frame callback, with render times taken from the signal */
+static bool run_audio_stats(bench_ctx_t *ctx)
+{
+    static Audio_Stats_t stats;
+    Audio_Stats_Snapshot_t snap;
+    uint64_t start = 1;
+
+    resetAudioStats(&stats);
+    restartAudioStatsClock(&stats);
+
+    for(int done = 0; done < ctx->length; done += 256)
+    {
+        const int n = ctx->length - done < 256 ? ctx->length - done : 256;
+        const uint64_t render = (uint64_t) (ctx->signal[done] + 32768) * 100;
+
+        recordAudioCallback(&stats, start, start + render, n, BENCH_OUT_RATE);
+        start += 5333333 + (uint64_t) (ctx->signal[done] & 0xFF) * 1000;
+    }
+
+    getAudioStats(&stats, &snap);
+
+    ctx->sink += (double) (snap.render_total + snap.jitter_total + snap.late);
+    return true;
+}
+
+#ifdef SBC_BENCH_GUI
+static bool prepare_waveform(bench_ctx_t *ctx)
+{
+    setSampleEdit(&ctx->src);
+    drawNewWave();
+    resetZoom();
+
+    return prepare_pcm(ctx);
+}
+
+/* fully zoomed out, so every rep goes through draw_wave_polygons */
+static bool run_waveform(bench_ctx_t *ctx)
+{
+    repaintWaveform();
+    updateWaveform();
+
+    ctx->sink += (*getScreenBuffer())[SCREEN_WIDTH * SAMPLE_Y_CENTRE];
+    return true;
+}
+#endif
+
+/* O(n^2) autocorrelation, the pitch thread never looks at more than 0x2000 samples anyway */
+static const bench_case_t bench_cases[] =
+{
+    { "brrdecode",          BENCH_MAX_SIZE, prepare_brr,      reset_brr_classic, run_decode     },
+    { "brrdecode_sdsp",     BENCH_MAX_SIZE, prepare_brr,      reset_brr_sdsp,    run_decode     },
+    { "brr_encode",         BENCH_MAX_SIZE, prepare_pcm,      reset_brr_fast,    run_brr_encode },
+    { "brr_encode_hq",      100000,         prepare_pcm,      reset_brr_hq,      run_brr_encode },
+    { "wavparse_16",        BENCH_MAX_SIZE, prepare_wav16,    reset_wav,         run_decode     },
+    { "wavparse_24",        BENCH_MAX_SIZE, prepare_wav24,    reset_wav,         run_decode     },
+    { "wavparse_24_dither", BENCH_MAX_SIZE, prepare_wav24,    reset_wav_dither,  run_decode     },
+    { "wavparse_f32",       BENCH_MAX_SIZE, prepare_wavf32,   reset_wav,         run_decode     },
+    { "wavparse_16_right",  BENCH_MAX_SIZE, prepare_stereo,   reset_wav_right,   run_decode     },
+    { "wavparse_16_mid",    BENCH_MAX_SIZE, prepare_stereo,   reset_wav_mid,     run_decode     },
+    { "wavparse_24_5.1",    BENCH_MAX_SIZE, prepare_5_1,      reset_wav_mix,     run_decode     },
+    { "aifparse",           BENCH_MAX_SIZE, prepare_aif,      free_out,          run_decode     },
+    { "iffparse",           BENCH_MAX_SIZE, prepare_iff,      free_out,          run_decode     },
+    { "mulawdecode",        BENCH_MAX_SIZE, prepare_mulaw,    free_out,          run_decode     },
+    { "alawdecode",         BENCH_MAX_SIZE, prepare_alaw,     free_out,          run_decode     },
+    { "mulawencode",        BENCH_MAX_SIZE, prepare_linn_enc, NULL,              run_compand    },
+    { "g711_ulaw_encode",   BENCH_MAX_SIZE, prepare_ulaw_enc, NULL,              run_compand    },
+    { "g711_alaw_encode",   BENCH_MAX_SIZE, prepare_alaw_enc, NULL,              run_compand    },
+    { "wavexport_8",        10000000,       prepare_export_wav, NULL,            run_export_8   },
+    { "aifexport_16",       10000000,       prepare_export_aif, NULL,            run_export_16  },
+    { "handleResample",     BENCH_MAX_SIZE, prepare_pcm,      reset_resample,    run_resample   },
+    { "resample_nearest",   BENCH_MAX_SIZE, prepare_pcm,      reset_resample_nearest, run_resample },
+    { "resample_fast",      BENCH_MAX_SIZE, prepare_pcm,      reset_resample_fast, run_resample },
+    { "resample_best",      BENCH_MAX_SIZE, prepare_pcm,      reset_resample_best, run_resample },
+    { "interp_nearest",     BENCH_MAX_SIZE, prepare_nearest,  NULL,              run_interp     },
+    { "interp_linear",      BENCH_MAX_SIZE, prepare_linear,   NULL,              run_interp     },
+    { "interp_cubic",       BENCH_MAX_SIZE, prepare_cubic,    NULL,              run_interp     },
+    { "interp_gauss",       BENCH_MAX_SIZE, prepare_gauss,    NULL,              run_interp     },
+    { "render_nearest",     BENCH_MAX_SIZE, prepare_nearest,  NULL,              run_render     },
+    { "render_linear",      BENCH_MAX_SIZE, prepare_linear,   NULL,              run_render     },
+    { "render_cubic",       BENCH_MAX_SIZE, prepare_cubic,    NULL,              run_render     },
+    { "render_gauss",       BENCH_MAX_SIZE, prepare_gauss,    NULL,              run_render     },
+    { "sdsp_voice",         BENCH_MAX_SIZE, prepare_brr,      NULL,              run_sdsp_voice },
+    { "poly_linear",        BENCH_MAX_SIZE, prepare_linear,   NULL,              run_poly       },
+    { "poly_gauss",         BENCH_MAX_SIZE, prepare_gauss,    NULL,              run_poly       },
+    { "poly_first_note",    BENCH_MAX_SIZE, prepare_linear,   NULL,              run_poly_first_note },
+    { "audio_stats",        BENCH_MAX_SIZE, prepare_pcm,      NULL,              run_audio_stats },
+    { "pitch_detect",       10000,          prepare_pcm,      NULL,              run_pitch      },
+#ifdef SBC_BENCH_GUI
+    { "draw_wave_polygons", 10000000,       prepare_waveform, NULL,              run_waveform   },
+#endif
+};
+
+/* ---------------------------------------------------------------- driver */
+
+static void print_result(const bench_case_t *c, const char *signal, const bench_ctx_t *ctx,
+                         const int reps, const uint64_t best_ns)
+{
+    const double ns = best_ns > 0 ? (double) best_ns : 1.0;
+
+    printf("%s\n    { \"kernel\": \"%s\", \"signal\": \"%s\", \"samples\": %d, \"bytes\": %zu, "
+           "\"reps\": %d, \"ns_per_sample\": %.3f, \"mb_per_s\": %.2f }",
+           first_result ? "" : ",", c->name, signal, ctx->length, ctx->bytes,
+           reps, ns / ctx->length, (double) ctx->bytes * 1000.0 / ns);
+
+    first_result = false;
+    fflush(stdout);
+}
+
+static void run_case(const bench_case_t *c, const char *signal, bench_ctx_t *ctx, const uint64_t min_ns)
+{
+    uint64_t total_ns = 0, best_ns = UINT64_MAX;
+    int reps = 0;
+
+    if(!c->prepare(ctx))
+    {
+        fprintf(stderr, "%s/%s/%d: unable to build input\n", c->name, signal, ctx->length);
+        return;
+    }
+
+    while(reps < BENCH_MAX_REPS && (reps == 0 || total_ns < min_ns))
+    {
+        uint64_t start = 0, elapsed = 0;
+
+        if(c->reset != NULL) c->reset(ctx);
+
+        start = getMonotonicNs();
+
+        if(!c->run(ctx))
+        {
+            fprintf(stderr, "%s/%s/%d: kernel failed\n", c->name, signal, ctx->length);
+            return;
+        }
+
+        elapsed = getMonotonicNs() - start;
+
+        total_ns += elapsed;
+        if(elapsed < best_ns) best_ns = elapsed;
+
+        reps++;
+    }
+
+    print_result(c, signal, ctx, reps, best_ns);
+}
+
+static void print_usage(void)
+{
+    printf("usage: sbc_bench [options]\n\n");
+    printf("  -m <samples>  largest signal length (default %d)\n", BENCH_MAX_SIZE);
+    printf("  -k <name>     only run kernels whose name contains <name>\n");
+    printf("  -t <ms>       minimum time spent on each kernel/signal/length (default 200)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t num_cases = sizeof bench_cases / sizeof *bench_cases,
+                 num_signals = sizeof bench_signals / sizeof *bench_signals;
+
+    int max_len = BENCH_MAX_SIZE, signal_len = 0;
+    uint64_t min_ns = 200 * 1000000ULL;
+    const char *filter = NULL;
+
+    int16_t *signal = NULL;
+
+#ifdef SBC_BENCH_GUI
+    Pixel_Buffer_t screen = { NULL, SCREEN_WIDTH, SCREEN_HEIGHT, 1, false };
+#endif
+
+    for(int i = 1; i < argc; i++)
+    {
+        const bool has_val = i + 1 < argc;
+
+        if(strcmp(argv[i], "-m") == 0 && has_val) max_len = (int) strtol(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "-k") == 0 && has_val) filter = argv[++i];
+        else if(strcmp(argv[i], "-t") == 0 && has_val) min_ns = (uint64_t) strtol(argv[++i], NULL, 10) * 1000000ULL;
+        else
+        {
+            print_usage();
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if(max_len < BENCH_MIN_SIZE || max_len > BENCH_MAX_SIZE) max_len = BENCH_MAX_SIZE;
+
+    for(size_t c = 0; c < num_cases; c++)
+    {
+        if(filter != NULL && strstr(bench_cases[c].name, filter) == NULL) continue;
+        if(bench_cases[c].max_len > signal_len) signal_len = bench_cases[c].max_len;
+    }
+
+    if(signal_len > max_len) signal_len = max_len;
+
+    initSampleBuffers();
+
+#ifdef SBC_BENCH_GUI
+    if(!allocateScreen(&screen)) return 1;
+    setScreenBuffer(&screen);
+#endif
+
+    SBC_MALLOC((size_t) signal_len, sizeof *signal, signal);
+
+    printf("{\n  \"build\": \"%s\",\n  \"cores\": %d,\n  \"max_samples\": %d,\n  \"results\": [",
+#ifdef DEBUG
+           "debug",
+#else
+           "release",
+#endif
+           getNumCores(), max_len);
+
+    for(size_t s = 0; s < num_signals; s++)
+    {
+        bench_signals[s].generate(signal, signal_len);
+
+        for(size_t c = 0; c < num_cases; c++)
+        {
+            const bench_case_t *bc = &bench_cases[c];
+
+            if(filter != NULL && strstr(bc->name, filter) == NULL) continue;
+
+            for(int len = BENCH_MIN_SIZE; len <= max_len && len <= bc->max_len; len *= 10)
+            {
+                bench_ctx_t ctx;
+
+                memset(&ctx, 0, sizeof ctx);
+
+                ctx.signal = signal;
+                ctx.length = len;
+
+                ctx.src.audio.buffer = signal;
+                ctx.src.audio.length = len;
+                ctx.src.loop_end     = len;
+                ctx.src.rate         = BENCH_RATE;
+
+                run_case(bc, bench_signals[s].name, &ctx, min_ns);
+
+                SBC_FREE(ctx.out.audio.buffer);
+                SBC_FREE(ctx.file_buf);
+
+                bench_sink += ctx.sink;
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+
+    SBC_FREE(signal);
+    cleanUpAndFreeSampleEdit();
+
+#ifdef SBC_BENCH_GUI
+    freeDrawingSampleBuffer();
+    SBC_FREE(screen.buffer);
+#endif
+
+    return 0;
+}
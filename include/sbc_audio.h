@@ -3,21 +3,11 @@
 
 #include <stdatomic.h>
 #include "sbc_defs.h"
-
-typedef enum
-{
-	NEAREST = 0,
-	LINEAR  = 1,
-	CUBIC   = 2,
-	GAUSS   = 3
-} InterpolationType_t;
-
-typedef struct Interpolation
-{
-    float tmpL[4], tmpR[4];
-	
-    InterpolationType_t type;
-} Interpolation_t;
+#include "sbc_interp.h"
+#include "sbc_sdsp.h"
+#include "sbc_poly.h"
+#include "sbc_record.h"
+#include "sbc_audiostats.h"
 
 void queueAudio(void); 
 void pauseAudio(void);
@@ -26,7 +16,15 @@ bool *audioQueued(void);
 void audioPaused(void);
 void playAudio(void);
 
-_Atomic int *getSamplePos(void);
+/*
+*   notes from the keyboard, up to POLY_NUM_VOICES at once on top of the play button, each one the
+*   sample pitched from POLY_ROOT_NOTE with the current interpolation
+*/
+void queueNote(const uint8_t note);
+void releaseNote(const uint8_t note);
+bool notesPlaying(void);
+
+_Atomic int64_t *getSamplePos(void);
 
 bool initAudio(void);
 void closeAudioDevice(void);
@@ -34,9 +32,45 @@ void freeAudio(void);
 
 void setPlaybackSampleRate(const double rate);
 
+/*
+*   plays the sample back through an emulated S-DSP voice instead: encoded to BRR as it would be exported,
+*   decoded block by block at 32kHz with the 14 bit pitch register, the envelope and the Gaussian,
+*   then resampled to the device rate
+*/
+bool isSdspPreview(void);
+void setSdspPreview(const bool preview);
+
+/* the preview voice's ADSR1, ADSR2 and GAIN, full direct gain by default */
+Sdsp_Envelope_t getSdspPreviewEnvelope(void);
+void setSdspPreviewEnvelope(const Sdsp_Envelope_t env);
+
+/*
+*   records from the current input device at the output's rate, through a ring the GUI thread drains
+*   into the take with updateRecording once a frame. updateRecording returns the samples it moved, -1
+*   if the take ran out of memory. stopRecording hands the take over in samp, false if nothing was recorded
+*/
+bool startRecording(void);
+bool isRecording(void);
+int64_t updateRecording(void);
+bool stopRecording(Sample_t *samp);
+
+/* NULL when not recording */
+const Record_Take_t *getRecordingTake(void);
+
+/* milliseconds of audio between the input and the take as of the last update, and how many times the ring filled up */
+double getRecordingLatency(void);
+uint64_t getRecordingOverruns(void);
+double getRecordingSampleRate(void);
+
+/* callback timing for the output device, kept since startup or the last reset */
+void getAudioEngineStats(Audio_Stats_Snapshot_t *snap);
+void resetAudioEngineStats(void);
+
+/* appends the stats and the device they were measured on to sbc_audio.log, next to sbc.conf */
+bool dumpAudioEngineStats(void);
+
 InterpolationType_t getCurrentInterpolationType(void);
 void setInterpolationType(const InterpolationType_t interpol);
-void clearInterpolation(Interpolation_t* i);
 
 int getCurrentAudioDriver(void);
 void setAudioDriver(const int drv);
@@ -50,6 +84,20 @@ void setInputDevice(const int dev);
 int getAudioBufferSize(void);
 bool setAudioBufferSize(const int size);
 
+/*
+*   auto mode steps the buffer size up after missed deadlines and back down once there's headroom,
+*   see stepAutoBuffer, reopening the device only when nothing's playing. updateAutoBufferSize does
+*   that once a frame and is true if it changed the size. picking a size by hand turns auto off
+*/
+bool isAutoBufferSize(void);
+void setAutoBufferSize(const bool on);
+bool updateAutoBufferSize(void);
+
+/* the size auto mode last settled on for each output device, by name */
+void setDeviceBufferSize(const char *device, const int buffer_size);
+int getNumDeviceBufferSizes(void);
+const char *getDeviceBufferSize(const int i, int *buffer_size);
+
 int getDeviceSampleRate(void);
 bool setDeviceSampleRate(const int rate);
 
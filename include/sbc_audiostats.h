@@ -0,0 +1,91 @@
+#ifndef __SBC_AUDIOSTATS_H
+#define __SBC_AUDIOSTATS_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include "sbc_defs.h"
+
+/* 256, 512, 1024 and 2048 frame callbacks, the same sizes as the buffer select */
+#define AUDIO_STATS_SIZES   4
+
+/* 10% of the deadline per bin, the last for anything that missed it */
+#define AUDIO_STATS_BINS    11
+
+/*
+*   written only by the audio thread and read by the GUI thread whenever it likes, so every counter is
+*   its own atomic and none of them ever needs a lock. times are in nanoseconds, the deadline being how
+*   long the callback's frames take to play. jitter is how far each interval between callbacks is from it
+*/
+typedef struct Audio_Stats_s
+{
+    _Atomic uint64_t callbacks, intervals;
+
+    /* callbacks that took longer than their deadline to render, and ones that came 1.5 deadlines or more after the last */
+    _Atomic uint64_t overloads, late;
+
+    _Atomic uint64_t render_total, render_max, deadline;
+    _Atomic uint64_t jitter_total, jitter_max;
+
+    /* how much of the deadline each callback used, by the size of the callback */
+    _Atomic uint64_t load[AUDIO_STATS_SIZES][AUDIO_STATS_BINS];
+
+    /* when the last callback started, 0 after the device has been stopped */
+    _Atomic uint64_t last_start;
+} Audio_Stats_t;
+
+/* a plain copy of the counters, as they were at one point */
+typedef struct Audio_Stats_Snapshot_s
+{
+    uint64_t callbacks, intervals, overloads, late;
+    uint64_t render_total, render_max, deadline;
+    uint64_t jitter_total, jitter_max;
+    uint64_t load[AUDIO_STATS_SIZES][AUDIO_STATS_BINS];
+} Audio_Stats_Snapshot_t;
+
+void resetAudioStats(Audio_Stats_t *s);
+
+/* call while the device is stopped, so the gap before it starts again isn't counted as a late callback */
+void restartAudioStatsClock(Audio_Stats_t *s);
+
+/* from the audio thread, once per callback of frames that started at start and finished rendering at end */
+void recordAudioCallback(Audio_Stats_t *s, const uint64_t start, const uint64_t end, const int frames, const double rate);
+
+void getAudioStats(Audio_Stats_t *s, Audio_Stats_Snapshot_t *snap);
+
+/* which load histogram a callback of frames goes in */
+int getAudioStatsSize(const int frames);
+
+/* load histogram total for one callback size, and the bin at least pct percent of those callbacks fell under */
+uint64_t getAudioStatsLoadCount(const Audio_Stats_Snapshot_t *snap, const int size);
+int getAudioStatsLoadPercentile(const Audio_Stats_Snapshot_t *snap, const int size, const double pct);
+
+/* everything in snap as readable text */
+void writeAudioStats(FILE *f, const Audio_Stats_Snapshot_t *snap);
+
+/* callbacks at one size auto buffering waits for before it judges that size */
+#define AUTO_BUFFER_WINDOW      256
+
+/* clean windows in a row before trying the next size down, doubled each time one has to be backed out of */
+#define AUTO_BUFFER_SETTLE      8
+#define AUTO_BUFFER_MAX_SETTLE  128
+
+/*
+*   picks a callback size from the stats: up a size as soon as a window has two or more overloads or
+*   late callbacks, or its 99th percentile load reaches 80%, down a size only after settle clean windows
+*   under 40%. a smaller size that then has to be backed out of doubles settle, so it isn't retried as soon
+*/
+typedef struct Audio_Auto_Buffer_s
+{
+    /* the counters when the current window started */
+    Audio_Stats_Snapshot_t last;
+
+    int clean, settle;
+    bool stepped_down;
+} Audio_Auto_Buffer_t;
+
+void resetAutoBuffer(Audio_Auto_Buffer_t *a, const Audio_Stats_Snapshot_t *snap);
+
+/* the size, 0 to AUDIO_STATS_SIZES - 1, to use after snap, given size is the one in use now */
+int stepAutoBuffer(Audio_Auto_Buffer_t *a, const Audio_Stats_Snapshot_t *snap, const int size);
+
+#endif /* __SBC_AUDIOSTATS_H */
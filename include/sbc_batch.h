@@ -0,0 +1,14 @@
+#ifndef __SBC_BATCH_H
+#define __SBC_BATCH_H
+
+#include "sbc_defs.h"
+
+bool isBatchArg(const int argc, char *argv[]);
+
+/*
+*   headless conversion, e.g. sbc --batch -f brr -o out/ kick.wav snare.wav
+*   never touches SDL or GTK, returns the process exit code
+*/
+int runBatch(const int argc, char *argv[]);
+
+#endif /* __SBC_BATCH_H */
@@ -0,0 +1,18 @@
+#ifndef __SBC_BRR_SIMD_H
+#define __SBC_BRR_SIMD_H
+
+#include "sbc_defs.h"
+
+/*
+*   scores every shift/filter candidate of a 16 sample block in parallel lanes,
+*   returns (shift << 2 | filter) of the best candidate, or -1 if the CPU has no SIMD path
+*/
+int brrSimdBlockSearch(const int16_t *samp, const int16_t *v);
+
+/*
+*   sign-extends the 16 nibbles of a block's 8 data bytes (high nibble first) and shifts
+*   them left by shift. returns false if the CPU has no SIMD path
+*/
+bool brrSimdUnpackBlock(const uint8_t *data, const int shift, int16_t *out);
+
+#endif /* __SBC_BRR_SIMD_H */
@@ -14,6 +14,7 @@ bool mouseOverButton(const int x, const int y);
 
 Button_t* getPlayButton(void);
 Button_t* getLoopButton(void);
+Button_t* getRecButton(void);
 
 Button_t* getOptButton(void);
 
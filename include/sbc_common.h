@@ -0,0 +1,72 @@
+#ifndef __SBC_COMMON_H
+#define __SBC_COMMON_H
+
+#include <string.h>
+#include <errno.h>
+
+#include "sbc_defs.h"
+
+/* the hand-vectorised kernels, each keeps a scalar version for everything else */
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define SBC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* 
+*   how the codec and DSP code reports errors. defaults to printing to stderr,
+*   the GUI swaps in its message box once it's up
+*/
+typedef void (*ErrorHandler_t)(const char *title, const char *msg, const char *error);
+
+void setErrorHandler(const ErrorHandler_t handler);
+void reportError(const char *title, const char *msg, const char *error);
+
+bool isStringEmpty(const char *s);
+
+char *_strcasestr(const char *haystack, const char *needle);
+char *_strndup(char *str, size_t chars);
+
+void print_args(const char *format, const int size, ...);
+
+#define SBC_FREE(buffer) \
+	if(buffer != NULL) \
+	{ \
+		free((void*) buffer); \
+		buffer = NULL; \
+	} \
+	assert(buffer == NULL)
+
+#define SBC_MALLOC(size, nmemb, buffer)  \
+	errno = 0; \
+	if((buffer = malloc(size * sizeof *buffer)) == NULL) \
+	{ \
+		reportError("Memory Allocation Error!", "Error while allocation memory! ", strerror(errno)); \
+		exit(1); \
+	} \
+	assert(buffer != NULL)
+
+#define SBC_CALLOC(size, nmemb, buffer) \
+	errno = 0; \
+	if((buffer = calloc(size, nmemb)) == NULL) \
+	{ \
+		reportError("Memory Allocation Error!", "Error while allocation memory! ", strerror(errno)); \
+		exit(1); \
+	} \
+	assert(buffer != NULL)
+
+#ifdef DEBUG
+
+#define SBC_LOG(lbl, fmt,  ...)	\
+{ \
+	printf("\033[0;32m  ____SBC_LOG____: \033[0;37m %s  =  ", #lbl); \
+	print_args(#fmt, 1, __VA_ARGS__); \
+}  do {;} while(0)
+
+#define SBC_ERR(lbl, err) fprintf(stderr, "\033[0;31m  ____SBC_ERR____: \033[0;37m %s: %s\n", lbl, err)
+
+#else
+#define SBC_LOG(lbl, fmt, ...) do {;} while(0)
+#define SBC_ERR(lbl, err)  	   do {;} while(0)
+#endif
+
+#endif /* __SBC_COMMON_H */
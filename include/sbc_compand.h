@@ -0,0 +1,25 @@
+#ifndef __SBC_COMPAND_H
+#define __SBC_COMPAND_H
+
+#include "sbc_defs.h"
+
+/* 8-bit companding curves, all three share the sign bit in bit 7 */
+typedef enum
+{
+    COMPAND_LINN = 0,   /* the LM-1/LM-2 drum machine curve .bin and .eii files have always used */
+    COMPAND_ULAW,       /* ITU-T G.711 mu-law */
+    COMPAND_ALAW,       /* ITU-T G.711 A-law */
+    NUM_COMPAND_CURVES
+} CompandCurve_t;
+
+/* one table lookup per byte */
+void expandToS16(const uint8_t *in, int16_t *out, const int64_t length, const CompandCurve_t curve);
+
+/* segment lookup, same codes as the reference G.711 encoder and SBC's original LM curve math */
+void compressFromS16(const int16_t *in, uint8_t *out, const int64_t length, const CompandCurve_t curve);
+
+/* the curve .bin and .eii files are read and written with, .ul and .al files are always G.711 */
+CompandCurve_t getBinCurve(void);
+void setBinCurve(const CompandCurve_t curve);
+
+#endif /* __SBC_COMPAND_H */
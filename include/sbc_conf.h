@@ -6,5 +6,8 @@
 void loadConfig(void);
 void saveConfig(void);
 
+/* file_name in the same directory sbc.conf is saved to, to be freed by the caller */
+char *getConfFilePath(const char *file_name);
+
 #endif /* __SBC_CONF_H */
 
@@ -0,0 +1,40 @@
+#ifndef __SBC_CONVERT_H
+#define __SBC_CONVERT_H
+
+#include "sbc_defs.h"
+
+/* PCM formats found in sample files, every loader converts to int16_t through here */
+typedef enum
+{
+    SAMP_FMT_U8 = 0,
+    SAMP_FMT_S8,
+    SAMP_FMT_S16LE,
+    SAMP_FMT_S16BE,
+    SAMP_FMT_S24LE,
+    SAMP_FMT_S24BE,
+    SAMP_FMT_S32LE,
+    SAMP_FMT_S32BE,
+    SAMP_FMT_F32LE,
+    NUM_SAMP_FMTS
+} SampFormat_t;
+
+/* bytes per sample of fmt */
+int getSampFormatSize(const SampFormat_t fmt);
+
+/*
+*   converts length samples of fmt to int16_t, stride is the distance in bytes between
+*   two input samples (the frame size for interleaved files, only the samples in is pointing at are read).
+*   8-bit samples are widened by repeating the byte, formats wider than 16 bits are rounded
+*   or, with dither set, TPDF dithered to 16 bits. the dither sequence is fixed so the same
+*   input always converts to the same output
+*/
+void convertToS16(const char *in, const SampFormat_t fmt, const int stride, int16_t *out, const int64_t length, const bool dither);
+
+/*
+*   mixes the num_chan interleaved channels of in down to one in a single pass,
+*   out[i] = weights[0] * channel 0 + weights[1] * channel 1 ... of frame i. channels with
+*   a weight of 0 are never read, and a lone weight of 1.0 is the same as convertToS16
+*/
+void downmixToS16(const char *in, const SampFormat_t fmt, const int num_chan, const float *weights, int16_t *out, const int64_t length, const bool dither);
+
+#endif /* __SBC_CONVERT_H */
@@ -0,0 +1,27 @@
+#ifndef __SBC_CORE_H
+#define __SBC_CORE_H
+
+/*
+*   public header of libsbccore: file codecs, sample editing, pitch detection,
+*   interpolation, S-DSP voice emulation, the polyphonic note mixer, the recording buffers and
+*   audio callback stats, with no SDL or GTK dependency
+*/
+
+#include "sbc_common.h"
+#include "sbc_threadpool.h"
+
+#include "sbc_samp_edit.h"
+#include "sbc_resample.h"
+#include "sbc_convert.h"
+#include "sbc_compand.h"
+#include "sbc_fileload.h"
+#include "sbc_filesave.h"
+
+#include "sbc_pitch.h"
+#include "sbc_interp.h"
+#include "sbc_sdsp.h"
+#include "sbc_poly.h"
+#include "sbc_record.h"
+#include "sbc_audiostats.h"
+
+#endif /* __SBC_CORE_H */
@@ -2,7 +2,80 @@
 #define __SBC_FILE_LOAD_H
 
 #include "sbc_defs.h"
+#include "sbc_samp_edit.h"
 
-int loadFile(const char* filepath);
+typedef enum
+{
+    SAMP_FILE_ERROR = 0,
+    SAMP_FILE_WAV,
+    SAMP_FILE_AIFF,
+    SAMP_FILE_IFF,
+    SAMP_FILE_VC,
+    SAMP_FILE_BRR,
+    SAMP_FILE_MULAW,
+    SAMP_FILE_ALAW,
+    SAMP_FILE_RAW
+} SampFileType_t;
+
+/* 
+*   CLASSIC is SBC's original smoothed filter math, SDSP reproduces the SNES S-DSP
+*   bit for bit (15-bit samples, clamping, wraparound and shifts above 12)
+*/
+typedef enum
+{
+    BRR_DECODE_CLASSIC = 0,
+    BRR_DECODE_SDSP    = 1
+} BrrDecodeMode_t;
+
+/* how files with more than one channel are brought down to mono */
+typedef enum
+{
+    DOWNMIX_LEFT = 0,
+    DOWNMIX_RIGHT,
+    DOWNMIX_MID,        /* (L + R) / 2 */
+    DOWNMIX_SIDE,       /* (L - R) / 2 */
+    DOWNMIX_CHANNEL,    /* the channel set with setDownmixChannel */
+    DOWNMIX_WEIGHTED,   /* the weights set with setDownmixWeights, an even mix of every channel if there are none */
+    NUM_DOWNMIX_MODES
+} DownmixMode_t;
+
+#define DOWNMIX_MAX_WEIGHTS 32
+
+/* 
+*   decodes a file into samp without touching the edit buffer, safe to call from any thread.
+*   samp->audio.buffer is allocated on success and must be freed by the caller
+*/
+SampFileType_t readSampleFile(const char* filepath, Sample_t *samp);
+
+/* same as readSampleFile on a file already in memory, name_hint's extension picks the headerless formats */
+SampFileType_t decodeSampleBuffer(const char* file_buf, const int64_t file_len, const char* name_hint, Sample_t *samp);
+
+/* 
+*   decodes one 9 byte block into 16 samples. v holds the last two samples and is
+*   updated, start it at { 0, 0 } and carry it from block to block
+*/
+void decodeBrrBlock(const uint8_t *block, int16_t *out, int16_t *v, const BrrDecodeMode_t mode);
+
+/* the mode .brr files are loaded with */
+BrrDecodeMode_t getBrrDecodeMode(void);
+void setBrrDecodeMode(const BrrDecodeMode_t mode);
+
+/* TPDF dither 24-bit, 32-bit and float files down to 16 bits instead of rounding them */
+bool getLoadDither(void);
+void setLoadDither(const bool dither);
+
+DownmixMode_t getDownmixMode(void);
+void setDownmixMode(const DownmixMode_t mode);
+
+/* 0 based, DOWNMIX_CHANNEL reads the last channel of files that have fewer */
+int getDownmixChannel(void);
+void setDownmixChannel(const int channel);
+
+/* 
+*   one weight per channel for DOWNMIX_WEIGHTED, channels past num_weights are left out.
+*   getDownmixWeights copies up to max_weights of them and returns how many are set
+*/
+int getDownmixWeights(float *weights, const int max_weights);
+void setDownmixWeights(const float *weights, const int num_weights);
 
 #endif /* __SBC_FILE_LOAD_H */
@@ -1,6 +1,34 @@
 #ifndef __SBC_FILE_SAVE_H
 #define __SBC_FILE_SAVE_H
 
-void saveFile(const char* filepath);
+#include "sbc_defs.h"
+#include "sbc_samp_edit.h"
+
+typedef enum
+{
+    BRR_ENCODE_FAST    = 0,
+    BRR_ENCODE_QUALITY = 1
+} BrrEncodeMode_t;
+
+/* 
+*   encodes samp from its sample start onwards, the format is picked from the file extension.
+*   only reads samp, so it's safe to call from any thread
+*/
+bool writeSampleFile(const char* filepath, const Sample_t *samp, const bool bit16);
+
+/* 
+*   the complete .brr file for samp (loop header included) in a newly allocated buffer, encoded
+*   in mode, which is getBrrEncodeMode() for anything saved. returns NULL if samp is too short to encode
+*/
+uint8_t *encodeBrrBuffer(const Sample_t *samp, size_t *brr_len, const BrrEncodeMode_t mode);
+
+BrrEncodeMode_t getBrrEncodeMode(void);
+void setBrrEncodeMode(const BrrEncodeMode_t mode);
+
+int getBrrBeamWidth(void);
+void setBrrBeamWidth(const int width);
+
+int getBrrTimeBudget(void);
+void setBrrTimeBudget(const int ms);
 
 #endif
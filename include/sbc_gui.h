@@ -18,5 +18,15 @@ bool isMouseOnSlider(void);
 void handleSampleNameText(const char* samp_name);
 void handleSampleRateText(const double rate);
 void handleResampleRateText(const double rate);
+void handlePitchDetected(const double rate, const int resample);
+
+/* swaps in a resample from the RESAMPLE button once its thread has finished */
+void handleResampleDone(void);
+
+/* starts recording from the input device, or stops and makes the take the new edit buffer */
+void toggleRecording(void);
+
+/* moves whatever's been recorded since the last frame into the take and redraws it */
+void handleRecording(void);
 
 #endif /* __SBC_GUI_H */
@@ -0,0 +1,68 @@
+#ifndef __SBC_INTERP_H
+#define __SBC_INTERP_H
+
+#include "sbc_defs.h"
+
+typedef enum
+{
+	NEAREST = 0,
+	LINEAR  = 1,
+	CUBIC   = 2,
+	GAUSS   = 3
+} InterpolationType_t;
+
+typedef struct Interpolation
+{
+    float tmpL[4], tmpR[4];
+	
+    InterpolationType_t type;
+} Interpolation_t;
+
+/* writes the interpolated output at offset (0.0 .. 1.0) between tmp[2] and tmp[3] */
+void applySampleInterpolation(const Interpolation_t *i, double *outL, double *outR, const double offset);
+
+/* pushes the next input sample into the history */
+void shiftFilterCoeff(Interpolation_t *i, const float in_samp);
+
+void clearInterpolation(Interpolation_t* i);
+
+/*
+*   a playing sample's state, copied out of its Sample_t once per audio block so the render loop
+*   doesn't touch any atomics. pos and frac are a 32.32 fixed point position, stepped by step
+*/
+typedef struct Voice_s
+{
+	InterpolationType_t type;
+	int16_t hist[4];
+
+	const int16_t *buffer;
+	int64_t length, loop_start, loop_end;
+	bool looped, ended;
+
+	int64_t pos;
+	uint32_t frac;
+	uint64_t step;
+} Voice_t;
+
+/*
+*   renders up to frames mono samples (-1.0 .. 1.0) into out and returns how many were rendered
+*   before the voice ran off the end of its buffer, the rest of out is filled with silence
+*/
+typedef int (*RenderKernel_t)(Voice_t *v, float *out, const int frames);
+
+/* the kernel for one interpolation type, picked once per block rather than once per sample */
+RenderKernel_t getRenderKernel(const InterpolationType_t type);
+
+/* the fixed point step for playing samp_rate audio at out_rate, GAUSS is rounded to the S-DSP's 12 bit pitch */
+uint64_t getVoiceStep(const double samp_rate, const double out_rate, const InterpolationType_t type);
+
+/*
+*   the S-DSP's integer Gaussian on count outputs, as GAUSS playback uses it. s holds each output's four
+*   samples oldest first and row the top 8 bits of its 12 bit pitch counter fraction
+*/
+void sdspGaussian(const int16_t (*s)[4], const uint8_t *row, int16_t *out, const int count);
+
+/* silences the history and rewinds the voice, keeping its interpolation type */
+void clearVoice(Voice_t *v);
+
+#endif /* __SBC_INTERP_H */
@@ -15,6 +15,9 @@ void hideOptions(void);
 void showOptions(void);
 void repaintOptions(void);
 
+/* true every quarter second while the callback stats are showing, so they're repainted as they change */
+bool updateOptionsStats(void);
+
 bool optionsIsShowing(void);
 Button_t* getBrrButton(void);
 
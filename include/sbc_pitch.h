@@ -3,6 +3,19 @@
 
 #include "sbc_defs.h"
 
+/* 
+*   called once a rate has been detected and applied to the edit buffer,
+*   possibly from the detection thread
+*/
+typedef void (*PitchDetected_t)(const double rate, const int resample);
+
+void setPitchDetectedCallback(const PitchDetected_t callback);
 void detectCenterPitch(const int resample);
 
+/* 
+*   the rate that plays samples back at C5, autocorrelation above 1024 samples and
+*   zero-crossing below. blocking, doesn't touch the edit buffer
+*/
+double detectSampleRate(const int16_t *samples, const int length);
+
 #endif /* __SBC_PITCH_H */
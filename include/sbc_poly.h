@@ -0,0 +1,83 @@
+#ifndef __SBC_POLY_H
+#define __SBC_POLY_H
+
+#include "sbc_defs.h"
+#include "sbc_interp.h"
+
+/* as many voices as the S-DSP has */
+#define POLY_NUM_VOICES 8
+
+/* the MIDI note that plays the sample at its own rate, middle C */
+#define POLY_ROOT_NOTE  60
+
+typedef struct Poly_Voice_s
+{
+    Voice_t voice;
+
+    /* the voice's pitch against the sample's own rate */
+    double ratio;
+
+    /* gain ramps linearly by gain_step for ramp more outputs, then holds at target */
+    float gain, gain_step, target;
+    int ramp;
+
+    uint8_t note;
+    uint64_t age;
+    bool active, released;
+} Poly_Voice_t;
+
+typedef struct Poly_Mixer_s
+{
+    Poly_Voice_t voices[POLY_NUM_VOICES];
+
+    /* the sample every note plays: interpolation type, buffer, loop points and the pos renderPolyEvents starts notes from */
+    Voice_t source;
+    double samp_rate, out_rate;
+
+    /* counts key ons, so the oldest voice is the one stolen */
+    uint64_t age;
+} Poly_Mixer_t;
+
+/* a note on, or a note off if velocity is 0, at frame frames into an offline render */
+typedef struct
+{
+    int64_t frame;
+    uint8_t note, velocity;
+} Poly_Event_t;
+
+/* every voice off and silent, keeping the source */
+void resetPolyMixer(Poly_Mixer_t *m);
+
+/*
+*   points every note at source, played back from samp_rate audio at out_rate. voices that are
+*   already playing carry on from where they are, anything past the new end stops
+*/
+void setPolySource(Poly_Mixer_t *m, const Voice_t *source, const double samp_rate, const double out_rate);
+
+/* pitch ratio of note against POLY_ROOT_NOTE, equal tempered */
+double getPolyNoteRatio(const uint8_t note);
+
+/*
+*   starts note from start on a free voice, or the oldest released one, or the oldest one if they're all
+*   held. returns the voice it went to. it's silent until there's a source, so it can be keyed on before one
+*/
+int keyOnPolyNote(Poly_Mixer_t *m, const uint8_t note, const uint8_t velocity, const int64_t start);
+
+/* fades out every held voice playing note */
+void keyOffPolyNote(Poly_Mixer_t *m, const uint8_t note);
+
+/* fades out every voice */
+void keyOffPolyMixer(Poly_Mixer_t *m);
+
+bool isPolyMixerActive(const Poly_Mixer_t *m);
+
+/* adds frames outputs of every active voice into mix, returns false once none are left sounding */
+bool mixPolyVoices(Poly_Mixer_t *m, float *mix, const int frames);
+
+/*
+*   renders frames outputs of a note sequence into out, the way a MIDI file would play on the sample.
+*   events have to be in order of frame, the mixer's voices are left where the render stopped
+*/
+void renderPolyEvents(Poly_Mixer_t *m, const Poly_Event_t *events, const int num_events, float *out, const int64_t frames);
+
+#endif /* __SBC_POLY_H */
@@ -0,0 +1,66 @@
+#ifndef __SBC_RECORD_H
+#define __SBC_RECORD_H
+
+#include <stdatomic.h>
+#include "sbc_defs.h"
+#include "sbc_samp_edit.h"
+
+/* a take grows by at least this many samples at a time */
+#define RECORD_CHUNK        65536
+
+/* samples per min/max pair in a take's live waveform */
+#define RECORD_PEAK_BLOCK   256
+
+/*
+*   single producer, single consumer ring of samples: the capture callback writes, the GUI thread
+*   reads, and neither ever waits on the other. head and tail only ever count up, size is a power of 2
+*/
+typedef struct Record_Ring_s
+{
+    int16_t *data;
+    size_t size;
+
+    _Atomic size_t head, tail;
+} Record_Ring_t;
+
+/*
+*   everything recorded so far in one buffer, so it can become the edit buffer as it is. peaks holds
+*   a min and max for every RECORD_PEAK_BLOCK samples, the last one for however many have come in
+*/
+typedef struct Record_Take_s
+{
+    int16_t *buffer;
+    int64_t length, capacity;
+
+    int16_t (*peaks)[2];
+    int64_t num_peaks, peak_capacity;
+} Record_Take_t;
+
+/* a ring holding at least min_size samples */
+bool initRecordRing(Record_Ring_t *r, const size_t min_size);
+void freeRecordRing(Record_Ring_t *r);
+
+/* producer side. writes as much of in as fits and returns how much that was, anything short of count is an overrun */
+size_t writeRecordRing(Record_Ring_t *r, const int16_t *in, const size_t count);
+
+/* consumer side. reads up to max samples into out and returns how many it read */
+size_t readRecordRing(Record_Ring_t *r, int16_t *out, const size_t max);
+
+/* samples waiting to be read, exact from the consumer's side */
+size_t getRecordRingFill(Record_Ring_t *r);
+
+/* adds count samples to the end of the take, false if it couldn't grow */
+bool appendRecordTake(Record_Take_t *t, const int16_t *in, const int64_t count);
+
+/* moves everything waiting in the ring into the take, returns how many samples that was or -1 if the take couldn't grow */
+int64_t drainRecordRing(Record_Ring_t *r, Record_Take_t *t);
+
+/*
+*   hands the take's buffer over to samp at rate, trimmed to its length but not copied, ready for
+*   adoptSampleEdit. the take is left empty. false if nothing was recorded
+*/
+bool finishRecordTake(Record_Take_t *t, Sample_t *samp, const double rate);
+
+void freeRecordTake(Record_Take_t *t);
+
+#endif /* __SBC_RECORD_H */
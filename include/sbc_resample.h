@@ -0,0 +1,51 @@
+#ifndef __SBC_RESAMPLE_H
+#define __SBC_RESAMPLE_H
+
+#include "sbc_defs.h"
+#include "sbc_samp_edit.h"
+
+/*
+*   NEAREST is SBC's original decimator, aliasing and all. the others are Kaiser-windowed
+*   sinc filters, longer and steeper with each step up
+*/
+typedef enum
+{
+    RESAMPLE_NEAREST = 0,
+    RESAMPLE_FAST,
+    RESAMPLE_GOOD,
+    RESAMPLE_BEST,
+    NUM_RESAMPLE_QUALITIES
+} ResampleQuality_t;
+
+/*
+*   resamples samp to rate into a newly allocated sample, samp is left untouched. the output
+*   grid is lined up with samp_start, so the part that gets exported resamples the same as it
+*   would on its own, and the filter reads across the loop end back into the loop start
+*   so the loop stays seamless. samples before samp_start never bleed into the ones after it.
+*   long samples are split up between pool, a NULL pool resamples on the calling thread
+*/
+Sample_t *resampleSample(const Sample_t *samp, const double rate, const ResampleQuality_t quality, Thread_Pool_t *pool);
+
+/*
+*   resamples a continuous stream, e.g. the S-DSP preview's 32kHz output to the device rate. the filter bank
+*   is built by createStreamResampler, so the audio thread only ever runs it. NEAREST is treated as FAST
+*/
+typedef struct Stream_Resampler_s Stream_Resampler_t;
+
+Stream_Resampler_t *createStreamResampler(const double in_rate, const double out_rate, const ResampleQuality_t quality, const int max_frames);
+void destroyStreamResampler(Stream_Resampler_t **r);
+
+/* back to silence, the next output lines up with the next input */
+void resetStreamResampler(Stream_Resampler_t *r);
+
+/* how many new input samples the next frames outputs need, frames at most max_frames */
+int getStreamInputNeeded(const Stream_Resampler_t *r, const int frames);
+
+/* frames outputs (-1.0 .. 1.0) from in, which holds getStreamInputNeeded(r, frames) samples */
+void streamResample(Stream_Resampler_t *r, const int16_t *in, float *out, const int frames);
+
+/* the quality handleResample and batch conversion use */
+ResampleQuality_t getResampleQuality(void);
+void setResampleQuality(const ResampleQuality_t quality);
+
+#endif /* __SBC_RESAMPLE_H */
@@ -3,11 +3,15 @@
 
 #include <stdatomic.h>
 #include "sbc_defs.h"
+#include "sbc_threadpool.h"
+
+#define RESAMPLE_MIN_RATE   100
+#define RESAMPLE_MAX_RATE   384000
 
 typedef struct 
 {
     int16_t *buffer;
-    _Atomic int length;
+    _Atomic int64_t length;
 } Audio_Buffer_t;
 
 typedef struct
@@ -15,9 +19,9 @@ typedef struct
     Audio_Buffer_t audio;
 
     _Atomic bool is_looped;
-    _Atomic int loop_start;
-    _Atomic int loop_end;
-    _Atomic int samp_start;
+    _Atomic int64_t loop_start;
+    _Atomic int64_t loop_end;
+    _Atomic int64_t samp_start;
 
 	_Atomic double rate;
 	_Atomic double pos;
@@ -25,46 +29,76 @@ typedef struct
 
 void initSampleBuffers(void);
 void setSampleEdit(const Sample_t *);
+
+/* like setSampleEdit but takes samp's buffer instead of copying it, samp is left empty */
+void adoptSampleEdit(Sample_t *samp);
 void clearSampleEdit(void);
 
 void setLoopEnable(const int enable);
-void setSampStart(const int samp);
-void setLoopStart(const int samp);
-void setLoopEnd(const int samp);
+void setSampStart(const int64_t samp);
+void setLoopStart(const int64_t samp);
+void setLoopEnd(const int64_t samp);
 
 void setSampEditName(const char* name);
 
 void setUndoBuffer(void);
 bool handleUndo(void);
-void copySampleRange(const int start, const int end);
+void copySampleRange(const int64_t start, const int64_t end);
 
-bool cutAtCursor(const int index);
-bool cutSampleRange(const int start, const int end);
+bool cutAtCursor(const int64_t index);
+bool cutSampleRange(const int64_t start, const int64_t end);
 
-bool cropSampleRange(const int start, const int end);
+bool cropSampleRange(const int64_t start, const int64_t end);
 
-bool pasteAtCursor(const int index, const bool set_undo);
-bool pasteOverRange(const int start, const int end);
+bool pasteAtCursor(const int64_t index, const bool set_undo);
+bool pasteOverRange(const int64_t start, const int64_t end);
 
-bool deleteSingleSample(const int index);
-bool deleteRangeSample(const int start, const int end, const bool set_undo);
+bool deleteSingleSample(const int64_t index);
+bool deleteRangeSample(const int64_t start, const int64_t end, const bool set_undo);
 
 void setResampleRate(const double rate);
 bool handleResample(void);
 
+/*
+*   handleResample on a thread of its own, so long samples don't hold up the GUI. returns false if there's
+*   nothing to resample or one is already running. the sample is copied when it starts, and finishResample
+*   swaps the result in once resampleIsReady, with the sample it replaced left in the undo buffer. if the
+*   sample's audio was loaded, recorded or edited in the meantime the result is dropped and it returns false
+*/
+bool startResample(void);
+bool resampleIsReady(void);
+bool finishResample(void);
+
+/*
+*   resampleSample with the current resample quality, leaves samp untouched. pool is
+*   NULL from threads already in a pool of their own, e.g. batch conversion's workers
+*/
+Sample_t *createResampledSample(const Sample_t *samp, const double rate, Thread_Pool_t *pool);
+
+/*
+*   the audio thread's view of the sample. edits never touch a buffer once it's been published, they publish
+*   a new one and the old one is freed after the callback lets go of it, so playback can carry on through them.
+*   only the audio thread may acquire, and it has to release before it acquires again
+*/
+const Audio_Buffer_t *acquireSampleAudio(void);
+void releaseSampleAudio(void);
+
 char *getSampEditName(void);
 
 int16_t **getSampleEditBuffer(void);
-_Atomic int *getSampleEditLength(void);
+_Atomic int64_t *getSampleEditLength(void);
 Sample_t *getSampleEdit(void);
 
+/* goes up every time the sample's audio is replaced, loaded, recorded or edited alike */
+uint64_t getSampleEditGeneration(void);
+
 void setSampleEditSampleRate(const double rate);
 _Atomic double *getSampleEditSampleRate(void);
 
 _Atomic bool *isSampEditLoopEnabled(void);
-_Atomic int  *getSampStart(void);
-_Atomic int  *getLoopStart(void);
-_Atomic int  *getLoopEnd(void);
+_Atomic int64_t *getSampStart(void);
+_Atomic int64_t *getLoopStart(void);
+_Atomic int64_t *getLoopEnd(void);
 
 void resetSampPos(void);
 void cleanUpAndFreeSampleEdit(void);
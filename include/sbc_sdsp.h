@@ -0,0 +1,75 @@
+#ifndef __SBC_SDSP_H
+#define __SBC_SDSP_H
+
+#include "sbc_defs.h"
+
+#define SDSP_RATE       32000
+#define SDSP_NUM_VOICES 8
+
+typedef enum
+{
+    SDSP_ENV_ATTACK = 0,
+    SDSP_ENV_DECAY,
+    SDSP_ENV_SUSTAIN,
+    SDSP_ENV_RELEASE
+} SdspEnvMode_t;
+
+/* a voice's ADSR1, ADSR2 and GAIN registers, the same bytes a driver would write to the DSP */
+typedef struct
+{
+    uint8_t adsr1, adsr2, gain;
+} Sdsp_Envelope_t;
+
+typedef struct Sdsp_Voice_s
+{
+    /* BRR blocks, 9 bytes each, without the .brr file's loop header */
+    const uint8_t *brr;
+    int64_t num_blocks, loop_block, block;
+
+    /* the current block decoded, and how many of its samples have been shifted into hist */
+    int16_t decoded[16], brr_hist[2], hist[4];
+    int brr_index;
+
+    /* 14 bit pitch register, stepping a 12 bit fraction between samples */
+    uint16_t pitch, interp_pos;
+
+    int env, hidden_env;
+    SdspEnvMode_t env_mode;
+    Sdsp_Envelope_t regs;
+
+    bool active;
+} Sdsp_Voice_t;
+
+typedef struct Sdsp_s
+{
+    Sdsp_Voice_t voices[SDSP_NUM_VOICES];
+
+    /* the global rate counter every envelope steps on */
+    int counter;
+} Sdsp_t;
+
+/* the pitch register that plays samp_rate audio at its own pitch, clamped to the register's 14 bits */
+uint16_t getSdspPitch(const double samp_rate);
+
+/* every voice off and silent */
+void resetSdsp(Sdsp_t *dsp);
+
+/*
+*   starts v on a .brr file as encodeBrrBuffer makes it, loop header included if it loops.
+*   the voice only points into brr, it has to outlive the voice
+*/
+void keyOnSdspVoice(Sdsp_Voice_t *v, const uint8_t *brr, const size_t brr_len, const uint16_t pitch, const Sdsp_Envelope_t env);
+
+/* puts the envelope into release, the voice turns itself off once it's faded out */
+void keyOffSdspVoice(Sdsp_Voice_t *v);
+
+/* samples v has played so far, counting from the start of its first block */
+int64_t getSdspVoicePos(const Sdsp_Voice_t *v);
+
+/*
+*   renders frames 32kHz samples of every active voice mixed together into out, the way the S-DSP
+*   would before its main volume and echo. returns false once there are no voices left sounding
+*/
+bool renderSdsp(Sdsp_t *dsp, int16_t *out, const int frames);
+
+#endif /* __SBC_SDSP_H */
@@ -0,0 +1,27 @@
+#ifndef __SBC_THREADPOOL_H
+#define __SBC_THREADPOOL_H
+
+#include "sbc_defs.h"
+
+typedef struct Thread_Pool_s Thread_Pool_t;
+
+/* runs once for every index handed to poolParallelFor, from any thread of the pool */
+typedef void (*PoolTask_t)(void *arg, const int index, const int thread);
+
+int getNumCores(void);
+uint64_t getMonotonicMs(void);
+uint64_t getMonotonicNs(void);
+
+Thread_Pool_t *createThreadPool(const int num_threads);
+void destroyThreadPool(Thread_Pool_t **pool);
+
+int getPoolThreadCount(const Thread_Pool_t *pool);
+
+/*
+*   splits [0, count) evenly between the calling thread and the workers,
+*   idle threads steal from the back of busy threads' ranges.
+*   returns once every index has run.
+*/
+void poolParallelFor(Thread_Pool_t *pool, const PoolTask_t task, void *arg, const int count);
+
+#endif /* __SBC_THREADPOOL_H */
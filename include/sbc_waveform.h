@@ -2,6 +2,7 @@
 #define __SBC_WAVEFORM_H
 
 #include "sbc_defs.h"
+#include "sbc_record.h"
 
 void handleZoom(const bool zoom_in);
 void handleScroll(const bool scoll_left);
@@ -10,12 +11,15 @@ void resetZoom(void);
 void updateWaveform(void);
 void drawLoopWindow(void);
 
-bool allocatePoints(const int len);
+bool allocatePoints(const int64_t len);
 void freePoints(void);
 void freeDrawingSampleBuffer(void);
 
 void drawNewWave(void);
 
+/* draws take's peaks with status over them instead of the edit buffer, until called with NULL */
+void showRecordingWave(const Record_Take_t *take, const char *status);
+
 void scrollClicked(const bool clicked);
 void setScrollFactor(const int mouse_x);
 
@@ -24,11 +28,11 @@ bool paintWaveform(void);
 
 bool mouseOverScrollBar(const int x, const int y);
 
-int *getWaveStart(void);
-void setMouseFocus(const int x);
+int64_t *getWaveStart(void);
+void setMouseFocus(const int64_t x);
 
-void setCursor(const int x);
-void setSelEnd(const int x);
+void setCursor(const int64_t x);
+void setSelEnd(const int64_t x);
 
 bool  isZoomed(void);
 const Rect_t* getScrollbarBack(void);
@@ -135,7 +135,7 @@ int selectMenuHitbox(const Select_Menu_t *s, const int x, const int y);
 
 typedef struct Slider_s
 {
-        int sample;
+        int64_t sample;
         int x_pos;
 
 		SliderType_t type;
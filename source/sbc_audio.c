@@ -1,11 +1,22 @@
+#include <math.h>
+#include <time.h>
 #include <SDL2/SDL.h>
 
 #include "sbc_utils.h"
 #include "sbc_samp_edit.h"
+#include "sbc_filesave.h"
+#include "sbc_resample.h"
+#include "sbc_record.h"
+#include "sbc_audiostats.h"
+#include "sbc_conf.h"
 #include "sbc_audio.h"
 
-#define S16TOF32(x)		(float) ((x) > 0 ? ((double) (x) / 32767.) : ((double) (x) / 32768.))
 #define   CLAMPF(x)     (x) > 1.f ? 1.f : (x) < -1.f ? -1.f : (x)
+#define RENDER_BLOCK    256
+#define FRAC_SCALE      4294967296.0
+
+/* output devices auto buffering remembers a size for */
+#define AUTO_BUFFER_DEVICES 16
 
 static struct Audio_Config_s
 {
@@ -17,22 +28,191 @@ static struct Audio_Config_s
 
 	double sample_rate;
 
+	/* how long each callback takes and how regularly they come, see sbc_audiostats.h */
+	Audio_Stats_t stats;
+
+	/* 
+	*   auto mode picks buffer_size from the stats. a new size waits in auto_pending until nothing's
+	*   playing, and whatever it settles on is remembered for each output device by name
+	*/
+	bool auto_buffer_size;
+	uint16_t auto_pending;
+	Audio_Auto_Buffer_t auto_buffer;
+
+	struct Auto_Buffer_Device_s
+	{
+		char name[128];
+		uint16_t buffer_size;
+	} auto_devices[AUTO_BUFFER_DEVICES];
+
+	int num_auto_devices;
+
 } *audio_config;
 
 static struct Playback_s
 {
-	_Atomic int pos;
+	_Atomic int64_t pos;
 	float vol;
 
-	Interpolation_t interpolation;
+	/* only ever touched by the audio thread between queueAudio calls */
+	Voice_t voice;
+	double published_pos;
+
+	/* 
+	*   the S-DSP preview. brr and the voice are only swapped while the device is locked,
+	*   brr_lead is how many samples of padding the encoder put in front of brr_start.
+	*   brr is kept between plays and only encoded again once brr_key stops matching the sample
+	*/
+	bool sdsp_preview, sdsp_playing;
+	_Atomic bool sdsp_key_off;
+
+	Sdsp_t dsp;
+	Sdsp_Envelope_t sdsp_env;
+	Stream_Resampler_t *dsp_resampler;
+
+	uint8_t *brr;
+	size_t brr_len;
+	int64_t brr_start, brr_lead;
+
+	struct Preview_Key_s
+	{
+		bool valid, is_looped;
+		uint64_t generation;
+		int64_t samp_start, loop_start, loop_end;
+	} brr_key;
+
+	/* notes played from the keyboard, on top of whatever the play button started. only touched with the device locked */
+	Poly_Mixer_t poly;
+	_Atomic bool notes_sounding;
 
 	double sample_rate;
 	bool is_playing, rampVolDown;
 } *playback;
 
+/* 
+*   the capture device and the take it's recording. its callback only ever writes to the ring,
+*   the GUI thread drains it into the take once a frame
+*/
+static struct Recording_s
+{
+	SDL_AudioDeviceID input_dev;
+
+	Record_Ring_t ring;
+	Record_Take_t take;
+
+	/* callbacks that found the ring full, and how many samples they had to drop */
+	_Atomic uint64_t overruns, dropped;
+
+	double sample_rate, latency, max_latency;
+	uint16_t buffer_size;
+} *recording;
+
+/* everything encode_preview's output depends on, the loop points only count while it's looped */
+static struct Preview_Key_s get_preview_key(void)
+{
+	const Sample_t *samp = getSampleEdit();
+	struct Preview_Key_s key;
+
+	memset(&key, 0, sizeof key);
+
+	key.valid      = true;
+	key.is_looped  = samp->is_looped;
+	key.generation = getSampleEditGeneration();
+	key.samp_start = samp->samp_start;
+
+	if(key.is_looped)
+	{
+		key.loop_start = samp->loop_start;
+		key.loop_end   = samp->loop_end;
+	}
+
+	return key;
+}
+
+static bool same_preview_key(const struct Preview_Key_s *a, const struct Preview_Key_s *b)
+{
+	return a->valid && b->valid && a->is_looped == b->is_looped && a->generation == b->generation &&
+		a->samp_start == b->samp_start && a->loop_start == b->loop_start && a->loop_end == b->loop_end;
+}
+
+/*
+*   the sample from its start onwards, encoded the way a fast export would, so it never waits
+*   on the quality encoder. NULL if it's too short to encode
+*/
+static uint8_t *encode_preview(size_t *brr_len, int64_t *lead)
+{
+	const Sample_t *samp = getSampleEdit();
+	const int64_t start = samp->samp_start;
+
+	Sample_t samp_export;
+	uint8_t *brr = NULL;
+
+	if(samp->audio.buffer == NULL || samp->audio.length - start <= 1) return NULL;
+
+	memset(&samp_export, 0, sizeof samp_export);
+
+	samp_export.audio.buffer = samp->audio.buffer + start;
+	samp_export.audio.length = samp->audio.length - start;
+
+	samp_export.rate       = samp->rate;
+	samp_export.is_looped  = samp->is_looped;
+	samp_export.loop_end   = samp->loop_end   - start;
+	samp_export.loop_start = samp->loop_start - start;
+
+	if((brr = encodeBrrBuffer(&samp_export, brr_len, BRR_ENCODE_FAST)) == NULL) return NULL;
+
+	/* the encoder pads the front out to whole blocks */
+	*lead = (int64_t) (*brr_len / 9) * 16 - (samp_export.is_looped ? samp_export.loop_end : samp_export.audio.length);
+
+	return brr;
+}
+
 void queueAudio(void) 
 { 
-	clearInterpolation(&playback->interpolation);
+	const struct Preview_Key_s key = get_preview_key();
+
+	uint8_t *brr = NULL;
+	size_t brr_len = 0;
+	int64_t brr_lead = 0;
+	bool encoded = false;
+
+	/* encoding can take a while, so it's only redone after an edit and before the callback is locked out */
+	if(playback->sdsp_preview && !same_preview_key(&key, &playback->brr_key))
+	{
+		brr = encode_preview(&brr_len, &brr_lead);
+		encoded = true;
+	}
+
+	SDL_LockAudioDevice(audio_config->output_dev);
+
+	clearVoice(&playback->voice);
+
+	/* a position the sample can't be at, so the next block reloads it */
+	playback->published_pos = -1.0;
+
+	/* the callback can't be holding the old brr any more, it's freed once the device is unlocked */
+	if(encoded)
+	{
+		uint8_t *old_brr = playback->brr;
+
+		playback->brr = brr;
+		playback->brr_len = brr_len;
+		playback->brr_lead = brr_lead;
+		playback->brr_start = key.samp_start;
+		playback->brr_key = key;
+
+		brr = old_brr;
+	}
+
+	if((playback->sdsp_playing = playback->sdsp_preview && playback->brr != NULL))
+	{
+		resetSdsp(&playback->dsp);
+		keyOnSdspVoice(&playback->dsp.voices[0], playback->brr, playback->brr_len, getSdspPitch(*getSampleEditSampleRate()), playback->sdsp_env);
+
+		if(playback->dsp_resampler != NULL) resetStreamResampler(playback->dsp_resampler);
+	}
+
+	playback->sdsp_key_off = false;
 
 	playback->pos = *getSampStart();
 	resetSampPos();
@@ -41,22 +221,68 @@ void queueAudio(void)
 	playback->rampVolDown = false; 
 	playback->vol = 1.0f; 
 
+	SDL_UnlockAudioDevice(audio_config->output_dev);
+
+	SBC_FREE(brr);
+
 	SBC_LOG(AUDIO PLAING, %s, "TRUE");
 }
 
-void pauseAudio(void) { SBC_LOG(AUDIO PLAING, %s, "FALSE"); playback->rampVolDown = true; }
+void pauseAudio(void) 
+{ 
+	SBC_LOG(AUDIO PLAING, %s, "FALSE"); 
+
+	playback->sdsp_key_off = true;
+	playback->rampVolDown = true; 
+}
 
 bool *audioQueued(void) { return &playback->is_playing; }
 
 void audioPaused(void)
 {
 	SDL_PauseAudioDevice(audio_config->output_dev, SDL_TRUE);
-	SDL_UnlockAudioDevice(audio_config->output_dev);
+	restartAudioStatsClock(&audio_config->stats);
 
 	if(playback->is_playing)
 		playback->is_playing = false;
+
+	/* the keys' releases can get lost behind a dialog, so held notes are cut rather than left hanging */
+	if(playback->notes_sounding)
+	{
+		SDL_LockAudioDevice(audio_config->output_dev);
+
+		resetPolyMixer(&playback->poly);
+		playback->notes_sounding = false;
+
+		SDL_UnlockAudioDevice(audio_config->output_dev);
+	}
 }
 
+void queueNote(const uint8_t note)
+{
+	if(audio_config->output_dev == 0) return;
+
+	SDL_LockAudioDevice(audio_config->output_dev);
+
+	keyOnPolyNote(&playback->poly, note, 127, getSampleEdit()->samp_start);
+	playback->notes_sounding = true;
+
+	SDL_UnlockAudioDevice(audio_config->output_dev);
+
+	playAudio();
+}
+
+void releaseNote(const uint8_t note)
+{
+	if(audio_config->output_dev == 0) return;
+
+	SDL_LockAudioDevice(audio_config->output_dev);
+	keyOffPolyNote(&playback->poly, note);
+	SDL_UnlockAudioDevice(audio_config->output_dev);
+}
+
+bool notesPlaying(void) { return playback->notes_sounding; }
+
 void playAudio(void)
 {
 	if(audio_config->output_dev == 0) return;
@@ -65,283 +291,317 @@ void playAudio(void)
 
 	SDL_PauseAudioDevice(audio_config->output_dev, SDL_FALSE);
 
-	SDL_LockAudioDevice(audio_config->output_dev);
+	/* both are atomics and the callback only reads published snapshots, so there's no need to lock it out */
+	if(playback->pos > *getSampleEditLength()) playback->is_playing = false;
 
-	if(playback->pos > *getSampleEditLength())
+	if(!playback->is_playing && !playback->notes_sounding) 
 	{
 		SDL_PauseAudioDevice(audio_config->output_dev, SDL_TRUE);
-
-		playback->is_playing = false;
+		restartAudioStatsClock(&audio_config->stats);
 	}
-
-	SDL_UnlockAudioDevice(audio_config->output_dev);
 }
 
-_Atomic int *getSamplePos(void) { return &playback->pos; }
-
-/*
- * S-DSP Gaussian interpolation lookup table translated for 16-bit PCM audio
- * courtesy of 8bitbubsy, adapted from blargg's SPC lookup table
- */
-static const double fSpc700Gaussian[4 * 256] =
-{
-	0.180664, 0.637207, 0.182617, 0.000000, 0.178711, 0.637207, 0.184570, 0.000000,
-	0.176758, 0.636719, 0.186035, 0.000000, 0.174805, 0.636719, 0.187988, 0.000000,
-	0.172852, 0.636719, 0.189941, 0.000000, 0.171387, 0.636719, 0.191895, 0.000000,
-	0.169434, 0.636719, 0.193848, 0.000000, 0.167480, 0.636230, 0.195801, 0.000000,
-	0.165527, 0.636230, 0.197754, 0.000000, 0.164062, 0.636230, 0.200195, 0.000000,
-	0.162109, 0.635742, 0.202148, 0.000000, 0.160156, 0.635742, 0.204102, 0.000000,
-	0.158691, 0.635254, 0.206055, 0.000000, 0.156738, 0.634766, 0.208008, 0.000000,
-	0.155273, 0.634766, 0.209961, 0.000000, 0.153320, 0.634277, 0.211914, 0.000000,
-	0.151855, 0.633789, 0.214355, 0.000488, 0.149902, 0.633301, 0.216309, 0.000488,
-	0.148438, 0.633301, 0.218262, 0.000488, 0.146484, 0.632812, 0.220215, 0.000488,
-	0.145020, 0.632324, 0.222656, 0.000488, 0.143066, 0.631836, 0.224609, 0.000488,
-	0.141602, 0.631348, 0.226562, 0.000488, 0.139648, 0.630859, 0.229004, 0.000488,
-	0.138184, 0.630371, 0.230957, 0.000488, 0.136719, 0.629883, 0.232910, 0.000488,
-	0.134766, 0.628906, 0.235352, 0.000488, 0.133301, 0.628418, 0.237305, 0.000977,
-	0.131836, 0.627930, 0.239746, 0.000977, 0.130371, 0.626953, 0.241699, 0.000977,
-	0.128418, 0.626465, 0.243652, 0.000977, 0.126953, 0.625977, 0.246094, 0.000977,
-	0.125488, 0.625000, 0.248047, 0.000977, 0.124023, 0.624512, 0.250488, 0.000977,
-	0.122559, 0.623535, 0.252441, 0.001465, 0.121094, 0.622559, 0.254883, 0.001465,
-	0.119629, 0.622070, 0.257324, 0.001465, 0.118164, 0.621094, 0.259277, 0.001465,
-	0.116699, 0.620117, 0.261719, 0.001465, 0.115234, 0.619629, 0.263672, 0.001953,
-	0.113770, 0.618652, 0.266113, 0.001953, 0.112305, 0.617676, 0.268555, 0.001953,
-	0.110840, 0.616699, 0.270508, 0.001953, 0.109375, 0.615723, 0.272949, 0.001953,
-	0.107910, 0.614746, 0.274902, 0.002441, 0.106445, 0.613770, 0.277344, 0.002441,
-	0.104980, 0.612793, 0.279785, 0.002441, 0.103516, 0.611816, 0.281738, 0.002441,
-	0.102539, 0.610840, 0.284180, 0.002930, 0.101074, 0.609375, 0.286621, 0.002930,
-	0.099609, 0.608398, 0.289062, 0.002930, 0.098145, 0.607422, 0.291016, 0.002930,
-	0.097168, 0.605957, 0.293457, 0.003418, 0.095703, 0.604980, 0.295898, 0.003418,
-	0.094238, 0.604004, 0.298340, 0.003418, 0.093262, 0.602539, 0.300293, 0.003906,
-	0.091797, 0.601562, 0.302734, 0.003906, 0.090820, 0.600098, 0.305176, 0.003906,
-	0.089355, 0.599121, 0.307617, 0.004395, 0.087891, 0.597656, 0.310059, 0.004395,
-	0.086914, 0.596191, 0.312500, 0.004395, 0.085449, 0.595215, 0.314453, 0.004883,
-	0.084473, 0.593750, 0.316895, 0.004883, 0.083496, 0.592285, 0.319336, 0.004883,
-	0.082031, 0.590820, 0.321777, 0.005371, 0.081055, 0.589355, 0.324219, 0.005371,
-	0.079590, 0.588379, 0.326660, 0.005371, 0.078613, 0.586914, 0.329102, 0.005859,
-	0.077637, 0.585449, 0.331055, 0.005859, 0.076172, 0.583984, 0.333496, 0.006348,
-	0.075195, 0.582520, 0.335938, 0.006348, 0.074219, 0.581055, 0.338379, 0.006836,
-	0.073242, 0.579102, 0.340820, 0.006836, 0.071777, 0.577637, 0.343262, 0.007324,
-	0.070801, 0.576172, 0.345703, 0.007324, 0.069824, 0.574707, 0.348145, 0.007324,
-	0.068848, 0.573242, 0.350586, 0.007812, 0.067871, 0.571289, 0.353027, 0.007812,
-	0.066895, 0.569824, 0.355469, 0.008301, 0.065430, 0.568359, 0.357422, 0.008301,
-	0.064453, 0.566406, 0.359863, 0.008789, 0.063477, 0.564941, 0.362305, 0.009277,
-	0.062500, 0.562988, 0.364746, 0.009277, 0.061523, 0.561523, 0.367188, 0.009766,
-	0.060547, 0.559570, 0.369629, 0.009766, 0.059570, 0.558105, 0.372070, 0.010254,
-	0.058594, 0.556152, 0.374512, 0.010254, 0.057617, 0.554688, 0.376953, 0.010742,
-	0.057129, 0.552734, 0.379395, 0.011230, 0.056152, 0.550781, 0.381836, 0.011230,
-	0.055176, 0.549316, 0.384277, 0.011719, 0.054199, 0.547363, 0.386719, 0.011719,
-	0.053223, 0.545410, 0.389160, 0.012207, 0.052246, 0.543457, 0.391602, 0.012695,
-	0.051758, 0.541504, 0.393555, 0.013184, 0.050781, 0.540039, 0.395996, 0.013184,
-	0.049805, 0.538086, 0.398438, 0.013672, 0.048828, 0.536133, 0.400879, 0.014160,
-	0.048340, 0.534180, 0.403320, 0.014160, 0.047363, 0.532227, 0.405762, 0.014648,
-	0.046387, 0.530273, 0.408203, 0.015137, 0.045898, 0.528320, 0.410645, 0.015625,
-	0.044922, 0.526367, 0.413086, 0.015625, 0.043945, 0.524414, 0.415527, 0.016113,
-	0.043457, 0.522461, 0.417480, 0.016602, 0.042480, 0.520508, 0.419922, 0.017090,
-	0.041992, 0.518066, 0.422363, 0.017578, 0.041016, 0.516113, 0.424805, 0.017578,
-	0.040527, 0.514160, 0.427246, 0.018066, 0.039551, 0.512207, 0.429688, 0.018555,
-	0.039062, 0.510254, 0.431641, 0.019043, 0.038086, 0.507812, 0.434082, 0.019531,
-	0.037598, 0.505859, 0.436523, 0.020020, 0.037109, 0.503906, 0.438965, 0.020508,
-	0.036133, 0.501465, 0.441406, 0.020996, 0.035645, 0.499512, 0.443359, 0.021484,
-	0.034668, 0.497559, 0.445801, 0.021973, 0.034180, 0.495117, 0.448242, 0.022461,
-	0.033691, 0.493164, 0.450684, 0.022949, 0.032715, 0.490723, 0.452637, 0.023438,
-	0.032227, 0.488770, 0.455078, 0.023926, 0.031738, 0.486816, 0.457520, 0.024414,
-	0.031250, 0.484375, 0.459473, 0.024902, 0.030273, 0.482422, 0.461914, 0.025391,
-	0.029785, 0.479980, 0.464355, 0.025879, 0.029297, 0.477539, 0.466309, 0.026367,
-	0.028809, 0.475586, 0.468750, 0.026855, 0.028320, 0.473145, 0.471191, 0.027344,
-	0.027344, 0.471191, 0.473145, 0.028320, 0.026855, 0.468750, 0.475586, 0.028809,
-	0.026367, 0.466309, 0.477539, 0.029297, 0.025879, 0.464355, 0.479980, 0.029785,
-	0.025391, 0.461914, 0.482422, 0.030273, 0.024902, 0.459473, 0.484375, 0.031250,
-	0.024414, 0.457520, 0.486816, 0.031738, 0.023926, 0.455078, 0.488770, 0.032227,
-	0.023438, 0.452637, 0.490723, 0.032715, 0.022949, 0.450684, 0.493164, 0.033691,
-	0.022461, 0.448242, 0.495117, 0.034180, 0.021973, 0.445801, 0.497559, 0.034668,
-	0.021484, 0.443359, 0.499512, 0.035645, 0.020996, 0.441406, 0.501465, 0.036133,
-	0.020508, 0.438965, 0.503906, 0.037109, 0.020020, 0.436523, 0.505859, 0.037598,
-	0.019531, 0.434082, 0.507812, 0.038086, 0.019043, 0.431641, 0.510254, 0.039062,
-	0.018555, 0.429688, 0.512207, 0.039551, 0.018066, 0.427246, 0.514160, 0.040527,
-	0.017578, 0.424805, 0.516113, 0.041016, 0.017578, 0.422363, 0.518066, 0.041992,
-	0.017090, 0.419922, 0.520508, 0.042480, 0.016602, 0.417480, 0.522461, 0.043457,
-	0.016113, 0.415527, 0.524414, 0.043945, 0.015625, 0.413086, 0.526367, 0.044922,
-	0.015625, 0.410645, 0.528320, 0.045898, 0.015137, 0.408203, 0.530273, 0.046387,
-	0.014648, 0.405762, 0.532227, 0.047363, 0.014160, 0.403320, 0.534180, 0.048340,
-	0.014160, 0.400879, 0.536133, 0.048828, 0.013672, 0.398438, 0.538086, 0.049805,
-	0.013184, 0.395996, 0.540039, 0.050781, 0.013184, 0.393555, 0.541504, 0.051758,
-	0.012695, 0.391602, 0.543457, 0.052246, 0.012207, 0.389160, 0.545410, 0.053223,
-	0.011719, 0.386719, 0.547363, 0.054199, 0.011719, 0.384277, 0.549316, 0.055176,
-	0.011230, 0.381836, 0.550781, 0.056152, 0.011230, 0.379395, 0.552734, 0.057129,
-	0.010742, 0.376953, 0.554688, 0.057617, 0.010254, 0.374512, 0.556152, 0.058594,
-	0.010254, 0.372070, 0.558105, 0.059570, 0.009766, 0.369629, 0.559570, 0.060547,
-	0.009766, 0.367188, 0.561523, 0.061523, 0.009277, 0.364746, 0.562988, 0.062500,
-	0.009277, 0.362305, 0.564941, 0.063477, 0.008789, 0.359863, 0.566406, 0.064453,
-	0.008301, 0.357422, 0.568359, 0.065430, 0.008301, 0.355469, 0.569824, 0.066895,
-	0.007812, 0.353027, 0.571289, 0.067871, 0.007812, 0.350586, 0.573242, 0.068848,
-	0.007324, 0.348145, 0.574707, 0.069824, 0.007324, 0.345703, 0.576172, 0.070801,
-	0.007324, 0.343262, 0.577637, 0.071777, 0.006836, 0.340820, 0.579102, 0.073242,
-	0.006836, 0.338379, 0.581055, 0.074219, 0.006348, 0.335938, 0.582520, 0.075195,
-	0.006348, 0.333496, 0.583984, 0.076172, 0.005859, 0.331055, 0.585449, 0.077637,
-	0.005859, 0.329102, 0.586914, 0.078613, 0.005371, 0.326660, 0.588379, 0.079590,
-	0.005371, 0.324219, 0.589355, 0.081055, 0.005371, 0.321777, 0.590820, 0.082031,
-	0.004883, 0.319336, 0.592285, 0.083496, 0.004883, 0.316895, 0.593750, 0.084473,
-	0.004883, 0.314453, 0.595215, 0.085449, 0.004395, 0.312500, 0.596191, 0.086914,
-	0.004395, 0.310059, 0.597656, 0.087891, 0.004395, 0.307617, 0.599121, 0.089355,
-	0.003906, 0.305176, 0.600098, 0.090820, 0.003906, 0.302734, 0.601562, 0.091797,
-	0.003906, 0.300293, 0.602539, 0.093262, 0.003418, 0.298340, 0.604004, 0.094238,
-	0.003418, 0.295898, 0.604980, 0.095703, 0.003418, 0.293457, 0.605957, 0.097168,
-	0.002930, 0.291016, 0.607422, 0.098145, 0.002930, 0.289062, 0.608398, 0.099609,
-	0.002930, 0.286621, 0.609375, 0.101074, 0.002930, 0.284180, 0.610840, 0.102539,
-	0.002441, 0.281738, 0.611816, 0.103516, 0.002441, 0.279785, 0.612793, 0.104980,
-	0.002441, 0.277344, 0.613770, 0.106445, 0.002441, 0.274902, 0.614746, 0.107910,
-	0.001953, 0.272949, 0.615723, 0.109375, 0.001953, 0.270508, 0.616699, 0.110840,
-	0.001953, 0.268555, 0.617676, 0.112305, 0.001953, 0.266113, 0.618652, 0.113770,
-	0.001953, 0.263672, 0.619629, 0.115234, 0.001465, 0.261719, 0.620117, 0.116699,
-	0.001465, 0.259277, 0.621094, 0.118164, 0.001465, 0.257324, 0.622070, 0.119629,
-	0.001465, 0.254883, 0.622559, 0.121094, 0.001465, 0.252441, 0.623535, 0.122559,
-	0.000977, 0.250488, 0.624512, 0.124023, 0.000977, 0.248047, 0.625000, 0.125488,
-	0.000977, 0.246094, 0.625977, 0.126953, 0.000977, 0.243652, 0.626465, 0.128418,
-	0.000977, 0.241699, 0.626953, 0.130371, 0.000977, 0.239746, 0.627930, 0.131836,
-	0.000977, 0.237305, 0.628418, 0.133301, 0.000488, 0.235352, 0.628906, 0.134766,
-	0.000488, 0.232910, 0.629883, 0.136719, 0.000488, 0.230957, 0.630371, 0.138184,
-	0.000488, 0.229004, 0.630859, 0.139648, 0.000488, 0.226562, 0.631348, 0.141602,
-	0.000488, 0.224609, 0.631836, 0.143066, 0.000488, 0.222656, 0.632324, 0.145020,
-	0.000488, 0.220215, 0.632812, 0.146484, 0.000488, 0.218262, 0.633301, 0.148438,
-	0.000488, 0.216309, 0.633301, 0.149902, 0.000488, 0.214355, 0.633789, 0.151855,
-	0.000000, 0.211914, 0.634277, 0.153320, 0.000000, 0.209961, 0.634766, 0.155273,
-	0.000000, 0.208008, 0.634766, 0.156738, 0.000000, 0.206055, 0.635254, 0.158691,
-	0.000000, 0.204102, 0.635742, 0.160156, 0.000000, 0.202148, 0.635742, 0.162109,
-	0.000000, 0.200195, 0.636230, 0.164062, 0.000000, 0.197754, 0.636230, 0.165527,
-	0.000000, 0.195801, 0.636230, 0.167480, 0.000000, 0.193848, 0.636719, 0.169434,
-	0.000000, 0.191895, 0.636719, 0.171387, 0.000000, 0.189941, 0.636719, 0.172852,
-	0.000000, 0.187988, 0.636719, 0.174805, 0.000000, 0.186035, 0.636719, 0.176758,
-	0.000000, 0.184570, 0.637207, 0.178711, 0.000000, 0.182617, 0.637207, 0.180664
-};
+_Atomic int64_t *getSamplePos(void) { return &playback->pos; }
 
 /* 
-*  Input samples are 16-bit signed PCM.
-*  offset is the fractional sampling position (0.0 .. 0.999inf).
-*  Output is -32768.0 .. 32767.0f.
+*   reads the sample's atomics once for the whole callback, the position only if someone else moved it.
+*   an edit publishes its buffer before it moves the loop points, so they're kept inside this one
 */
-static inline double getGaussianInterpolation(const double s0, const double s1, const double s2, const double s3, const double offset)
+static void load_voice(Voice_t *v, const Sample_t *s, const Audio_Buffer_t *audio)
 {
-	const int32_t frac256 = (int32_t) (offset * 256.0f);
-	const double *t = &fSpc700Gaussian[frac256 << 2];
+	const double pos = s->pos;
+	const int64_t loop_start = s->loop_start, loop_end = s->loop_end;
+
+	v->buffer     = audio->buffer;
+	v->length     = audio->length;
+	v->loop_end   = loop_end < v->length ? loop_end : v->length;
+	v->loop_start = loop_start < v->loop_end ? loop_start : v->loop_end;
+	v->looped     = s->is_looped;
+	v->step       = getVoiceStep(playback->sample_rate, audio_config->sample_rate, v->type);
 
-	return ((s0 * t[0]) + (s1 * t[1]) + (s2 * t[2]) + (s3 * t[3]));
+	if(pos != playback->published_pos)
+	{
+		v->pos   = (int64_t) floor(pos);
+		v->frac  = (uint32_t) ((pos - floor(pos)) * FRAC_SCALE);
+		v->ended = false;
+	}
 }
 
-static inline double getCubicInterpolation(const double s0, const double s1, const double s2, const double s3, const double offset)
+static void publish_voice(const Voice_t *v, Sample_t *s)
 {
-	const double a = (3. * (s1 - s2) - s0 + s3) / 2.,
-				 b = 2. * s2 + s0 - (5. * s1 + s3) / 2.,
-				 c = (s2 - s0) / 2.;
+	playback->published_pos = (double) v->pos + (double) v->frac / FRAC_SCALE;
 
-	return (((a * offset) + b) * offset + c) * offset + s1;
+	s->pos = playback->published_pos;
+	playback->pos = v->pos;
 }
 
-static inline double getLinearInterpolations(const double s2, const double s3, const double offset)
+/* notes play the same snapshot and loop as the play button, each from where queueNote started it */
+static void load_notes(const Sample_t *s, const Audio_Buffer_t *audio)
 {
-	return s2 + (offset * (s3 - s2));
+	Voice_t source = playback->voice;
+
+	load_voice(&source, s, audio);
+
+	setPolySource(&playback->poly, &source, playback->sample_rate, audio_config->sample_rate);
 }
 
-static void applySampleInterpolation(const Interpolation_t *i, double *outL, double *outR, const double offset)
+/* the play button's output, faded out after a pause */
+static void apply_volume(float *block, const int frames)
 {
-	switch(i->type)
+	for(int i = 0; i < frames; i++)
 	{
-		case NEAREST:
-
-			*outL = i->tmpL[3];
-			*outR = i->tmpL[3];
+		block[i] *= playback->vol;
 
-			break;
+		if(playback->rampVolDown) playback->vol *= 0.999f;
+	}
+}
 
-		case LINEAR:
+/* mono source, every channel gets the same sample */
+static float *write_block(float *out, const float *block, const int frames, const int num_channels)
+{
+	for(int i = 0; i < frames; i++)
+	{
+		const float samp = CLAMPF(block[i]);
 
-			*outL = getLinearInterpolations(i->tmpL[2], i->tmpL[3], offset);
-			*outR = getLinearInterpolations(i->tmpR[2], i->tmpR[3], offset);
+		for(int c = 0; c < num_channels; c++) *out++ = samp;
+	}
 
-			break;
+	return out;
+}
 
-		case CUBIC:
+/* the S-DSP runs at its own 32kHz, and is only resampled if the device isn't running at that too */
+static bool render_sdsp(float *block, const int frames)
+{
+	int16_t dsp_out[RENDER_BLOCK * 4];
+	bool sounding = true;
 
-			*outL = getCubicInterpolation(i->tmpL[0], i->tmpL[1], i->tmpL[2], i->tmpL[3], offset);
-			*outR = getCubicInterpolation(i->tmpR[0], i->tmpR[1], i->tmpR[2], i->tmpR[3], offset);
+	if(playback->dsp_resampler == NULL)
+	{
+		sounding = renderSdsp(&playback->dsp, dsp_out, frames);
 
-			break;
+		for(int i = 0; i < frames; i++) block[i] = (float) dsp_out[i] * (1.f / 32768.f);
+	}
+	else
+	{
+		const int need = getStreamInputNeeded(playback->dsp_resampler, frames);
 
-		case GAUSS:
-                        
-			*outL = getGaussianInterpolation(i->tmpL[0], i->tmpL[1], i->tmpL[2], i->tmpL[3], offset);
-			*outR = getGaussianInterpolation(i->tmpR[0], i->tmpR[1], i->tmpR[2], i->tmpR[3], offset);
+		assert(need <= RENDER_BLOCK * 4);
 
-			break;
+		sounding = renderSdsp(&playback->dsp, dsp_out, need);
+		streamResample(playback->dsp_resampler, dsp_out, block, frames);
 	}
+
+	return sounding;
 }
 
-static void shiftFilterCoeff(Interpolation_t *i, const float in_samp)
+static void publish_sdsp(void)
 {
-	i->tmpL[0] = i->tmpL[1];
-	i->tmpL[1] = i->tmpL[2];
-	i->tmpL[2] = i->tmpL[3];
-	i->tmpL[3] = in_samp;
-	
-	i->tmpR[0] = i->tmpR[1];
-	i->tmpR[1] = i->tmpR[2];
-	i->tmpR[2] = i->tmpR[3];
-	i->tmpR[3] = in_samp;
+	const int64_t pos = getSdspVoicePos(&playback->dsp.voices[0]) - playback->brr_lead;
+
+	playback->pos = playback->brr_start + (pos > 0 ? pos : 0);
 }
 
-static void incrementSample(Interpolation_t* i, Sample_t* s, float *bufL, float *bufR, const double sampleRate)
+/* the performance counter in nanoseconds, split so a fast counter can't overflow the multiply */
+static uint64_t stats_clock(void)
 {
-	const int pos = (int) floor(s->pos);
+	const uint64_t count = SDL_GetPerformanceCounter(), freq = SDL_GetPerformanceFrequency();
 
-	const double deltaRate = sampleRate / (audio_config->sample_rate);
-	const double offset = s->pos - (double) pos;
+	return count / freq * 1000000000ull + count % freq * 1000000000ull / freq;
+}
 
-	double outL = 0.0, outR = 0.0;
+static void SDLCALL audioCallback(void *data, uint8_t *stream, int len)
+{
+	const uint64_t start = stats_clock();
+
+	float *out = (float*) stream, block[RENDER_BLOCK];
 
-	applySampleInterpolation(i, &outL, &outR, offset);
+	const int num_channels = audio_config->num_channels, 
+	          callback_frames = len / (int) (num_channels * sizeof *out);
+	int frames = callback_frames;
 
-	s->pos += deltaRate;
+	Voice_t *v = &playback->voice;
+	Sample_t *s = getSampleEdit();
+	const RenderKernel_t render = getRenderKernel(v->type);
+	const Audio_Buffer_t *audio = NULL;
 
-	if((int) floor(s->pos) > s->audio.length)
+	/* the S-DSP preview plays its own BRR copy, only the interpolated voice and the notes need the sample */
+	const bool sdsp = playback->is_playing && playback->sdsp_playing;
+	bool voice = playback->is_playing && !sdsp, notes = playback->notes_sounding, sdsp_sounding = true;
+
+	(void) data;
+
+	if(voice || notes)
 	{
-		*bufL = *bufR = playback->is_playing = 0;
-		return;
+		audio = acquireSampleAudio();
+
+		if(audio == NULL || audio->buffer == NULL)
+		{
+			if(voice) playback->is_playing = false;
+			if(notes) resetPolyMixer(&playback->poly);
+
+			voice = notes = false;
+		}
+	}
+
+	if(voice) load_voice(v, s, audio);
+	if(notes) load_notes(s, audio);
+
+	if(sdsp && atomic_exchange(&playback->sdsp_key_off, false))
+	{
+		for(int i = 0; i < SDSP_NUM_VOICES; i++) keyOffSdspVoice(&playback->dsp.voices[i]);
+	}
+
+	while(frames > 0)
+	{
+		const int n = frames < RENDER_BLOCK ? frames : RENDER_BLOCK;
+
+		if(sdsp) sdsp_sounding = render_sdsp(block, n);
+		else if(voice) render(v, block, n);
+		else memset(block, 0, (size_t) n * sizeof *block);
+
+		if(sdsp || voice) apply_volume(block, n);
+		if(notes) notes = mixPolyVoices(&playback->poly, block, n);
+
+		out = write_block(out, block, n, num_channels);
+		frames -= n;
 	}
 
-	if((int) floor(s->pos) > pos) shiftFilterCoeff(i, (float) s->audio.buffer[pos]);
+	if(voice) publish_voice(v, s);
+	if(sdsp) publish_sdsp();
 
-	if(s->is_looped && s->pos > (double) s->loop_end)
-		s->pos = (double) s->loop_start;
+	if(audio != NULL) releaseSampleAudio();
 
-	*bufL = S16TOF32(outL);
-	*bufR = S16TOF32(outR);
+	playback->notes_sounding = notes;
+
+	if((voice && v->ended) || (sdsp && !sdsp_sounding)) playback->is_playing = false;
+	if(playback->vol <= 0.001f) playback->is_playing = false;
+
+	recordAudioCallback(&audio_config->stats, start, stats_clock(), callback_frames, audio_config->sample_rate);
 }
 
-static void SDLCALL audioCallback(void *data, uint8_t *stream, int len)
+/* from the capture thread, so it only ever writes into the ring and counts what didn't fit */
+static void SDLCALL captureCallback(void *data, uint8_t *stream, int len)
 {
-	float *out = (float*) stream;
-
-	const int BYTES_PER_SAMPLE = audio_config->num_channels * sizeof *out;
-	int numSamples = len / BYTES_PER_SAMPLE;
+	const size_t count = (size_t) len / sizeof(int16_t),
+	             written = writeRecordRing(&recording->ring, (const int16_t*) stream, count);
 
 	(void) data;
 
-	while(--numSamples >= 0)
+	if(written < count)
 	{
-		float sampL = 0.f, sampR = 0.f;
+		atomic_fetch_add(&recording->overruns, 1);
+		atomic_fetch_add(&recording->dropped, count - written);
+	}
+}
 
-		incrementSample(&playback->interpolation, getSampleEdit(), &sampL, &sampR, playback->sample_rate);
+static void free_recording(void)
+{
+	if(recording == NULL) return;
 
-		*out++ = CLAMPF(sampL * playback->vol);
-		*out++ = CLAMPF(sampR * playback->vol);
+	if(recording->input_dev > 0)
+	{
+		printf("\033[0;34mClosing input device %s...\033[0m\n", SDL_GetAudioDeviceName(audio_config->indev_num, 1));
 
-		if(playback->rampVolDown) playback->vol *= 0.999f;
+		SDL_PauseAudioDevice(recording->input_dev, SDL_TRUE);
+		SDL_CloseAudioDevice(recording->input_dev);
+		recording->input_dev = 0;
 	}
 
-	playback->pos = (int) floor(getSampleEdit()->pos);
-	if(playback->vol <= 0.001f) playback->is_playing = false;
+	freeRecordRing(&recording->ring);
+	freeRecordTake(&recording->take);
+
+	SBC_FREE(recording);
+}
+
+bool startRecording(void)
+{
+	SDL_AudioSpec want, have;
+	const char* indev_name;
+
+	if(recording != NULL) return true;
+
+	SBC_CALLOC(1, sizeof(struct Recording_s), recording);
+
+	/* a second of slack before the GUI thread falling behind turns into overruns */
+	initRecordRing(&recording->ring, (size_t) audio_config->sample_rate);
+
+	memset(&want, 0, sizeof(want));
+	want.freq = (int) audio_config->sample_rate;
+	want.format = AUDIO_S16SYS;
+	want.channels = 1;
+	want.callback = captureCallback;
+	want.samples = audio_config->buffer_size;
+
+	indev_name = SDL_GetAudioDeviceName(audio_config->indev_num, 1);
+	printf("\033[0;32mOpening input audio device %s\033[0m\n\n", indev_name);
+
+	/* no changes allowed, so SDL converts whatever the device gives it to 16 bit mono at the output's rate */
+	if((recording->input_dev = SDL_OpenAudioDevice(indev_name, 1, &want, &have, 0)) == 0)
+	{
+		showErrorMsgBox("Audio Config Error", "Cannot open input device!", SDL_GetError());
+		free_recording();
+
+		return false;
+	}
+
+	recording->sample_rate = (double) have.freq;
+	recording->buffer_size = have.samples;
+
+	SDL_PauseAudioDevice(recording->input_dev, SDL_FALSE);
+
+	return true;
+}
+
+bool isRecording(void) { return recording != NULL; }
+
+int64_t updateRecording(void)
+{
+	int64_t drained = 0;
+
+	if(recording == NULL) return 0;
+
+	/* what was waiting plus a device buffer still being filled is how far behind the take is */
+	recording->latency = (double) (getRecordRingFill(&recording->ring) + recording->buffer_size) * 1000.0 / recording->sample_rate;
+
+	if(recording->latency > recording->max_latency) recording->max_latency = recording->latency;
+
+	if((drained = drainRecordRing(&recording->ring, &recording->take)) < 0) return -1;
+
+	return drained;
+}
+
+bool stopRecording(Sample_t *samp)
+{
+	bool recorded = false;
+
+	if(recording == NULL) return false;
+
+	/* closed first, so nothing can be written after the last drain */
+	SDL_PauseAudioDevice(recording->input_dev, SDL_TRUE);
+	SDL_CloseAudioDevice(recording->input_dev);
+	recording->input_dev = 0;
+
+	drainRecordRing(&recording->ring, &recording->take);
+
+	printf("\033[0;34mRecorded %lld samples at %.0fhz, latency %.1fms (%.1fms max), %llu overruns (%llu samples dropped)\033[0m\n",
+	       (long long) recording->take.length, recording->sample_rate, recording->latency, recording->max_latency,
+	       (unsigned long long) recording->overruns, (unsigned long long) recording->dropped);
+
+	recorded = finishRecordTake(&recording->take, samp, recording->sample_rate);
+
+	free_recording();
+
+	return recorded;
 }
 
+const Record_Take_t *getRecordingTake(void) { return recording != NULL ? &recording->take : NULL; }
+
+double getRecordingLatency(void) { return recording != NULL ? recording->latency : 0.0; }
+
+uint64_t getRecordingOverruns(void) { return recording != NULL ? recording->overruns : 0; }
+
+double getRecordingSampleRate(void) { return recording != NULL ? recording->sample_rate : 0.0; }
+
 static bool outputConfigChanged(void)
 {
 	SDL_AudioSpec want, have;
@@ -377,6 +637,14 @@ static bool outputConfigChanged(void)
 		return false;
 	}
 
+	restartAudioStatsClock(&audio_config->stats);
+
+	/* the device is closed, so the preview's resampler can be swapped without locking */
+	destroyStreamResampler(&playback->dsp_resampler);
+
+	if(audio_config->sample_rate != SDSP_RATE)
+		playback->dsp_resampler = createStreamResampler(SDSP_RATE, audio_config->sample_rate, RESAMPLE_BEST, RENDER_BLOCK);
+
 	return true;
 }
 
@@ -396,13 +664,18 @@ bool initAudio(void)
 	audio_config->outdev_num = checkDevice(0, SDL_GetNumAudioDevices(0));
 	audio_config->indev_num  = checkDevice(0, SDL_GetNumAudioDevices(1));
 
-	playback->interpolation.type = GAUSS;
+	playback->voice.type = GAUSS;
 
-	clearInterpolation(&playback->interpolation);
+	clearVoice(&playback->voice);
+	resetPolyMixer(&playback->poly);
+	playback->published_pos = -1.0;
 
 	playback->vol = 1.0f;
 	playback->sample_rate = 16744.0;
 
+	/* full direct gain, so the preview's level matches playback until an envelope is set */
+	playback->sdsp_env = (Sdsp_Envelope_t) { 0x00, 0x00, 0x7F };
+
 	printf("\033[0;34mAvailable audio drivers:\033[0m\n");
 
 	for(int i = 0; i < num_drivers; i++)
@@ -459,27 +732,71 @@ void closeAudioDevice(void)
 
 void freeAudio(void)
 {
+	free_recording();
 	closeAudioDevice();
 
+	destroyStreamResampler(&playback->dsp_resampler);
+	SBC_FREE(playback->brr);
+
 	SBC_FREE(playback);
 	SBC_FREE(audio_config);
 }
 
-InterpolationType_t getCurrentInterpolationType(void) { return playback->interpolation.type; }
+InterpolationType_t getCurrentInterpolationType(void) { return playback->voice.type; }
 
-void setInterpolationType(const InterpolationType_t interpol)
+void getAudioEngineStats(Audio_Stats_Snapshot_t *snap) { getAudioStats(&audio_config->stats, snap); }
+
+void resetAudioEngineStats(void) { resetAudioStats(&audio_config->stats); }
+
+bool dumpAudioEngineStats(void)
 {
-	if(playback->interpolation.type == interpol) return;
-	playback->interpolation.type = interpol;
+	Audio_Stats_Snapshot_t snap;
+	FILE *log_file = NULL;
+	char *log_path = NULL;
+	time_t now = time(NULL);
+
+	if((log_path = getConfFilePath("sbc_audio.log")) == NULL) return false;
+
+	if((log_file = fopen(log_path, "a")) == NULL)
+	{
+		showErrorMsgBox("Audio Stats Error", "Cannot open audio stats log!", strerror(errno));
+		SBC_FREE(log_path);
+
+		return false;
+	}
+
+	getAudioStats(&audio_config->stats, &snap);
+
+	fprintf(log_file, "==== %s", ctime(&now));
+	fprintf(log_file, "driver: %s\n", SDL_GetCurrentAudioDriver() != NULL ? SDL_GetCurrentAudioDriver() : "none");
+	fprintf(log_file, "output device: %s\n", SDL_GetAudioDeviceName(audio_config->outdev_num, 0));
+	fprintf(log_file, "sample rate: %.0fhz, buffer size: %d\n\n", audio_config->sample_rate, audio_config->buffer_size);
+
+	writeAudioStats(log_file, &snap);
+	fprintf(log_file, "\n");
+
+	fclose(log_file);
+
+	printf("\033[0;34mAudio stats written to %s\033[0m\n", log_path);
+	SBC_FREE(log_path);
+
+	return true;
 }
 
-void clearInterpolation(Interpolation_t* i)
+void setInterpolationType(const InterpolationType_t interpol)
 {
-	memset(i, 0, sizeof *i - sizeof(i->type));
+	if(playback->voice.type == interpol) return;
+	playback->voice.type = interpol;
 }
 
 void setPlaybackSampleRate(const double rate) { playback->sample_rate = rate; }
 
+bool isSdspPreview(void) { return playback->sdsp_preview; }
+void setSdspPreview(const bool preview) { playback->sdsp_preview = preview; }
+
+Sdsp_Envelope_t getSdspPreviewEnvelope(void) { return playback->sdsp_env; }
+void setSdspPreviewEnvelope(const Sdsp_Envelope_t env) { playback->sdsp_env = env; }
+
 int getCurrentAudioDriver(void) { return audio_config->driver; }
 
 int getCurrentOutDev(void) { return audio_config->outdev_num; }
@@ -533,7 +850,12 @@ void setOutputDevice(const int dev)
 			showErrorMsgBox("Audio Config Error", "Cannot restore configuration!", SDL_GetError());
 			closeAudioDevice();
 		}
+
+		return;
 	}
+
+	/* picks up the size auto mode left this device at */
+	if(audio_config->auto_buffer_size) setAutoBufferSize(true);
 }
 
 int getCurrentInDev(void) { return audio_config->indev_num; }
@@ -560,49 +882,153 @@ int getAudioBufferSize(void)
 	}
 }
 
+/* reopens the device with size frames per callback, or puts the old size back if it won't open */
+static bool change_buffer_size(const uint16_t size)
+{
+	const uint16_t curr_size = audio_config->buffer_size;
+
+	audio_config->buffer_size = size;
+
+	if(!outputConfigChanged())
+	{
+		audio_config->buffer_size = curr_size;
+		showErrorMsgBox("Audio Config Error", "Invalid Buffer Size!", SDL_GetError());
+		
+		if(!outputConfigChanged())
+		{
+			showErrorMsgBox("Audio Config Error", "Cannot restore configuration!", SDL_GetError());
+			closeAudioDevice();
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
 bool setAudioBufferSize(const int size)
 {
 	const uint16_t curr_size = audio_config->buffer_size;
+	const bool was_auto = audio_config->auto_buffer_size;
+	uint16_t new_size = 1024;
+
+	/* picking a size by hand turns auto off, which counts as a change even if the size stays the same */
+	audio_config->auto_buffer_size = false;
+	audio_config->auto_pending = 0;
 
 	switch (size)
 	{
 	case 0:
-		if(curr_size == 256) return false;
-		audio_config->buffer_size = 256;
+		new_size = 256;
 		break;
 	case 1:
-		if(curr_size == 512) return false;
-		audio_config->buffer_size = 512;
+		new_size = 512;
 		break;
 	case 2:
-		if(curr_size == 1024) return false;
-		audio_config->buffer_size = 1024;
+		new_size = 1024;
 		break;
 	case 3:
-		if(curr_size == 2048) return false;
-		audio_config->buffer_size = 2048;
+		new_size = 2048;
 		break;
 	
 	default:
-		if(curr_size == 1024) return false;
-		audio_config->buffer_size = 1024;
+		new_size = 1024;
 		break;
 	}
+
+	if(new_size == curr_size) return was_auto;
 	
-	if(!outputConfigChanged())
+	return change_buffer_size(new_size);
+}
+
+static int find_auto_device(const char *name)
+{
+	if(name == NULL) return -1;
+
+	for(int i = 0; i < audio_config->num_auto_devices; i++)
 	{
-		audio_config->buffer_size = curr_size;
-		showErrorMsgBox("Audio Config Error", "Invalid Buffer Size!", SDL_GetError());
-		
-		if(!outputConfigChanged())
-		{
-			showErrorMsgBox("Audio Config Error", "Cannot restore configuration!", SDL_GetError());
-			closeAudioDevice();
-		}
+		if(strcmp(audio_config->auto_devices[i].name, name) == 0) return i;
+	}
 
-		return false;
+	return -1;
+}
+
+void setDeviceBufferSize(const char *device, const int buffer_size)
+{
+	int i = find_auto_device(device);
+
+	if(device == NULL || *device == '\0') return;
+	if(buffer_size != 256 && buffer_size != 512 && buffer_size != 1024 && buffer_size != 2048) return;
+
+	/* once the list is full, the last device in it makes way */
+	if(i < 0) i = audio_config->num_auto_devices < AUTO_BUFFER_DEVICES ? audio_config->num_auto_devices++ : AUTO_BUFFER_DEVICES - 1;
+
+	snprintf(audio_config->auto_devices[i].name, sizeof audio_config->auto_devices[i].name, "%s", device);
+	audio_config->auto_devices[i].buffer_size = (uint16_t) buffer_size;
+}
+
+int getNumDeviceBufferSizes(void) { return audio_config->num_auto_devices; }
+
+const char *getDeviceBufferSize(const int i, int *buffer_size)
+{
+	if(i < 0 || i >= audio_config->num_auto_devices) return NULL;
+
+	*buffer_size = audio_config->auto_devices[i].buffer_size;
+
+	return audio_config->auto_devices[i].name;
+}
+
+bool isAutoBufferSize(void) { return audio_config->auto_buffer_size; }
+
+void setAutoBufferSize(const bool on)
+{
+	Audio_Stats_Snapshot_t snap;
+	const int i = find_auto_device(SDL_GetAudioDeviceName(audio_config->outdev_num, 0));
+
+	audio_config->auto_buffer_size = on;
+	audio_config->auto_pending = 0;
+
+	if(!on) return;
+
+	/* starts from wherever this device was left last time */
+	if(i > -1 && audio_config->auto_devices[i].buffer_size != audio_config->buffer_size)
+		change_buffer_size(audio_config->auto_devices[i].buffer_size);
+
+	getAudioStats(&audio_config->stats, &snap);
+	resetAutoBuffer(&audio_config->auto_buffer, &snap);
+}
+
+bool updateAutoBufferSize(void)
+{
+	Audio_Stats_Snapshot_t snap;
+	uint16_t size = 0;
+	int curr = 0, next = 0;
+
+	if(!audio_config->auto_buffer_size || audio_config->output_dev == 0) return false;
+
+	curr = getAudioStatsSize(audio_config->buffer_size);
+
+	getAudioStats(&audio_config->stats, &snap);
+
+	if((next = stepAutoBuffer(&audio_config->auto_buffer, &snap, curr)) != curr) 
+		audio_config->auto_pending = (uint16_t) (256 << next);
+
+	/* the device has to be reopened for a new size, which would cut off whatever's playing */
+	if(audio_config->auto_pending == 0 || playback->is_playing || playback->notes_sounding) return false;
+
+	size = audio_config->auto_pending;
+	audio_config->auto_pending = 0;
+
+	printf("\033[0;34mAuto buffer size: %d -> %d\033[0m\n", audio_config->buffer_size, size);
+
+	if(!change_buffer_size(size))
+	{
+		audio_config->auto_buffer_size = false;
+		return true;
 	}
 
+	setDeviceBufferSize(SDL_GetAudioDeviceName(audio_config->outdev_num, 0), size);
+
 	return true;
 }
 
@@ -0,0 +1,208 @@
+#include "sbc_common.h"
+#include "sbc_audiostats.h"
+
+/* only the audio thread ever writes, so a relaxed add or load and store is all any counter needs */
+static void add_stat(_Atomic uint64_t *stat, const uint64_t val)
+{
+    atomic_fetch_add_explicit(stat, val, memory_order_relaxed);
+}
+
+static void max_stat(_Atomic uint64_t *stat, const uint64_t val)
+{
+    if(val > atomic_load_explicit(stat, memory_order_relaxed)) atomic_store_explicit(stat, val, memory_order_relaxed);
+}
+
+static uint64_t get_stat(_Atomic uint64_t *stat) { return atomic_load_explicit(stat, memory_order_relaxed); }
+
+void resetAudioStats(Audio_Stats_t *s)
+{
+    atomic_store(&s->callbacks, 0);
+    atomic_store(&s->intervals, 0);
+    atomic_store(&s->overloads, 0);
+    atomic_store(&s->late, 0);
+
+    atomic_store(&s->render_total, 0);
+    atomic_store(&s->render_max, 0);
+    atomic_store(&s->jitter_total, 0);
+    atomic_store(&s->jitter_max, 0);
+
+    for(int i = 0; i < AUDIO_STATS_SIZES; i++)
+    {
+        for(int j = 0; j < AUDIO_STATS_BINS; j++) atomic_store(&s->load[i][j], 0);
+    }
+}
+
+void restartAudioStatsClock(Audio_Stats_t *s) { atomic_store(&s->last_start, 0); }
+
+int getAudioStatsSize(const int frames)
+{
+    int size = 0;
+
+    while(size < AUDIO_STATS_SIZES - 1 && frames > (256 << size)) size++;
+
+    return size;
+}
+
+void recordAudioCallback(Audio_Stats_t *s, const uint64_t start, const uint64_t end, const int frames, const double rate)
+{
+    const uint64_t deadline = (uint64_t) ((double) frames * 1e9 / rate),
+                   render = end > start ? end - start : 0,
+                   last = atomic_exchange_explicit(&s->last_start, start, memory_order_relaxed);
+    uint64_t bin = deadline > 0 ? render * 10 / deadline : AUDIO_STATS_BINS - 1;
+
+    if(bin > AUDIO_STATS_BINS - 1) bin = AUDIO_STATS_BINS - 1;
+
+    add_stat(&s->callbacks, 1);
+    add_stat(&s->render_total, render);
+    max_stat(&s->render_max, render);
+    add_stat(&s->load[getAudioStatsSize(frames)][bin], 1);
+
+    atomic_store_explicit(&s->deadline, deadline, memory_order_relaxed);
+
+    if(render > deadline) add_stat(&s->overloads, 1);
+
+    /* the first callback after the device starts has nothing to be late against */
+    if(last == 0 || start < last) return;
+
+    {
+        const uint64_t interval = start - last,
+                       jitter = interval > deadline ? interval - deadline : deadline - interval;
+
+        add_stat(&s->intervals, 1);
+        add_stat(&s->jitter_total, jitter);
+        max_stat(&s->jitter_max, jitter);
+
+        if(interval >= deadline + deadline / 2) add_stat(&s->late, 1);
+    }
+}
+
+void getAudioStats(Audio_Stats_t *s, Audio_Stats_Snapshot_t *snap)
+{
+    snap->callbacks    = get_stat(&s->callbacks);
+    snap->intervals    = get_stat(&s->intervals);
+    snap->overloads    = get_stat(&s->overloads);
+    snap->late         = get_stat(&s->late);
+
+    snap->render_total = get_stat(&s->render_total);
+    snap->render_max   = get_stat(&s->render_max);
+    snap->deadline     = get_stat(&s->deadline);
+    snap->jitter_total = get_stat(&s->jitter_total);
+    snap->jitter_max   = get_stat(&s->jitter_max);
+
+    for(int i = 0; i < AUDIO_STATS_SIZES; i++)
+    {
+        for(int j = 0; j < AUDIO_STATS_BINS; j++) snap->load[i][j] = get_stat(&s->load[i][j]);
+    }
+}
+
+uint64_t getAudioStatsLoadCount(const Audio_Stats_Snapshot_t *snap, const int size)
+{
+    uint64_t count = 0;
+
+    for(int j = 0; j < AUDIO_STATS_BINS; j++) count += snap->load[size][j];
+
+    return count;
+}
+
+int getAudioStatsLoadPercentile(const Audio_Stats_Snapshot_t *snap, const int size, const double pct)
+{
+    const uint64_t count = getAudioStatsLoadCount(snap, size);
+    uint64_t below = 0;
+
+    if(count == 0) return 0;
+
+    for(int j = 0; j < AUDIO_STATS_BINS; j++)
+    {
+        below += snap->load[size][j];
+
+        if((double) below >= (double) count * pct / 100.0) return j;
+    }
+
+    return AUDIO_STATS_BINS - 1;
+}
+
+void writeAudioStats(FILE *f, const Audio_Stats_Snapshot_t *snap)
+{
+    const double callbacks = snap->callbacks > 0 ? (double) snap->callbacks : 1.0,
+                 intervals = snap->intervals > 0 ? (double) snap->intervals : 1.0;
+
+    fprintf(f, "callbacks: %llu\n", (unsigned long long) snap->callbacks);
+    fprintf(f, "deadline: %.3fms\n", (double) snap->deadline / 1e6);
+    fprintf(f, "render: %.3fms average, %.3fms max\n", (double) snap->render_total / callbacks / 1e6, (double) snap->render_max / 1e6);
+    fprintf(f, "jitter: %.3fms average, %.3fms max\n", (double) snap->jitter_total / intervals / 1e6, (double) snap->jitter_max / 1e6);
+    fprintf(f, "overloads (rendered past the deadline): %llu\n", (unsigned long long) snap->overloads);
+    fprintf(f, "late callbacks (likely underruns): %llu\n", (unsigned long long) snap->late);
+
+    fprintf(f, "\nload     ");
+    for(int j = 0; j < AUDIO_STATS_BINS - 1; j++) fprintf(f, " <%3d%%", (j + 1) * 10);
+    fprintf(f, " >100%%\n");
+
+    for(int i = 0; i < AUDIO_STATS_SIZES; i++)
+    {
+        fprintf(f, "%4d     ", 256 << i);
+
+        for(int j = 0; j < AUDIO_STATS_BINS; j++) fprintf(f, " %5llu", (unsigned long long) snap->load[i][j]);
+
+        fprintf(f, "\n");
+    }
+}
+
+void resetAutoBuffer(Audio_Auto_Buffer_t *a, const Audio_Stats_Snapshot_t *snap)
+{
+    a->last = *snap;
+    a->clean = 0;
+    a->settle = AUTO_BUFFER_SETTLE;
+    a->stepped_down = false;
+}
+
+int stepAutoBuffer(Audio_Auto_Buffer_t *a, const Audio_Stats_Snapshot_t *snap, const int size)
+{
+    Audio_Stats_Snapshot_t window;
+    uint64_t misses = 0;
+    int load = 0;
+
+    /* the stats were reset under it, so start the window again */
+    if(snap->callbacks < a->last.callbacks)
+    {
+        a->last = *snap;
+        return size;
+    }
+
+    /* only callbacks at this size count towards its window, anything else was before the last change */
+    if(getAudioStatsLoadCount(snap, size) - getAudioStatsLoadCount(&a->last, size) < AUTO_BUFFER_WINDOW) return size;
+
+    memset(&window, 0, sizeof window);
+
+    for(int j = 0; j < AUDIO_STATS_BINS; j++) window.load[size][j] = snap->load[size][j] - a->last.load[size][j];
+
+    misses = (snap->late - a->last.late) + (snap->overloads - a->last.overloads);
+    load = getAudioStatsLoadPercentile(&window, size, 99.0);
+
+    a->last = *snap;
+
+    if(misses >= 2 || load >= 8)
+    {
+        a->clean = 0;
+
+        if(size >= AUDIO_STATS_SIZES - 1) return size;
+
+        if(a->stepped_down) a->settle = a->settle * 2 < AUTO_BUFFER_MAX_SETTLE ? a->settle * 2 : AUTO_BUFFER_MAX_SETTLE;
+
+        a->stepped_down = false;
+        return size + 1;
+    }
+
+    if(misses > 0 || load >= 4)
+    {
+        a->clean = 0;
+        return size;
+    }
+
+    /* remembers stepping down, so if the smaller size fails it waits twice as long before trying it again */
+    if(++a->clean < a->settle) return size;
+
+    a->clean = 0;
+    a->stepped_down = size > 0;
+
+    return size > 0 ? size - 1 : size;
+}
@@ -0,0 +1,394 @@
+#include <sys/stat.h>
+#include <stdatomic.h>
+
+#if defined (_WIN32)
+#include <Windows.h>
+#define PATH_SEP '\\'
+#else
+#define PATH_SEP '/'
+#endif
+
+#include "sbc_common.h"
+#include "sbc_samp_edit.h"
+#include "sbc_threadpool.h"
+#include "sbc_fileload.h"
+#include "sbc_filesave.h"
+#include "sbc_compand.h"
+#include "sbc_resample.h"
+#include "sbc_batch.h"
+
+typedef struct Batch_Job_s
+{
+    char **files, **out_paths;
+    int num_files;
+
+    const char *out_dir;
+    const char *out_ext;
+
+    double resample_rate;
+    bool bit16;
+
+    _Atomic int failed;
+} batch_job_t;
+
+static const char *batch_formats[] = { "wav", "w64", "aif", "aiff", "iff", "brr", "bin", "ul", "al", "raw" };
+
+static const char *bin_curves[] = { "linn", "ulaw", "alaw" };
+
+static const char *downmix_names[] = { "left", "right", "mid", "side" };
+
+static const char *resample_names[] = { "nearest", "fast", "good", "best" };
+
+/* left, right, mid, side or mix, or a 1 based channel number */
+static bool parse_downmix(const char *arg)
+{
+    char *end = NULL;
+    long channel = 0;
+
+    for(int m = 0; m < (int) (sizeof downmix_names / sizeof *downmix_names); m++)
+    {
+        if(strcasecmp(arg, downmix_names[m]) != 0) continue;
+
+        setDownmixMode((DownmixMode_t) m);
+        return true;
+    }
+
+    if(strcasecmp(arg, "mix") == 0)
+    {
+        setDownmixMode(DOWNMIX_WEIGHTED);
+        return true;
+    }
+
+    channel = strtol(arg, &end, 10);
+    if(end == arg || *end != '\0' || channel < 1) return false;
+
+    setDownmixChannel((int) channel - 1);
+    setDownmixMode(DOWNMIX_CHANNEL);
+
+    return true;
+}
+
+/* comma separated, one weight per channel */
+static bool parse_weights(const char *arg)
+{
+    float weights[DOWNMIX_MAX_WEIGHTS];
+    int num_weights = 0;
+
+    for(const char *c = arg; num_weights < DOWNMIX_MAX_WEIGHTS; c++)
+    {
+        char *end = NULL;
+
+        weights[num_weights] = strtof(c, &end);
+        if(end == c) return false;
+
+        num_weights++;
+
+        if(*(c = end) == '\0') break;
+        if(*c != ',') return false;
+    }
+
+    setDownmixWeights(weights, num_weights);
+    setDownmixMode(DOWNMIX_WEIGHTED);
+
+    return true;
+}
+
+static void print_usage(void)
+{
+    printf("usage: sbc --batch [options] files...\n\n");
+    printf("  -f <format>   output format: wav, w64, aif, iff, brr, bin (mu-law), ul (G.711 mu-law),\n");
+    printf("                al (G.711 A-law) or raw (default brr)\n");
+    printf("  -o <dir>      output directory, created if missing (default .)\n");
+    printf("  -r <rate>     resample to rate before saving (%d-%dHz)\n", RESAMPLE_MIN_RATE, RESAMPLE_MAX_RATE);
+    printf("  --resampler <q> resample quality: nearest, fast, good (default) or best\n");
+    printf("  -j <threads>  number of worker threads (default: one per core)\n");
+    printf("  -8            export 8-bit wav, w64, aif and raw files\n");
+    printf("  --brr-hq      use the beam-search BRR encoder\n");
+    printf("  --brr-sdsp    decode .brr inputs exactly as the SNES S-DSP does\n");
+    printf("  --bin <curve> companding curve of .bin files: linn (LM-1/LM-2, default), ulaw or alaw\n");
+    printf("  --dither      TPDF dither 24-bit, 32-bit and float inputs to 16 bits\n");
+    printf("  --downmix <m> read multichannel inputs as left, right, mid, side, mix\n");
+    printf("                or a channel number starting at 1 (default left)\n");
+    printf("  --weights <w> comma separated per-channel weights for mix, e.g. 0.5,0.5,0.25,0.25\n");
+}
+
+static bool make_out_dir(const char *dir)
+{
+    struct stat sb;
+
+    if(stat(dir, &sb) == 0) return true;
+
+#if defined (_WIN32)
+    return CreateDirectoryA(dir, NULL) != 0;
+#else
+    return mkdir(dir, 0755) == 0;
+#endif
+}
+
+/* out_dir/name.ext, with name being the input's file name minus its extension */
+static char *get_out_path(const char *in_path, const char *out_dir, const char *out_ext)
+{
+    const char *name = in_path, *ext = NULL;
+    const size_t dir_len = strlen(out_dir);
+
+    char *out_path = NULL;
+    size_t name_len = 0, out_len = 0;
+    bool needs_sep = false;
+
+    for(const char *c = in_path; *c != '\0'; c++)
+        if(*c == '/' || *c == '\\') name = c + 1;
+
+    name_len = ((ext = strrchr(name, '.')) != NULL && ext != name) ? (size_t) (ext - name) : strlen(name);
+
+    needs_sep = dir_len > 0 && out_dir[dir_len - 1] != '/' && out_dir[dir_len - 1] != '\\';
+    out_len   = dir_len + name_len + strlen(out_ext) + 3;
+
+    SBC_CALLOC(out_len, sizeof *out_path, out_path);
+
+    if(needs_sep) snprintf(out_path, out_len, "%s%c%.*s.%s", out_dir, PATH_SEP, (int) name_len, name, out_ext);
+    else snprintf(out_path, out_len, "%s%.*s.%s", out_dir, (int) name_len, name, out_ext);
+
+    return out_path;
+}
+
+typedef struct Batch_Out_s
+{
+    const char *in_path, *out_path;
+} batch_out_t;
+
+/* paths are compared the way the file system would, which ignores case on Windows and macOS */
+static int compare_out_path(const void *a, const void *b)
+{
+    const batch_out_t *x = (const batch_out_t*) a, *y = (const batch_out_t*) b;
+
+#if defined (_WIN32) || defined (__APPLE__)
+    return strcasecmp(x->out_path, y->out_path);
+#else
+    return strcmp(x->out_path, y->out_path);
+#endif
+}
+
+/*
+*   every input's output path, worked out before anything is converted. inputs with the same name in
+*   different directories, or the same name with different extensions, would be written over each
+*   other, so they're all reported and false is returned
+*/
+static bool get_out_paths(batch_job_t *job)
+{
+    batch_out_t *outs = NULL;
+    bool unique = true;
+
+    SBC_CALLOC(job->num_files, sizeof *job->out_paths, job->out_paths);
+    SBC_MALLOC(job->num_files, sizeof *outs, outs);
+
+    for(int i = 0; i < job->num_files; i++)
+    {
+        job->out_paths[i] = get_out_path(job->files[i], job->out_dir, job->out_ext);
+
+        outs[i].in_path  = job->files[i];
+        outs[i].out_path = job->out_paths[i];
+    }
+
+    qsort(outs, (size_t) job->num_files, sizeof *outs, compare_out_path);
+
+    for(int i = 1; i < job->num_files; i++)
+    {
+        if(compare_out_path(&outs[i - 1], &outs[i]) != 0) continue;
+
+        fprintf(stderr, "%s and %s would both be written to %s\n", outs[i - 1].in_path, outs[i].in_path, outs[i].out_path);
+        unique = false;
+    }
+
+    SBC_FREE(outs);
+
+    return unique;
+}
+
+static void free_out_paths(batch_job_t *job)
+{
+    for(int i = 0; i < job->num_files; i++)
+    {
+        SBC_FREE(job->out_paths[i]);
+    }
+
+    SBC_FREE(job->out_paths);
+}
+
+/* pool task, one input file per index */
+static void convert_file(void *arg, const int index, const int thread)
+{
+    batch_job_t *job = (batch_job_t*) arg;
+
+    const char *in_path = job->files[index], *out_path = job->out_paths[index];
+
+    Sample_t samp, *resampled = NULL;
+
+    (void) thread;
+
+    if(readSampleFile(in_path, &samp) == SAMP_FILE_ERROR)
+    {
+        fprintf(stderr, "%s: unable to read file\n", in_path);
+        atomic_fetch_add(&job->failed, 1);
+        return;
+    }
+
+    if(job->resample_rate > 0 && job->resample_rate != samp.rate)
+    {
+        /* already on one of the batch pool's threads, so it resamples on this one */
+        resampled = createResampledSample(&samp, job->resample_rate, NULL);
+
+        SBC_FREE(samp.audio.buffer);
+        samp = *resampled;
+        SBC_FREE(resampled);
+    }
+
+    if(writeSampleFile(out_path, &samp, job->bit16)) printf("%s -> %s\n", in_path, out_path);
+    else atomic_fetch_add(&job->failed, 1);
+
+    SBC_FREE(samp.audio.buffer);
+}
+
+bool isBatchArg(const int argc, char *argv[])
+{
+    return argc > 1 && strcmp(argv[1], "--batch") == 0;
+}
+
+int runBatch(const int argc, char *argv[])
+{
+    batch_job_t job;
+    Thread_Pool_t *pool = NULL;
+
+    int num_threads = getNumCores(), first_file = argc;
+    const size_t num_formats = sizeof batch_formats / sizeof *batch_formats;
+
+    assert(isBatchArg(argc, argv));
+
+    memset(&job, 0, sizeof job);
+    job.out_dir = ".";
+    job.out_ext = "brr";
+    job.bit16   = true;
+
+    for(int i = 2; i < argc; i++)
+    {
+        const bool has_val = i + 1 < argc;
+
+        if(strcmp(argv[i], "-f") == 0 && has_val)
+        {
+            size_t f = 0;
+
+            while(f < num_formats && strcasecmp(argv[i + 1], batch_formats[f]) != 0) f++;
+
+            if(f == num_formats)
+            {
+                fprintf(stderr, "unknown output format \'%s\'\n", argv[i + 1]);
+                return 1;
+            }
+
+            job.out_ext = batch_formats[f];
+            i++;
+        }
+        else if(strcmp(argv[i], "-o") == 0 && has_val) job.out_dir = argv[++i];
+        else if(strcmp(argv[i], "-r") == 0 && has_val) job.resample_rate = strtod(argv[++i], NULL);
+        else if(strcmp(argv[i], "-j") == 0 && has_val) num_threads = (int) strtol(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "-8") == 0) job.bit16 = false;
+        else if(strcmp(argv[i], "--brr-hq") == 0) setBrrEncodeMode(BRR_ENCODE_QUALITY);
+        else if(strcmp(argv[i], "--brr-sdsp") == 0) setBrrDecodeMode(BRR_DECODE_SDSP);
+        else if(strcmp(argv[i], "--bin") == 0 && has_val)
+        {
+            int c = 0;
+
+            while(c < NUM_COMPAND_CURVES && strcasecmp(argv[i + 1], bin_curves[c]) != 0) c++;
+
+            if(c == NUM_COMPAND_CURVES)
+            {
+                fprintf(stderr, "unknown companding curve \'%s\'\n", argv[i + 1]);
+                return 1;
+            }
+
+            setBinCurve((CompandCurve_t) c);
+            i++;
+        }
+        else if(strcmp(argv[i], "--resampler") == 0 && has_val)
+        {
+            int q = 0;
+
+            while(q < NUM_RESAMPLE_QUALITIES && strcasecmp(argv[i + 1], resample_names[q]) != 0) q++;
+
+            if(q == NUM_RESAMPLE_QUALITIES)
+            {
+                fprintf(stderr, "unknown resample quality \'%s\'\n", argv[i + 1]);
+                return 1;
+            }
+
+            setResampleQuality((ResampleQuality_t) q);
+            i++;
+        }
+        else if(strcmp(argv[i], "--dither") == 0) setLoadDither(true);
+        else if(strcmp(argv[i], "--downmix") == 0 && has_val)
+        {
+            if(!parse_downmix(argv[++i]))
+            {
+                fprintf(stderr, "unknown downmix \'%s\'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "--weights") == 0 && has_val)
+        {
+            if(!parse_weights(argv[++i]))
+            {
+                fprintf(stderr, "invalid downmix weights \'%s\'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(argv[i][0] == '-')
+        {
+            print_usage();
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+        else
+        {
+            first_file = i;
+            break;
+        }
+    }
+
+    if(first_file >= argc)
+    {
+        print_usage();
+        return 1;
+    }
+
+    if(job.resample_rate != 0 && (job.resample_rate < RESAMPLE_MIN_RATE || job.resample_rate > RESAMPLE_MAX_RATE))
+    {
+        fprintf(stderr, "resample rate must be between %d and %dHz\n", RESAMPLE_MIN_RATE, RESAMPLE_MAX_RATE);
+        return 1;
+    }
+
+    if(!make_out_dir(job.out_dir))
+    {
+        fprintf(stderr, "unable to create output directory \'%s\': %s\n", job.out_dir, strerror(errno));
+        return 1;
+    }
+
+    job.files     = argv + first_file;
+    job.num_files = argc - first_file;
+
+    if(!get_out_paths(&job))
+    {
+        fprintf(stderr, "nothing converted, rename or move the inputs so each has its own output\n");
+        free_out_paths(&job);
+        return 1;
+    }
+
+    if(num_threads > job.num_files) num_threads = job.num_files;
+
+    pool = createThreadPool(num_threads);
+    poolParallelFor(pool, convert_file, &job, job.num_files);
+    destroyThreadPool(&pool);
+
+    free_out_paths(&job);
+
+    if(job.failed > 0) fprintf(stderr, "%d of %d files failed\n", (int) job.failed, job.num_files);
+
+    return job.failed > 0 ? 1 : 0;
+}
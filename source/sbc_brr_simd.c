@@ -0,0 +1,267 @@
+#include "sbc_common.h"
+#include "sbc_brr_simd.h"
+
+#define BRR_NUM_SHIFTS  13
+#define BRR_NUM_FILTERS 4
+
+/*
+*   picks the candidate with the lowest square-error, in the same shift/filter order
+*   as the scalar search so ties resolve to the same block header
+*/
+static int pick_best_candidate(uint64_t err[][BRR_NUM_FILTERS])
+{
+    int best = 0;
+
+    for(int shift = 0; shift < BRR_NUM_SHIFTS; shift++)
+    {
+        for(int filter = 0; filter < BRR_NUM_FILTERS; filter++)
+        {
+            if(err[shift][filter] < err[best >> 2][best & 3])
+                best = (shift << 2) | filter;
+        }
+    }
+
+    return best;
+}
+
+#ifdef SBC_X86_SIMD
+
+/*
+*   SSE2 path: one shift per pass, the four filters in the four 32-bit lanes.
+*   every step mirrors AdpcmMashS in sbc_filesave.c bit for bit.
+*/
+__attribute__((target("sse2")))
+static __m128i sse2_predict(const __m128i v0, const __m128i v1)
+{
+    const __m128i zero = _mm_setzero_si128(),
+                  m1 = _mm_set_epi32( 0,  0, -1,  0),
+                  m2 = _mm_set_epi32( 0, -1,  0,  0),
+                  m3 = _mm_set_epi32(-1,  0,  0,  0);
+
+    const __m128i v1_half = _mm_srai_epi32(v1, 1);
+
+    __m128i f1, f2, f3;
+
+    f1 = _mm_add_epi32(_mm_srai_epi32(v0, 1), _mm_srai_epi32(_mm_sub_epi32(zero, v0), 5));
+
+    f2 = _mm_sub_epi32(zero, _mm_add_epi32(v0, _mm_srai_epi32(v0, 1)));
+    f2 = _mm_add_epi32(v0, _mm_srai_epi32(f2, 5));
+    f2 = _mm_add_epi32(_mm_sub_epi32(f2, v1_half), _mm_srai_epi32(v1, 5));
+
+    f3 = _mm_add_epi32(v0, _mm_add_epi32(_mm_slli_epi32(v0, 2), _mm_slli_epi32(v0, 3)));
+    f3 = _mm_add_epi32(v0, _mm_srai_epi32(_mm_sub_epi32(zero, f3), 7));
+    f3 = _mm_sub_epi32(f3, v1_half);
+    f3 = _mm_add_epi32(f3, _mm_srai_epi32(_mm_add_epi32(v1, v1_half), 4));
+
+    return _mm_or_si128(_mm_or_si128(_mm_and_si128(m1, f1), _mm_and_si128(m2, f2)), _mm_and_si128(m3, f3));
+}
+
+__attribute__((target("sse2")))
+static int sse2_block_search(const int16_t *samp, const int16_t *v)
+{
+    const __m128i zero = _mm_setzero_si128(), fifteen = _mm_set1_epi32(15), eight = _mm_set1_epi32(8),
+                  wrap_lo = _mm_set1_epi32(-32768), wrap_hi = _mm_set1_epi32(-16384), wrap_add = _mm_set1_epi32(32768);
+
+    uint64_t err[BRR_NUM_SHIFTS][BRR_NUM_FILTERS];
+
+    for(int shift = 0; shift < BRR_NUM_SHIFTS; shift++)
+    {
+        const __m128i cnt  = _mm_cvtsi32_si128(shift),
+                      bias = _mm_set1_epi32((4 << shift) + ((1 << shift) >> 2));
+
+        __m128i v0 = _mm_set1_epi32(v[0]), v1 = _mm_set1_epi32(v[1]),
+                sum_even = zero, sum_odd = zero;
+
+        uint64_t even[2], odd[2];
+
+        for(int i = 0; i < 16; i++)
+        {
+            const __m128i in = _mm_set1_epi32(samp[i]), vlin = sse2_predict(v0, v1);
+            __m128i d, c, mask, p;
+
+            d = _mm_sub_epi32(_mm_srai_epi32(in, 1), vlin);
+
+            /* take advantage of wrapping */
+            mask = _mm_and_si128(_mm_cmpgt_epi32(d, wrap_lo), _mm_cmplt_epi32(d, wrap_hi));
+            d = _mm_add_epi32(d, _mm_and_si128(mask, wrap_add));
+
+            /* c = dp / (step / 2), clamped to 0..15 */
+            c = _mm_sra_epi32(_mm_slli_epi32(_mm_add_epi32(d, bias), 1), cnt);
+            c = _mm_and_si128(c, _mm_cmpgt_epi32(c, zero));
+            mask = _mm_cmpgt_epi32(c, fifteen);
+            c = _mm_or_si128(_mm_andnot_si128(mask, c), _mm_and_si128(mask, fifteen));
+            c = _mm_sub_epi32(c, eight);
+
+            /* (int16_t) (CLAMP16(vlin + dp) * 2), sign extended back to 32 bits */
+            p = _mm_add_epi32(vlin, _mm_srai_epi32(_mm_sll_epi32(c, cnt), 1));
+            p = _mm_slli_epi16(_mm_packs_epi32(p, p), 1);
+
+            v1 = v0;
+            v0 = _mm_srai_epi32(_mm_unpacklo_epi16(p, p), 16);
+
+            d = _mm_sub_epi32(in, v0);
+            mask = _mm_srai_epi32(d, 31);
+            d = _mm_sub_epi32(_mm_xor_si128(d, mask), mask);
+
+            sum_even = _mm_add_epi64(sum_even, _mm_mul_epu32(d, d));
+            d = _mm_srli_epi64(d, 32);
+            sum_odd  = _mm_add_epi64(sum_odd,  _mm_mul_epu32(d, d));
+        }
+
+        _mm_storeu_si128((__m128i*) even, sum_even);
+        _mm_storeu_si128((__m128i*) odd,  sum_odd);
+
+        err[shift][0] = even[0];
+        err[shift][1] = odd[0];
+        err[shift][2] = even[1];
+        err[shift][3] = odd[1];
+    }
+
+    return pick_best_candidate(err);
+}
+
+/*
+*   AVX2 path: two shifts per pass, eight candidates in the eight 32-bit lanes.
+*   the last pass scores a 14th shift that is thrown away.
+*/
+__attribute__((target("avx2")))
+static __m256i avx2_predict(const __m256i v0, const __m256i v1)
+{
+    const __m256i zero = _mm256_setzero_si256(),
+                  m1 = _mm256_set_epi32( 0,  0, -1,  0,  0,  0, -1,  0),
+                  m2 = _mm256_set_epi32( 0, -1,  0,  0,  0, -1,  0,  0),
+                  m3 = _mm256_set_epi32(-1,  0,  0,  0, -1,  0,  0,  0);
+
+    const __m256i v1_half = _mm256_srai_epi32(v1, 1);
+
+    __m256i f1, f2, f3;
+
+    f1 = _mm256_add_epi32(_mm256_srai_epi32(v0, 1), _mm256_srai_epi32(_mm256_sub_epi32(zero, v0), 5));
+
+    f2 = _mm256_sub_epi32(zero, _mm256_add_epi32(v0, _mm256_srai_epi32(v0, 1)));
+    f2 = _mm256_add_epi32(v0, _mm256_srai_epi32(f2, 5));
+    f2 = _mm256_add_epi32(_mm256_sub_epi32(f2, v1_half), _mm256_srai_epi32(v1, 5));
+
+    f3 = _mm256_add_epi32(v0, _mm256_add_epi32(_mm256_slli_epi32(v0, 2), _mm256_slli_epi32(v0, 3)));
+    f3 = _mm256_add_epi32(v0, _mm256_srai_epi32(_mm256_sub_epi32(zero, f3), 7));
+    f3 = _mm256_sub_epi32(f3, v1_half);
+    f3 = _mm256_add_epi32(f3, _mm256_srai_epi32(_mm256_add_epi32(v1, v1_half), 4));
+
+    return _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(m1, f1), _mm256_and_si256(m2, f2)),
+                           _mm256_and_si256(m3, f3));
+}
+
+__attribute__((target("avx2")))
+static int avx2_block_search(const int16_t *samp, const int16_t *v)
+{
+    const __m256i zero = _mm256_setzero_si256(), fifteen = _mm256_set1_epi32(15), eight = _mm256_set1_epi32(8),
+                  wrap_lo = _mm256_set1_epi32(-32768), wrap_hi = _mm256_set1_epi32(-16384), wrap_add = _mm256_set1_epi32(32768);
+
+    uint64_t err[BRR_NUM_SHIFTS + 1][BRR_NUM_FILTERS];
+
+    for(int shift = 0; shift < BRR_NUM_SHIFTS; shift += 2)
+    {
+        const int bias_lo = (4 << shift) + ((1 << shift) >> 2),
+                  bias_hi = (8 << shift) + ((2 << shift) >> 2);
+
+        const __m256i cnt  = _mm256_set_epi32(shift + 1, shift + 1, shift + 1, shift + 1, shift, shift, shift, shift),
+                      bias = _mm256_set_epi32(bias_hi, bias_hi, bias_hi, bias_hi, bias_lo, bias_lo, bias_lo, bias_lo);
+
+        __m256i v0 = _mm256_set1_epi32(v[0]), v1 = _mm256_set1_epi32(v[1]),
+                sum_even = zero, sum_odd = zero;
+
+        uint64_t even[4], odd[4];
+
+        for(int i = 0; i < 16; i++)
+        {
+            const __m256i in = _mm256_set1_epi32(samp[i]), vlin = avx2_predict(v0, v1);
+            __m256i d, c, mask, p;
+
+            d = _mm256_sub_epi32(_mm256_srai_epi32(in, 1), vlin);
+
+            /* take advantage of wrapping */
+            mask = _mm256_and_si256(_mm256_cmpgt_epi32(d, wrap_lo), _mm256_cmpgt_epi32(wrap_hi, d));
+            d = _mm256_add_epi32(d, _mm256_and_si256(mask, wrap_add));
+
+            /* c = dp / (step / 2), clamped to 0..15 */
+            c = _mm256_srav_epi32(_mm256_slli_epi32(_mm256_add_epi32(d, bias), 1), cnt);
+            c = _mm256_min_epi32(_mm256_max_epi32(c, zero), fifteen);
+            c = _mm256_sub_epi32(c, eight);
+
+            /* (int16_t) (CLAMP16(vlin + dp) * 2), sign extended back to 32 bits */
+            p = _mm256_add_epi32(vlin, _mm256_srai_epi32(_mm256_sllv_epi32(c, cnt), 1));
+            p = _mm256_min_epi32(_mm256_max_epi32(p, _mm256_set1_epi32(INT16_MIN)), _mm256_set1_epi32(INT16_MAX));
+
+            v1 = v0;
+            v0 = _mm256_srai_epi32(_mm256_slli_epi32(p, 17), 16);
+
+            d = _mm256_sub_epi32(in, v0);
+
+            sum_even = _mm256_add_epi64(sum_even, _mm256_mul_epi32(d, d));
+            d = _mm256_srli_epi64(d, 32);
+            sum_odd  = _mm256_add_epi64(sum_odd,  _mm256_mul_epi32(d, d));
+        }
+
+        _mm256_storeu_si256((__m256i*) even, sum_even);
+        _mm256_storeu_si256((__m256i*) odd,  sum_odd);
+
+        for(int k = 0; k < 2; k++)
+        {
+            err[shift + k][0] = even[k * 2 + 0];
+            err[shift + k][1] = odd [k * 2 + 0];
+            err[shift + k][2] = even[k * 2 + 1];
+            err[shift + k][3] = odd [k * 2 + 1];
+        }
+    }
+
+    return pick_best_candidate(err);
+}
+
+/* each byte is doubled into a 16-bit lane so both nibbles can be sign-extended with one arithmetic shift */
+__attribute__((target("sse2")))
+static void sse2_unpack_block(const uint8_t *data, const int shift, int16_t *out)
+{
+    const __m128i cnt = _mm_cvtsi32_si128(shift),
+                  raw = _mm_loadl_epi64((const __m128i*) data),
+                  b   = _mm_unpacklo_epi8(raw, raw);
+
+    const __m128i hi = _mm_srai_epi16(b, 12),
+                  lo = _mm_srai_epi16(_mm_slli_epi16(b, 4), 12);
+
+    _mm_storeu_si128((__m128i*) (out + 0), _mm_sll_epi16(_mm_unpacklo_epi16(hi, lo), cnt));
+    _mm_storeu_si128((__m128i*) (out + 8), _mm_sll_epi16(_mm_unpackhi_epi16(hi, lo), cnt));
+}
+
+#endif /* SBC_X86_SIMD */
+
+int brrSimdBlockSearch(const int16_t *samp, const int16_t *v)
+{
+    assert(samp != NULL && v != NULL);
+
+#ifdef SBC_X86_SIMD
+    if(__builtin_cpu_supports("avx2")) return avx2_block_search(samp, v);
+    if(__builtin_cpu_supports("sse2")) return sse2_block_search(samp, v);
+#endif
+
+    return -1;
+}
+
+bool brrSimdUnpackBlock(const uint8_t *data, const int shift, int16_t *out)
+{
+    assert(data != NULL && out != NULL);
+    assert(shift >= 0 && shift <= 12);
+
+#ifdef SBC_X86_SIMD
+    if(__builtin_cpu_supports("sse2"))
+    {
+        sse2_unpack_block(data, shift, out);
+        return true;
+    }
+#else
+    (void) data;
+    (void) shift;
+    (void) out;
+#endif
+
+    return false;
+}
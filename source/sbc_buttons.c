@@ -8,7 +8,7 @@
 #include "sbc_pitch.h"
 #include "sbc_waveform.h"
 
-#define NUM_BUTTONS  13
+#define NUM_BUTTONS  14
 #define STD_BUTTON_W 63
 #define STD_BUTTON_H 15
 
@@ -27,6 +27,7 @@ enum Gui_Buttons
     PASTE = 10, 
     CROP = 11, 
     DELETE = 12,
+    RECORD = 13,
 };
 
 static Button_t *gui_buttons[NUM_BUTTONS];
@@ -34,7 +35,12 @@ static Button_t *gui_buttons[NUM_BUTTONS];
 void initButtons(void)
 {
     const int left = 5, right = 69;
-    Rect_t button_rect = { left, SAMPLE_HEIGHT +  107, STD_BUTTON_W, STD_BUTTON_H, TRACKGREY };
+    Rect_t button_rect = { left, SAMPLE_HEIGHT +  91, right - left + STD_BUTTON_W, STD_BUTTON_H, TRACKGREY };
+
+    gui_buttons[RECORD] = createButton(button_rect, TXT_BUTTON, "REC", 0xFF000000, 1);
+
+    button_rect.y = SAMPLE_HEIGHT + 107;
+    button_rect.w = STD_BUTTON_W;
 
     gui_buttons[CUT] = createButton(button_rect, TXT_BUTTON, "CUT", 0xFF000000, 1);
 
@@ -156,7 +162,6 @@ static void do_button_action(const enum Gui_Buttons b)
 
         case CLEAR:
         {
-            audioPaused();
             setUndoBuffer();
             clearSampleEdit();
             drawNewWave();
@@ -166,16 +171,7 @@ static void do_button_action(const enum Gui_Buttons b)
 
         case RESAMPLE:
         {
-            audioPaused();
-
-            if(handleResample())
-            {
-                drawNewWave();
-                
-                if(!optionsIsShowing()) repaintWaveform();
-
-                handleSampleRateText(*getSampleEditSampleRate());
-            }
+            startResample();
         } 
         break;
 
@@ -201,8 +197,6 @@ static void do_button_action(const enum Gui_Buttons b)
 
         case CUT:
         {
-            audioPaused();
-            
             if(handleSampleCut())
             {
                 drawNewWave();
@@ -227,8 +221,6 @@ static void do_button_action(const enum Gui_Buttons b)
 
         case PASTE:
         {
-            audioPaused();
-
             if(handleSamplePaste())
             {
                 drawNewWave();
@@ -240,8 +232,6 @@ static void do_button_action(const enum Gui_Buttons b)
 
         case CROP:
         {
-            audioPaused();
-            
             if(handleSampleCrop())
             {
                 drawNewWave();
@@ -260,8 +250,6 @@ static void do_button_action(const enum Gui_Buttons b)
 
         case DELETE:
         {
-            audioPaused();
-            
             if(handleSampleDelete())
             {
                 drawNewWave();
@@ -277,6 +265,12 @@ static void do_button_action(const enum Gui_Buttons b)
             }
         }
         break;
+
+        case RECORD:
+        {
+            toggleRecording();
+        }
+        return;
     }
 }
 
@@ -292,7 +286,7 @@ bool mouseUpOnButton(const int x, const int y)
         else button_clicked = -1;
 
         if(button_clicked == LOOP) break;
-        else if(i == LOOP) continue;
+        else if(i == LOOP || (i == RECORD && isRecording())) continue;
 
         click_button(gui_buttons[i], false);
         break;
@@ -313,5 +307,6 @@ bool mouseOverButton(const int x, const int y)
 
 Button_t* getPlayButton(void) { return gui_buttons[PLAY]; }
 Button_t* getLoopButton(void) { return gui_buttons[LOOP]; }
+Button_t* getRecButton(void)  { return gui_buttons[RECORD]; }
 
 Button_t* getOptButton(void)  { return gui_buttons[OPTIONS]; }
@@ -0,0 +1,80 @@
+#include <ctype.h>
+
+#include "sbc_common.h"
+
+static ErrorHandler_t error_handler = NULL;
+
+void setErrorHandler(const ErrorHandler_t handler) { error_handler = handler; }
+
+void reportError(const char *title, const char *msg, const char *error)
+{
+	if (error_handler != NULL)
+	{
+		error_handler(title, msg, error);
+		return;
+	}
+
+	if (error != NULL) fprintf(stderr, "%s: %s Error: %s\n", title, msg, error);
+	else fprintf(stderr, "%s: %s\n", title, msg);
+}
+
+bool isStringEmpty(const char *s)
+{
+	if(s == NULL) return true;
+	if(s[0] == '\0') return true;
+    return false;
+}
+
+char *_strndup(char *str, size_t chars)
+{
+#if defined (_WIN32)		// MinGW doesn't have strndup but likes to think it does
+
+    char *buffer;
+    size_t n;
+
+    buffer = (char *) malloc(chars +1);
+    if (buffer)
+    {
+        for (n = 0; ((n < chars) && (str[n] != 0)) ; n++) buffer[n] = str[n];
+        buffer[n] = 0;
+    }
+
+    return buffer;
+
+#else
+	return strndup(str, chars);
+#endif
+}
+
+/*
+* 	Cross-platform strcasestr, without leaning on SDL's string functions
+*/
+char *_strcasestr(const char *haystack, const char *needle)
+{
+
+#ifdef HAVE_STRCASESTR
+        return strcasestr(haystack, needle);
+#else
+        const size_t length = strlen(needle);
+
+        for (; *haystack; ++haystack) {
+                size_t i = 0;
+
+                while (i < length && tolower((unsigned char) haystack[i]) == tolower((unsigned char) needle[i]))
+                        ++i;
+
+                if (i == length) return (char *) haystack;
+        }
+        return NULL;
+#endif
+
+}
+
+void print_args(const char *format, const int size, ...)
+{
+	va_list args; 
+	va_start(args, size); 
+	vprintf(format, args); 
+	va_end(args);
+	printf("\n");
+}
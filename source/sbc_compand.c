@@ -0,0 +1,263 @@
+#include "sbc_common.h"
+#include "sbc_compand.h"
+
+/*
+*   expansion tables, generated offline from the original curves:
+*       linn: sign * round((256^(code / 127) - 1) / 255 * 32767), bit 7 set is positive
+*       G.711: the reference decoders, mu-law with the 0x84 bias and A-law with its 0x55 mask
+*/
+static const int16_t linn_expand[256] =
+{
+         0,     -6,    -12,    -18,    -25,    -31,    -38,    -46,
+       -54,    -62,    -70,    -79,    -88,    -98,   -108,   -119,
+      -130,   -141,   -153,   -166,   -179,   -193,   -207,   -222,
+      -238,   -254,   -271,   -289,   -308,   -327,   -348,   -369,
+      -391,   -414,   -439,   -464,   -490,   -518,   -547,   -577,
+      -608,   -641,   -676,   -712,   -749,   -788,   -829,   -872,
+      -916,   -963,  -1012,  -1063,  -1116,  -1171,  -1229,  -1290,
+     -1353,  -1419,  -1489,  -1561,  -1636,  -1715,  -1797,  -1883,
+     -1973,  -2067,  -2165,  -2267,  -2374,  -2486,  -2602,  -2724,
+     -2851,  -2984,  -3123,  -3268,  -3420,  -3578,  -3744,  -3917,
+     -4097,  -4286,  -4483,  -4689,  -4904,  -5128,  -5363,  -5608,
+     -5864,  -6131,  -6411,  -6703,  -7007,  -7326,  -7659,  -8006,
+     -8369,  -8748,  -9145,  -9558,  -9991, -10442, -10914, -11407,
+    -11922, -12460, -13021, -13608, -14221, -14862, -15531, -16230,
+    -16960, -17722, -18519, -19351, -20221, -21129, -22078, -23069,
+    -24104, -25186, -26315, -27495, -28728, -30016, -31362, -32767,
+         0,      6,     12,     18,     25,     31,     38,     46,
+        54,     62,     70,     79,     88,     98,    108,    119,
+       130,    141,    153,    166,    179,    193,    207,    222,
+       238,    254,    271,    289,    308,    327,    348,    369,
+       391,    414,    439,    464,    490,    518,    547,    577,
+       608,    641,    676,    712,    749,    788,    829,    872,
+       916,    963,   1012,   1063,   1116,   1171,   1229,   1290,
+      1353,   1419,   1489,   1561,   1636,   1715,   1797,   1883,
+      1973,   2067,   2165,   2267,   2374,   2486,   2602,   2724,
+      2851,   2984,   3123,   3268,   3420,   3578,   3744,   3917,
+      4097,   4286,   4483,   4689,   4904,   5128,   5363,   5608,
+      5864,   6131,   6411,   6703,   7007,   7326,   7659,   8006,
+      8369,   8748,   9145,   9558,   9991,  10442,  10914,  11407,
+     11922,  12460,  13021,  13608,  14221,  14862,  15531,  16230,
+     16960,  17722,  18519,  19351,  20221,  21129,  22078,  23069,
+     24104,  25186,  26315,  27495,  28728,  30016,  31362,  32767
+};
+
+static const int16_t ulaw_expand[256] =
+{
+    -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+    -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+    -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+    -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+     -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+     -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+     -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+     -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+     -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+     -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+      -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+      -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+      -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+      -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+      -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+       -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+     32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+     23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+     15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+     11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+      7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+      5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+      3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+      2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+      1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+      1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+       876,    844,    812,    780,    748,    716,    684,    652,
+       620,    588,    556,    524,    492,    460,    428,    396,
+       372,    356,    340,    324,    308,    292,    276,    260,
+       244,    228,    212,    196,    180,    164,    148,    132,
+       120,    112,    104,     96,     88,     80,     72,     64,
+        56,     48,     40,     32,     24,     16,      8,      0
+};
+
+static const int16_t alaw_expand[256] =
+{
+     -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+     -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+     -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+     -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+    -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+    -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+    -11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+    -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+      -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+      -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+       -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+      -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+     -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+     -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+      -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+      -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+      5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+      7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+      2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+      3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+     22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+     30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+     11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+     15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+       344,    328,    376,    360,    280,    264,    312,    296,
+       472,    456,    504,    488,    408,    392,    440,    424,
+        88,     72,    120,    104,     24,      8,     56,     40,
+       216,    200,    248,    232,    152,    136,    184,    168,
+      1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+      1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+       688,    656,    752,    720,    560,    528,    624,    592,
+       944,    912,   1008,    976,    816,    784,    880,    848
+};
+
+/*
+*   linn_thresholds[k] is the smallest magnitude that rounds to code k with SBC's original
+*   round(log(1 + 255 * |s| / 32767) * 22.91), the last entry stops the search at 127
+*/
+static const int32_t linn_thresholds[129] =
+{
+        0,     3,     9,    15,    22,    28,    35,    43,
+       50,    58,    67,    75,    84,    94,   104,   114,
+      125,   136,   148,   160,   173,   186,   200,   215,
+      230,   246,   263,   281,   299,   318,   338,   358,
+      380,   403,   427,   451,   477,   504,   532,   562,
+      593,   625,   658,   693,   730,   768,   808,   850,
+      894,   939,   987,  1037,  1089,  1143,  1200,  1259,
+     1321,  1385,  1453,  1523,  1597,  1674,  1754,  1838,
+     1926,  2018,  2114,  2214,  2318,  2427,  2541,  2660,
+     2785,  2915,  3050,  3192,  3340,  3495,  3657,  3826,
+     4002,  4186,  4379,  4580,  4790,  5009,  5238,  5478,
+     5728,  5989,  6262,  6547,  6845,  7156,  7481,  7821,
+     8175,  8546,  8933,  9337,  9759, 10200, 10661, 11142,
+    11645, 12171, 12719, 13293, 13891, 14517, 15170, 15853,
+    16566, 17310, 18088, 18901, 19750, 20637, 21564, 22531,
+    23542, 24598, 25702, 26854, 28058, 29315, 30629, 32001,
+    INT32_MAX
+};
+
+/*
+*   the code at the start of each segment of linn_segment(), magnitudes below 32 get one
+*   each and every octave above is split into 16. no segment holds more than two thresholds
+*/
+static const uint8_t linn_start[193] =
+{
+      0,   0,   0,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   3,
+      3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   4,   5,   5,   5,   5,
+      5,   5,   6,   6,   6,   6,   7,   7,   7,   8,   8,   8,   8,   9,   9,   9,
+      9,  10,  10,  11,  11,  12,  12,  12,  13,  13,  14,  14,  14,  15,  15,  15,
+     16,  17,  17,  18,  19,  19,  20,  20,  21,  22,  22,  23,  23,  24,  24,  25,
+     25,  26,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  34,  35,  36,  36,
+     37,  38,  39,  40,  41,  42,  43,  44,  45,  45,  46,  47,  48,  48,  49,  50,
+     50,  51,  53,  54,  55,  56,  57,  58,  59,  60,  60,  61,  62,  63,  63,  64,
+     65,  66,  67,  69,  70,  71,  72,  73,  74,  75,  75,  76,  77,  78,  79,  79,
+     80,  81,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  93,  94,  95,
+     96,  97,  98,  99, 101, 102, 103, 104, 105, 106, 107, 107, 108, 109, 110, 111,
+    111, 113, 114, 115, 116, 117, 118, 120, 120, 121, 122, 123, 124, 125, 126, 126,
+    127
+};
+
+
+static const int16_t *expand_tables[NUM_COMPAND_CURVES] = { linn_expand, ulaw_expand, alaw_expand };
+
+static CompandCurve_t bin_curve = COMPAND_LINN;
+
+/* number of significant bits in v, v > 0 */
+static int bit_length(const uint32_t v)
+{
+#if defined (__GNUC__)
+    return 32 - __builtin_clz(v);
+#else
+    int n = 0;
+    while((v >> n) != 0) n++;
+    return n;
+#endif
+}
+
+/* both sides are computed so the choice is a conditional move rather than a branch */
+static int linn_segment(const int32_t mag)
+{
+    const int e = bit_length((uint32_t) mag | 1), 
+              octave = 32 + (e - 6) * 16 + ((mag >> (e > 5 ? e - 5 : 0)) & 15);
+
+    return mag < 32 ? mag : octave;
+}
+
+/* silence and the first few magnitudes stay on the negative side like they always have */
+static uint8_t linn_compress(const int16_t s)
+{
+    const int32_t mag = s < 0 ? -(int32_t) s : s;
+    int code = linn_start[linn_segment(mag)];
+
+    code += mag >= linn_thresholds[code + 1];
+    code += mag >= linn_thresholds[code + 1];
+
+    return (uint8_t) (s > 0 ? code ^ 0x80 : code);
+}
+
+/* 14-bit magnitude plus the 0x84 bias (0x21 at this scale), clipped at 8159. neg is all ones for negative samples */
+static uint8_t ulaw_compress(const int16_t s)
+{
+    const int32_t v = s >> 2, neg = v >> 31;
+    const uint8_t mask = (uint8_t) (0xFF ^ (neg & 0x80));
+
+    int32_t pcm = (v ^ neg) - neg;
+    int seg = 0;
+
+    if(pcm > 8159) pcm = 8159;
+    pcm += 0x21;
+
+    /* segment 0 ends at 0x3F, every segment after it is twice as long */
+    if((seg = bit_length((uint32_t) pcm) - 6) < 0) seg = 0;
+    if(seg >= 8) return (uint8_t) (0x7F ^ mask);
+
+    return (uint8_t) (((seg << 4) | ((pcm >> (seg + 1)) & 0xF)) ^ mask);
+}
+
+/* 13-bit magnitude, negative values are one's complemented (v ^ neg) instead of negated */
+static uint8_t alaw_compress(const int16_t s)
+{
+    const int32_t v = s >> 3, neg = v >> 31;
+    const uint8_t mask = (uint8_t) (0xD5 ^ (neg & 0x80));
+
+    const int32_t pcm = v ^ neg;
+    int seg = 0;
+
+    /* segment 0 ends at 0x1F, pcm tops out at 0xFFF so it never clips */
+    if((seg = bit_length((uint32_t) pcm | 1) - 5) < 0) seg = 0;
+
+    return (uint8_t) (((seg << 4) | ((pcm >> (seg < 2 ? 1 : seg)) & 0xF)) ^ mask);
+}
+
+void expandToS16(const uint8_t *in, int16_t *out, const int64_t length, const CompandCurve_t curve)
+{
+    const int16_t *table = NULL;
+
+    assert(in != NULL && out != NULL);
+    assert(curve < NUM_COMPAND_CURVES);
+
+    table = expand_tables[curve];
+
+    for(int64_t i = 0; i < length; i++) out[i] = table[in[i]];
+}
+
+void compressFromS16(const int16_t *in, uint8_t *out, const int64_t length, const CompandCurve_t curve)
+{
+    assert(in != NULL && out != NULL);
+    assert(curve < NUM_COMPAND_CURVES);
+
+    switch(curve)
+    {
+        case COMPAND_ULAW: for(int64_t i = 0; i < length; i++) out[i] = ulaw_compress(in[i]); break;
+        case COMPAND_ALAW: for(int64_t i = 0; i < length; i++) out[i] = alaw_compress(in[i]); break;
+
+        case COMPAND_LINN:
+        default:           for(int64_t i = 0; i < length; i++) out[i] = linn_compress(in[i]); break;
+    }
+}
+
+CompandCurve_t getBinCurve(void) { return bin_curve; }
+void setBinCurve(const CompandCurve_t curve) { bin_curve = curve < NUM_COMPAND_CURVES ? curve : COMPAND_LINN; }
@@ -17,6 +17,10 @@
 
 #include "sbc_utils.h"
 #include "sbc_audio.h"
+#include "sbc_fileload.h"
+#include "sbc_filesave.h"
+#include "sbc_compand.h"
+#include "sbc_resample.h"
 #include "sbc_conf.h"
 
 #if defined (_WIN32)
@@ -128,15 +132,15 @@ static char *get_prog_path(void)
     return prog_dir;
 }
 
-static char *get_conf_path(const bool test_exist)
+static char *get_conf_path(const char *conf_file, const bool test_exist)
 {
     char *conf_path = NULL, *prog_dir = NULL;
 #if defined (_WIN32)
-    const char *conf_file = "\\sbc.conf";
+    const char *sep = "\\";
 #else
-    const char *conf_file = "/sbc.conf";
+    const char *sep = "/";
 #endif
-    size_t conf_len = PATH_MAX + strlen(conf_file);
+    size_t conf_len = PATH_MAX + strlen(conf_file) + 1;
 
     SBC_CALLOC(conf_len, sizeof *conf_path, conf_path);
 
@@ -144,7 +148,7 @@ static char *get_conf_path(const bool test_exist)
     {
         prog_dir = get_conf_dir();
 
-        snprintf(conf_path, conf_len, "%s%s", prog_dir, conf_file);
+        snprintf(conf_path, conf_len, "%s%s%s", prog_dir, sep, conf_file);
 
         SBC_FREE(prog_dir);
 
@@ -161,19 +165,21 @@ static char *get_conf_path(const bool test_exist)
     }
 
     memset(conf_path, 0, conf_len);
-    snprintf(conf_path, conf_len, "%s%s", prog_dir, conf_file);
+    snprintf(conf_path, conf_len, "%s%s%s", prog_dir, sep, conf_file);
 
     SBC_FREE(prog_dir);
     return conf_path;
 }
 
+char *getConfFilePath(const char *file_name) { return get_conf_path(file_name, false); }
+
 void loadConfig(void)
 {
     FILE *conf_file;
     char *line = NULL, *conf_path = NULL;
     size_t len = 0;
 
-    if((conf_path = get_conf_path(true)) == NULL) return;
+    if((conf_path = get_conf_path("sbc.conf", true)) == NULL) return;
 
     SBC_LOG(CONFIG FILE PATH, % s, conf_path);
     if((conf_file = fopen(conf_path, "r")) == NULL) 
@@ -207,12 +213,56 @@ void loadConfig(void)
 
         val = (int) strtol(val_ptr + 1, &ptr, 10);
 
-        if(_strcasestr(line, "Driver Num: ")) setAudioDriver(val);
+        /* before anything else, a device's name could have any of the other keys in it */
+        if(_strcasestr(line, "Auto Buffer Device: "))
+        {
+            char *name = ptr + strspn(ptr, " ");
+
+            name[strcspn(name, "\r\n")] = '\0';
+            setDeviceBufferSize(name, val);
+        }
+        else if(_strcasestr(line, "Auto Buffer Size: ")) setAutoBufferSize(val != 0);
+        else if(_strcasestr(line, "Driver Num: ")) setAudioDriver(val);
         else if(_strcasestr(line, "Output Device Num: ")) setOutputDevice(val);
         else if(_strcasestr(line, "Input Device Num: "))  setInputDevice(val);
         else if(_strcasestr(line, "Sample Rate Selection: ")) setDeviceSampleRate(val);
         else if(_strcasestr(line, "Buffer Size Selection: ")) setAudioBufferSize(val);
         else if(_strcasestr(line, "Interpolation Selection: ")) setInterpolationType(val);
+        else if(_strcasestr(line, "S-DSP Preview: ")) setSdspPreview(val != 0);
+        else if(_strcasestr(line, "S-DSP Envelope: "))
+        {
+            /* ADSR1, ADSR2 and GAIN as hex bytes */
+            const long adsr1 = strtol(val_ptr + 1, &ptr, 16), adsr2 = strtol(ptr, &ptr, 16), gain = strtol(ptr, &ptr, 16);
+
+            setSdspPreviewEnvelope((Sdsp_Envelope_t) { (uint8_t) adsr1, (uint8_t) adsr2, (uint8_t) gain });
+        }
+        else if(_strcasestr(line, "BRR Encode Mode: ")) setBrrEncodeMode(val == BRR_ENCODE_QUALITY ? BRR_ENCODE_QUALITY : BRR_ENCODE_FAST);
+        else if(_strcasestr(line, "BRR Beam Width: ")) setBrrBeamWidth(val);
+        else if(_strcasestr(line, "BRR Time Budget: ")) setBrrTimeBudget(val);
+        else if(_strcasestr(line, "BRR Decode Mode: ")) setBrrDecodeMode(val == BRR_DECODE_SDSP ? BRR_DECODE_SDSP : BRR_DECODE_CLASSIC);
+        else if(_strcasestr(line, "Load Dither: ")) setLoadDither(val != 0);
+        else if(_strcasestr(line, "Mu-Law Curve: ")) setBinCurve((CompandCurve_t) val);
+        else if(_strcasestr(line, "Resample Quality: ")) setResampleQuality((ResampleQuality_t) val);
+        else if(_strcasestr(line, "Downmix Mode: ")) setDownmixMode((DownmixMode_t) val);
+        else if(_strcasestr(line, "Downmix Channel: ")) setDownmixChannel(val);
+        else if(_strcasestr(line, "Downmix Weights: ")) 
+        {
+            float weights[DOWNMIX_MAX_WEIGHTS];
+            int num_weights = 0;
+
+            for(ptr = val_ptr + 1; num_weights < DOWNMIX_MAX_WEIGHTS; ptr++)
+            {
+                char *end = NULL;
+
+                weights[num_weights] = strtof(ptr, &end);
+                if(end == ptr) break;
+
+                num_weights++;
+                if(*(ptr = end) != ',') break;
+            }
+
+            setDownmixWeights(weights, num_weights);
+        }
         else if(_strcasestr(line, "Default Dir: ")) 
         {
             const size_t line_len = strlen(line), dhdr_len = strlen("Default Dir: ");
@@ -278,18 +328,85 @@ static bool write_dev_settings(FILE *conf_file)
     bool success = true;
 
     char* header = "# Audio device settings\n";
-    char samp_rate[32], buffer_size[32], interpolation[32];
+    char samp_rate[32], buffer_size[32], auto_buffer[32], interpolation[32], sdsp_preview[32], sdsp_env[40];
+    const Sdsp_Envelope_t env = getSdspPreviewEnvelope();
 
     assert(conf_file != NULL);
 
     snprintf(samp_rate,      32, "Sample Rate Selection: %d\n",     getDeviceSampleRate());
     snprintf(buffer_size,    32, "Buffer Size Selection: %d\n",     getAudioBufferSize());
-    snprintf(interpolation,  32, "Interpolation Selection: %d\n\n", getCurrentInterpolationType());
+    snprintf(auto_buffer,    32, "Auto Buffer Size: %d\n",          (int) isAutoBufferSize());
+    snprintf(interpolation,  32, "Interpolation Selection: %d\n",   getCurrentInterpolationType());
+    snprintf(sdsp_preview,   32, "S-DSP Preview: %d\n",             (int) isSdspPreview());
+    snprintf(sdsp_env,       40, "S-DSP Envelope: %02X %02X %02X\n\n", env.adsr1, env.adsr2, env.gain);
 
     if (fwrite(header,         sizeof *header,         strlen(header),         conf_file) < strlen(header))         success = false;
     if (fwrite(samp_rate,      sizeof *samp_rate,      strlen(samp_rate),      conf_file) < strlen(samp_rate))      success = false;
     if (fwrite(buffer_size,    sizeof *buffer_size,    strlen(buffer_size),    conf_file) < strlen(buffer_size))    success = false;
+
+    /* every device's size goes before the switch, so turning auto on can find the current one's */
+    for(int i = 0; i < getNumDeviceBufferSizes(); i++)
+    {
+        char device[192];
+        int size = 0;
+        const char *name = getDeviceBufferSize(i, &size);
+
+        snprintf(device, sizeof device, "Auto Buffer Device: %d %s\n", size, name);
+
+        if (fwrite(device, sizeof *device, strlen(device), conf_file) < strlen(device)) success = false;
+    }
+
+    if (fwrite(auto_buffer,    sizeof *auto_buffer,    strlen(auto_buffer),    conf_file) < strlen(auto_buffer))    success = false;
     if (fwrite(interpolation,  sizeof *interpolation,  strlen(interpolation),  conf_file) < strlen(interpolation))  success = false;
+    if (fwrite(sdsp_preview,   sizeof *sdsp_preview,   strlen(sdsp_preview),   conf_file) < strlen(sdsp_preview))   success = false;
+    if (fwrite(sdsp_env,       sizeof *sdsp_env,       strlen(sdsp_env),       conf_file) < strlen(sdsp_env))       success = false;
+
+    return success;
+}
+
+static bool write_export_settings(FILE *conf_file)
+{
+    bool success = true;
+
+    char* header = "# Codec settings, BRR time budget is in milliseconds (0 = no limit)\n";
+    char encode_mode[32], beam_width[32], time_budget[32], decode_mode[32], load_dither[32], bin_curve[32], resample[32];
+    char downmix_mode[32], downmix_chan[32], downmix_weights[32 + DOWNMIX_MAX_WEIGHTS * 16];
+
+    float weights[DOWNMIX_MAX_WEIGHTS];
+    int num_weights = 0, weights_len = 0;
+
+    assert(conf_file != NULL);
+
+    snprintf(encode_mode, 32, "BRR Encode Mode: %d\n",   (int) getBrrEncodeMode());
+    snprintf(beam_width,  32, "BRR Beam Width: %d\n",    getBrrBeamWidth());
+    snprintf(time_budget, 32, "BRR Time Budget: %d\n",   getBrrTimeBudget());
+    snprintf(decode_mode, 32, "BRR Decode Mode: %d\n",   (int) getBrrDecodeMode());
+    snprintf(load_dither, 32, "Load Dither: %d\n",       (int) getLoadDither());
+    snprintf(bin_curve,   32, "Mu-Law Curve: %d\n",    (int) getBinCurve());
+    snprintf(resample,    32, "Resample Quality: %d\n", (int) getResampleQuality());
+    snprintf(downmix_mode, 32, "Downmix Mode: %d\n",     (int) getDownmixMode());
+    snprintf(downmix_chan, 32, "Downmix Channel: %d\n",  getDownmixChannel());
+
+    num_weights = getDownmixWeights(weights, DOWNMIX_MAX_WEIGHTS);
+    weights_len = snprintf(downmix_weights, sizeof downmix_weights, "Downmix Weights:");
+
+    for(int c = 0; c < num_weights; c++)
+        weights_len += snprintf(downmix_weights + weights_len, sizeof downmix_weights - (size_t) weights_len, 
+                                "%s%g", c == 0 ? " " : ",", (double) weights[c]);
+
+    snprintf(downmix_weights + weights_len, sizeof downmix_weights - (size_t) weights_len, "\n\n");
+
+    if (fwrite(header,      sizeof *header,      strlen(header),      conf_file) < strlen(header))      success = false;
+    if (fwrite(encode_mode, sizeof *encode_mode, strlen(encode_mode), conf_file) < strlen(encode_mode)) success = false;
+    if (fwrite(beam_width,  sizeof *beam_width,  strlen(beam_width),  conf_file) < strlen(beam_width))  success = false;
+    if (fwrite(time_budget, sizeof *time_budget, strlen(time_budget), conf_file) < strlen(time_budget)) success = false;
+    if (fwrite(decode_mode, sizeof *decode_mode, strlen(decode_mode), conf_file) < strlen(decode_mode)) success = false;
+    if (fwrite(load_dither, sizeof *load_dither, strlen(load_dither), conf_file) < strlen(load_dither)) success = false;
+    if (fwrite(bin_curve,   sizeof *bin_curve,   strlen(bin_curve),   conf_file) < strlen(bin_curve))   success = false;
+    if (fwrite(resample,    sizeof *resample,    strlen(resample),    conf_file) < strlen(resample))    success = false;
+    if (fwrite(downmix_mode, sizeof *downmix_mode, strlen(downmix_mode), conf_file) < strlen(downmix_mode)) success = false;
+    if (fwrite(downmix_chan, sizeof *downmix_chan, strlen(downmix_chan), conf_file) < strlen(downmix_chan)) success = false;
+    if (fwrite(downmix_weights, sizeof *downmix_weights, strlen(downmix_weights), conf_file) < strlen(downmix_weights)) success = false;
 
     return success;
 }
@@ -326,7 +443,7 @@ void saveConfig(void)
     FILE *conf_file = NULL;
     char *conf_path = NULL;
 
-    if((conf_path = get_conf_path(false)) == NULL) return;
+    if((conf_path = get_conf_path("sbc.conf", false)) == NULL) return;
     printf("Conf path: %s\n", conf_path);
     
     if((conf_file = fopen(conf_path, "w")) == NULL)
@@ -341,6 +458,7 @@ void saveConfig(void)
     if(!write_header(conf_file)) success = false;
     if(!write_devices(conf_file)) success = false;
     if(!write_dev_settings(conf_file)) success = false;
+    if(!write_export_settings(conf_file)) success = false;
     if(!write_default_dir(conf_file)) success = false;
 
     fclose(conf_file);
@@ -0,0 +1,535 @@
+#include <math.h>
+
+#include "sbc_common.h"
+#include "sbc_convert.h"
+
+/* one xorshift32 state per SSE2 lane, the scalar path steps all four the same way */
+#define DITHER_SEED     { 0x9E3779B9, 0x7F4A7C15, 0xBF58476D, 0x94D049BB }
+
+/* 2^30, keeps a mixed 24-bit sample inside int32_t whatever the weights */
+#define MIX_LIMIT       1073741824.f
+
+/*
+*   every format wider than 16 bits is first reduced to a 24-bit sample, i.e. the
+*   16-bit output with 8 fractional bits, which leaves room for rounding and dither
+*/
+typedef int32_t (*LoadQ8_t)(const uint8_t *p);
+
+static const int samp_format_size[NUM_SAMP_FMTS] = { 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+
+int getSampFormatSize(const SampFormat_t fmt)
+{
+    assert(fmt < NUM_SAMP_FMTS);
+    return samp_format_size[fmt];
+}
+
+/* 8 and 16-bit samples widen the same way convertToS16 does, then get the 8 fractional bits */
+static int32_t load_u8(const uint8_t *p)    { const uint8_t b = p[0] ^ 0x80; return (int16_t) (b << 8 | b) * 256; }
+static int32_t load_s8(const uint8_t *p)    { return (int16_t) (p[0] << 8 | p[0]) * 256; }
+static int32_t load_s16le(const uint8_t *p) { return (int16_t) (p[1] << 8 | p[0]) * 256; }
+static int32_t load_s16be(const uint8_t *p) { return (int16_t) (p[0] << 8 | p[1]) * 256; }
+
+static int32_t load_s24le(const uint8_t *p) { return (int32_t) ((uint32_t) p[0] <<  8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24) >> 8; }
+static int32_t load_s24be(const uint8_t *p) { return (int32_t) ((uint32_t) p[2] <<  8 | (uint32_t) p[1] << 16 | (uint32_t) p[0] << 24) >> 8; }
+static int32_t load_s32le(const uint8_t *p) { return (int32_t) ((uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24) >> 8; }
+static int32_t load_s32be(const uint8_t *p) { return (int32_t) ((uint32_t) p[3] | (uint32_t) p[2] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[0] << 24) >> 8; }
+
+/* clamped the same way as maxps/minps, so NaN ends up at -1.0 */
+static int32_t load_f32le(const uint8_t *p)
+{
+    float f = 0.f;
+
+    memcpy(&f, p, sizeof f);
+
+    f = f > -1.f ? f : -1.f;
+    f = f <  1.f ? f :  1.f;
+
+    return (int32_t) lrintf(f * 8388608.f);
+}
+
+static const LoadQ8_t load_q8[NUM_SAMP_FMTS] = 
+{ 
+    load_u8, load_s8, load_s16le, load_s16be, load_s24le, load_s24be, load_s32le, load_s32be, load_f32le 
+};
+
+static void step_dither(uint32_t *s)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        s[i] ^= s[i] << 13;
+        s[i] ^= s[i] >> 17;
+        s[i] ^= s[i] <<  5;
+    }
+}
+
+/* the sum of two 8-bit uniform values, triangular over +-1 LSB of the output */
+static int32_t tpdf(const uint32_t r) { return (int32_t) (r & 0xFF) + (int32_t) ((r >> 8) & 0xFF) - 255; }
+
+static int16_t q8_to_s16(const int32_t x, const int32_t d)
+{
+    const int32_t s = (x + d + 0x80) >> 8;
+
+    return (int16_t) (s > INT16_MAX ? INT16_MAX : s < INT16_MIN ? INT16_MIN : s);
+}
+
+/*
+*   dither is stepped every 4 samples with sample i taking lane i & 3, which is the
+*   order the SSE2 kernels consume it in, so a scalar tail carries on where they stopped
+*/
+static inline void scalar_q8(const uint8_t *in, const int stride, int16_t *out, const int64_t start,
+                             const int64_t length, const LoadQ8_t load, uint32_t *dither)
+{
+    for(int64_t i = start; i < length; i++)
+    {
+        int32_t d = 0;
+
+        if(dither != NULL)
+        {
+            if((i & 3) == 0) step_dither(dither);
+            d = tpdf(dither[i & 3]);
+        }
+
+        out[i] = q8_to_s16(load(in + i * stride), d);
+    }
+}
+
+/* repeating the byte in the low half maps 0x7F to 0x7F7F instead of 0x7F00 */
+static void scalar_8bit(const uint8_t *in, const int stride, int16_t *out, const int64_t start, const int64_t length, const uint8_t flip)
+{
+    for(int64_t i = start; i < length; i++)
+    {
+        const uint8_t b = in[i * stride] ^ flip;
+        out[i] = (int16_t) (b << 8 | b);
+    }
+}
+
+static void scalar_s16(const uint8_t *in, const int stride, int16_t *out, const int64_t start, const int64_t length, const bool big_endian)
+{
+    if(!big_endian && stride == 2)
+    {
+        memcpy(out + start, in + start * 2, (size_t) (length - start) * sizeof *out);
+        return;
+    }
+
+    for(int64_t i = start; i < length; i++)
+    {
+        const uint8_t *p = in + i * stride;
+        out[i] = (int16_t) (big_endian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0]));
+    }
+}
+
+/* 
+*   a mix can overshoot int32_t well before it overshoots a float, so it's clamped first.
+*   minps/maxps order, the SSE2 kernel has to land on the exact same value
+*/
+static float clamp_mix(float acc)
+{
+    acc = acc < MIX_LIMIT ? acc : MIX_LIMIT;
+    return acc > -MIX_LIMIT ? acc : -MIX_LIMIT;
+}
+
+/* the channels are summed in the order they're listed, same as the SSE2 kernel */
+static inline void scalar_downmix(const uint8_t *in, const int size, const int stride, const int *chans, const float *weights,
+                                  const int num_used, int16_t *out, const int64_t start, const int64_t length, const LoadQ8_t load, uint32_t *dither)
+{
+    for(int64_t i = start; i < length; i++)
+    {
+        const uint8_t *frame = in + i * stride;
+
+        float acc = weights[0] * (float) load(frame + chans[0] * size);
+        int32_t d = 0;
+
+        for(int u = 1; u < num_used; u++)
+            acc += weights[u] * (float) load(frame + chans[u] * size);
+
+        if(dither != NULL)
+        {
+            if((i & 3) == 0) step_dither(dither);
+            d = tpdf(dither[i & 3]);
+        }
+
+        out[i] = q8_to_s16((int32_t) lrintf(clamp_mix(acc)), d);
+    }
+}
+
+#ifdef SBC_X86_SIMD
+
+/* unpacking a byte with itself is the same widening as scalar_8bit */
+__attribute__((target("sse2")))
+static int64_t sse2_convert_8bit(const uint8_t *in, int16_t *out, const int64_t length, const uint8_t flip)
+{
+    const __m128i mask = _mm_set1_epi8((char) flip);
+    int64_t i = 0;
+
+    for(; i + 16 <= length; i += 16)
+    {
+        const __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (in + i)), mask);
+
+        _mm_storeu_si128((__m128i*) (out + i + 0), _mm_unpacklo_epi8(b, b));
+        _mm_storeu_si128((__m128i*) (out + i + 8), _mm_unpackhi_epi8(b, b));
+    }
+
+    return i;
+}
+
+__attribute__((target("sse2")))
+static int64_t sse2_convert_s16be(const uint8_t *in, int16_t *out, const int64_t length)
+{
+    int64_t i = 0;
+
+    for(; i + 8 <= length; i += 8)
+    {
+        const __m128i w = _mm_loadu_si128((const __m128i*) (in + i * 2));
+        _mm_storeu_si128((__m128i*) (out + i), _mm_or_si128(_mm_slli_epi16(w, 8), _mm_srli_epi16(w, 8)));
+    }
+
+    return i;
+}
+
+__attribute__((target("sse2")))
+static inline __m128i sse2_step_dither(__m128i *state)
+{
+    const __m128i byte = _mm_set1_epi32(0xFF), bias = _mm_set1_epi32(255);
+    __m128i s = *state;
+
+    s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+    s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+    s = _mm_xor_si128(s, _mm_slli_epi32(s,  5));
+
+    *state = s;
+
+    return _mm_sub_epi32(_mm_add_epi32(_mm_and_si128(s, byte), _mm_and_si128(_mm_srli_epi32(s, 8), byte)), bias);
+}
+
+/* rounds, dithers if state isn't NULL, and saturates 8 24-bit lanes to 16 bits */
+__attribute__((target("sse2")))
+static inline __m128i sse2_q8_to_s16(__m128i lo, __m128i hi, __m128i *state)
+{
+    const __m128i round = _mm_set1_epi32(0x80);
+
+    lo = _mm_add_epi32(lo, round);
+    hi = _mm_add_epi32(hi, round);
+
+    if(state != NULL)
+    {
+        lo = _mm_add_epi32(lo, sse2_step_dither(state));
+        hi = _mm_add_epi32(hi, sse2_step_dither(state));
+    }
+
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+
+__attribute__((target("sse2")))
+static int64_t sse2_convert_s32le(const uint8_t *in, int16_t *out, const int64_t length, uint32_t *dither)
+{
+    __m128i state = dither != NULL ? _mm_loadu_si128((const __m128i*) dither) : _mm_setzero_si128();
+    int64_t i = 0;
+
+    for(; i + 8 <= length; i += 8)
+    {
+        const __m128i lo = _mm_srai_epi32(_mm_loadu_si128((const __m128i*) (in + i * 4 +  0)), 8),
+                      hi = _mm_srai_epi32(_mm_loadu_si128((const __m128i*) (in + i * 4 + 16)), 8);
+
+        _mm_storeu_si128((__m128i*) (out + i), sse2_q8_to_s16(lo, hi, dither != NULL ? &state : NULL));
+    }
+
+    if(dither != NULL) _mm_storeu_si128((__m128i*) dither, state);
+
+    return i;
+}
+
+__attribute__((target("sse2")))
+static int64_t sse2_convert_f32(const uint8_t *in, int16_t *out, const int64_t length, uint32_t *dither)
+{
+    const __m128 neg_one = _mm_set1_ps(-1.f), one = _mm_set1_ps(1.f), scale = _mm_set1_ps(8388608.f);
+
+    __m128i state = dither != NULL ? _mm_loadu_si128((const __m128i*) dither) : _mm_setzero_si128();
+    int64_t i = 0;
+
+    for(; i + 8 <= length; i += 8)
+    {
+        const __m128 lo_f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps((const float*) (in + i * 4 +  0)), neg_one), one),
+                     hi_f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps((const float*) (in + i * 4 + 16)), neg_one), one);
+
+        const __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(lo_f, scale)),
+                      hi = _mm_cvtps_epi32(_mm_mul_ps(hi_f, scale));
+
+        _mm_storeu_si128((__m128i*) (out + i), sse2_q8_to_s16(lo, hi, dither != NULL ? &state : NULL));
+    }
+
+    if(dither != NULL) _mm_storeu_si128((__m128i*) dither, state);
+
+    return i;
+}
+
+/*
+*   the byte shuffle puts each 3 or 4 byte sample in the top of a 32-bit lane,
+*   an arithmetic shift then sign-extends it down to 24 bits
+*/
+__attribute__((target("ssse3")))
+static int64_t ssse3_convert_shuffled(const uint8_t *in, int16_t *out, const int64_t length, const int size,
+                                      const __m128i shuf, uint32_t *dither)
+{
+    __m128i state = dither != NULL ? _mm_loadu_si128((const __m128i*) dither) : _mm_setzero_si128();
+    int64_t i = 0;
+
+    /* every load is 16 bytes wide, so stop while the second one still ends inside the input */
+    for(; (i + 4) * size + 16 <= length * size; i += 8)
+    {
+        const __m128i lo = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (in + (i + 0) * size)), shuf), 8),
+                      hi = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (in + (i + 4) * size)), shuf), 8);
+
+        _mm_storeu_si128((__m128i*) (out + i), sse2_q8_to_s16(lo, hi, dither != NULL ? &state : NULL));
+    }
+
+    if(dither != NULL) _mm_storeu_si128((__m128i*) dither, state);
+
+    return i;
+}
+
+/* 
+*   one channel of a 16-bit stereo file, the sample we want is the low half of every 32-bit lane.
+*   in may point at the right channel, so the last load has to stop 2 bytes short of a whole frame
+*/
+__attribute__((target("sse2")))
+static int64_t sse2_convert_s16_stereo(const uint8_t *in, int16_t *out, const int64_t length)
+{
+    int64_t i = 0;
+
+    for(; i + 9 <= length; i += 8)
+    {
+        const __m128i lo = _mm_loadu_si128((const __m128i*) (in + i * 4 +  0)),
+                      hi = _mm_loadu_si128((const __m128i*) (in + i * 4 + 16));
+
+        _mm_storeu_si128((__m128i*) (out + i), _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                                                               _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16)));
+    }
+
+    return i;
+}
+
+/* both channels of 4 16-bit stereo frames as floats with 8 fractional bits */
+__attribute__((target("sse2")))
+static inline void sse2_split_s16_stereo(const uint8_t *in, __m128 *ch)
+{
+    const __m128i v = _mm_loadu_si128((const __m128i*) in);
+
+    ch[0] = _mm_cvtepi32_ps(_mm_slli_epi32(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16), 8));
+    ch[1] = _mm_cvtepi32_ps(_mm_slli_epi32(_mm_srai_epi32(v, 16), 8));
+}
+
+__attribute__((target("sse2")))
+static inline __m128 sse2_clamp_mix(const __m128 acc)
+{
+    return _mm_max_ps(_mm_min_ps(acc, _mm_set1_ps(MIX_LIMIT)), _mm_set1_ps(-MIX_LIMIT));
+}
+
+/* 16-bit stereo deinterleaves with two shifts, so both channels come out of one load */
+__attribute__((target("sse2")))
+static int64_t sse2_downmix_s16_stereo(const uint8_t *in, const int *chans, const float *weights, const int num_used,
+                                       int16_t *out, const int64_t length, uint32_t *dither)
+{
+    __m128i state = dither != NULL ? _mm_loadu_si128((const __m128i*) dither) : _mm_setzero_si128();
+    int64_t i = 0;
+
+    for(; i + 8 <= length; i += 8)
+    {
+        __m128 lo[2], hi[2], acc_lo, acc_hi;
+
+        sse2_split_s16_stereo(in + i * 4 +  0, lo);
+        sse2_split_s16_stereo(in + i * 4 + 16, hi);
+
+        acc_lo = _mm_mul_ps(_mm_set1_ps(weights[0]), lo[chans[0]]);
+        acc_hi = _mm_mul_ps(_mm_set1_ps(weights[0]), hi[chans[0]]);
+
+        if(num_used > 1)
+        {
+            acc_lo = _mm_add_ps(acc_lo, _mm_mul_ps(_mm_set1_ps(weights[1]), lo[chans[1]]));
+            acc_hi = _mm_add_ps(acc_hi, _mm_mul_ps(_mm_set1_ps(weights[1]), hi[chans[1]]));
+        }
+
+        _mm_storeu_si128((__m128i*) (out + i), sse2_q8_to_s16(_mm_cvtps_epi32(sse2_clamp_mix(acc_lo)), 
+                                                              _mm_cvtps_epi32(sse2_clamp_mix(acc_hi)), 
+                                                              dither != NULL ? &state : NULL));
+    }
+
+    if(dither != NULL) _mm_storeu_si128((__m128i*) dither, state);
+
+    return i;
+}
+
+/* 
+*   any format and channel count: each used channel of 4 frames is gathered into a vector,
+*   weighted and summed, then rounded, dithered and packed 8 frames at a time
+*/
+__attribute__((target("sse2")))
+static inline int64_t sse2_downmix(const uint8_t *in, const int size, const int stride, const int *chans, const float *weights,
+                                   const int num_used, int16_t *out, const int64_t length, const LoadQ8_t load, uint32_t *dither)
+{
+    __m128i state = dither != NULL ? _mm_loadu_si128((const __m128i*) dither) : _mm_setzero_si128();
+    int64_t i = 0;
+
+    for(; i + 8 <= length; i += 8)
+    {
+        __m128i mixed[2];
+
+        for(int h = 0; h < 2; h++)
+        {
+            const uint8_t *frames = in + (i + h * 4) * stride;
+            __m128 acc = _mm_setzero_ps();
+
+            for(int u = 0; u < num_used; u++)
+            {
+                const uint8_t *p = frames + chans[u] * size;
+
+                const __m128 x  = _mm_cvtepi32_ps(_mm_setr_epi32(load(p), load(p + stride), 
+                                                                 load(p + stride * 2), load(p + stride * 3))),
+                             wx = _mm_mul_ps(_mm_set1_ps(weights[u]), x);
+
+                acc = u == 0 ? wx : _mm_add_ps(acc, wx);
+            }
+
+            mixed[h] = _mm_cvtps_epi32(sse2_clamp_mix(acc));
+        }
+
+        _mm_storeu_si128((__m128i*) (out + i), sse2_q8_to_s16(mixed[0], mixed[1], dither != NULL ? &state : NULL));
+    }
+
+    if(dither != NULL) _mm_storeu_si128((__m128i*) dither, state);
+
+    return i;
+}
+
+__attribute__((target("sse2")))
+static int64_t simd_downmix(const uint8_t *in, const SampFormat_t fmt, const int num_chan, const int *chans, const float *weights,
+                            const int num_used, int16_t *out, const int64_t length, uint32_t *dither)
+{
+    const int size = samp_format_size[fmt], stride = size * num_chan;
+
+    if(!__builtin_cpu_supports("sse2")) return 0;
+
+    if(fmt == SAMP_FMT_S16LE && num_chan == 2) 
+        return sse2_downmix_s16_stereo(in, chans, weights, num_used, out, length, dither);
+
+    switch(fmt)
+    {
+        case SAMP_FMT_U8:    return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_u8,    dither);
+        case SAMP_FMT_S8:    return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s8,    dither);
+        case SAMP_FMT_S16LE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s16le, dither);
+        case SAMP_FMT_S16BE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s16be, dither);
+        case SAMP_FMT_S24LE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s24le, dither);
+        case SAMP_FMT_S24BE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s24be, dither);
+        case SAMP_FMT_S32LE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s32le, dither);
+        case SAMP_FMT_S32BE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_s32be, dither);
+        case SAMP_FMT_F32LE: return sse2_downmix(in, size, stride, chans, weights, num_used, out, length, load_f32le, dither);
+        default: return 0;
+    }
+}
+
+/* returns how many samples were converted, always a multiple of 8 */
+static int64_t simd_convert(const uint8_t *in, const SampFormat_t fmt, const int stride, int16_t *out, const int64_t length, uint32_t *dither)
+{
+    const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+
+    if(!__builtin_cpu_supports("sse2")) return 0;
+
+    if(fmt == SAMP_FMT_S16LE && stride == 4) return sse2_convert_s16_stereo(in, out, length);
+    if(stride != samp_format_size[fmt]) return 0;
+
+    switch(fmt)
+    {
+        case SAMP_FMT_U8:    return sse2_convert_8bit(in, out, length, 0x80);
+        case SAMP_FMT_S8:    return sse2_convert_8bit(in, out, length, 0x00);
+        case SAMP_FMT_S16BE: return sse2_convert_s16be(in, out, length);
+        case SAMP_FMT_S32LE: return sse2_convert_s32le(in, out, length, dither);
+        case SAMP_FMT_F32LE: return sse2_convert_f32(in, out, length, dither);
+
+        case SAMP_FMT_S24LE:
+            return has_ssse3 ? ssse3_convert_shuffled(in, out, length, 3,
+                                _mm_setr_epi8(-1,  0,  1,  2, -1,  3,  4,  5, -1,  6,  7,  8, -1,  9, 10, 11), dither) : 0;
+        case SAMP_FMT_S24BE:
+            return has_ssse3 ? ssse3_convert_shuffled(in, out, length, 3,
+                                _mm_setr_epi8(-1,  2,  1,  0, -1,  5,  4,  3, -1,  8,  7,  6, -1, 11, 10,  9), dither) : 0;
+        case SAMP_FMT_S32BE:
+            return has_ssse3 ? ssse3_convert_shuffled(in, out, length, 4,
+                                _mm_setr_epi8( 3,  2,  1,  0,  7,  6,  5,  4, 11, 10,  9,  8, 15, 14, 13, 12), dither) : 0;
+
+        /* plain 16-bit is a memcpy */
+        default: return 0;
+    }
+}
+
+#endif /* SBC_X86_SIMD */
+
+void convertToS16(const char *in, const SampFormat_t fmt, const int stride, int16_t *out, const int64_t length, const bool dither)
+{
+    const uint8_t *src = (const uint8_t*) in;
+
+    uint32_t dither_state[4] = DITHER_SEED, *d = dither ? dither_state : NULL;
+    int64_t done = 0;
+
+    assert(in != NULL && out != NULL);
+    assert(fmt < NUM_SAMP_FMTS && stride >= samp_format_size[fmt]);
+
+    if(length <= 0) return;
+
+#ifdef SBC_X86_SIMD
+    done = simd_convert(src, fmt, stride, out, length, d);
+#endif
+
+    switch(fmt)
+    {
+        case SAMP_FMT_U8:    scalar_8bit(src, stride, out, done, length, 0x80);           break;
+        case SAMP_FMT_S8:    scalar_8bit(src, stride, out, done, length, 0x00);           break;
+        case SAMP_FMT_S16LE: scalar_s16(src, stride, out, done, length, false);           break;
+        case SAMP_FMT_S16BE: scalar_s16(src, stride, out, done, length, true);            break;
+        case SAMP_FMT_S24LE: scalar_q8(src, stride, out, done, length, load_s24le, d);    break;
+        case SAMP_FMT_S24BE: scalar_q8(src, stride, out, done, length, load_s24be, d);    break;
+        case SAMP_FMT_S32LE: scalar_q8(src, stride, out, done, length, load_s32le, d);    break;
+        case SAMP_FMT_S32BE: scalar_q8(src, stride, out, done, length, load_s32be, d);    break;
+        case SAMP_FMT_F32LE: scalar_q8(src, stride, out, done, length, load_f32le, d);    break;
+        default: break;
+    }
+}
+
+void downmixToS16(const char *in, const SampFormat_t fmt, const int num_chan, const float *weights, int16_t *out, const int64_t length, const bool dither)
+{
+    const uint8_t *src = (const uint8_t*) in;
+    const int size = getSampFormatSize(fmt), stride = size * num_chan;
+
+    uint32_t dither_state[4] = DITHER_SEED, *d = dither ? dither_state : NULL;
+    int64_t done = 0;
+
+    int *chans = NULL, num_used = 0;
+    float *used_weights = NULL;
+
+    assert(in != NULL && out != NULL && weights != NULL);
+    assert(num_chan > 0);
+
+    if(length <= 0) return;
+
+    SBC_CALLOC(num_chan, sizeof *chans, chans);
+    SBC_CALLOC(num_chan, sizeof *used_weights, used_weights);
+
+    for(int c = 0; c < num_chan; c++)
+    {
+        if(weights[c] == 0.f) continue;
+
+        chans[num_used] = c;
+        used_weights[num_used++] = weights[c];
+    }
+
+    /* picking a single channel out is a strided conversion */
+    if(num_used == 1 && used_weights[0] == 1.f) convertToS16(in + chans[0] * size, fmt, stride, out, length, dither);
+    else if(num_used == 0) memset(out, 0, (size_t) length * sizeof *out);
+    else
+    {
+#ifdef SBC_X86_SIMD
+        done = simd_downmix(src, fmt, num_chan, chans, used_weights, num_used, out, length, d);
+#endif
+        scalar_downmix(src, size, stride, chans, used_weights, num_used, out, done, length, load_q8[fmt], d);
+    }
+
+    SBC_FREE(chans);
+    SBC_FREE(used_weights);
+}
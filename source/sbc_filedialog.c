@@ -68,10 +68,11 @@ static void add_standard_file_filters(IFileDialog* pFileDialog)
 {
     COMDLG_FILTERSPEC rgSpec[] = 
     {
-        { L"WAV Files (*.wav)", L"*.wav" },
+        { L"WAV Files (*.wav), (*.w64)", L"*.wav;*.w64" },
         { L"BRR Files (*.brr)", L"*.brr" },
         { L"IFF Files (*.iff), (*.8svx)", L"*.iff;*.8svx" },
         { L"AIF Files (*.aif), (*.aiff)", L"*.aif;*.aiff" },
+        { L"G.711 Files (*.ul), (*.al)", L"*.ul;*.al" },
         { L"All Files (*)", L"*" }
     };
     
@@ -235,10 +236,11 @@ static void add_gtk_file_filter(GtkFileChooser *chooser, const char* label, cons
 
 static void add_standard_file_filters(GtkFileChooser *chooser)
 {
-    add_gtk_file_filter(chooser, "WAV Files (*.wav)", "*.wav", NULL);
+    add_gtk_file_filter(chooser, "WAV Files (*.wav), (*.w64)", "*.wav", "*.w64");
     add_gtk_file_filter(chooser, "BRR Files (*.brr)", "*.brr", NULL);
     add_gtk_file_filter(chooser, "IFF Files (*.iff), (*.8svx)", "*.iff", "*.8svx");
     add_gtk_file_filter(chooser, "AIF Files (*.aif), (*.aiff)", "*.aif", "*.aiff");
+    add_gtk_file_filter(chooser, "G.711 Files (*.ul), (*.al)", "*.ul", "*.al");
     add_gtk_file_filter(chooser, "All Files (*)", "*", NULL);
 }
 
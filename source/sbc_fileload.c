@@ -1,35 +1,51 @@
 #include <math.h>
 
-#include "sbc_utils.h"
-#include "sbc_pitch.h"
+#if defined (_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "sbc_common.h"
 
 #include "sbc_samp_edit.h"
 #include "sbc_fileload.h"
+#include "sbc_brr_simd.h"
+#include "sbc_compand.h"
+#include "sbc_convert.h"
 
 #define LE16(a,i)       (*(uint16_t *) ((a) + i))
 #define LE32(a,i)       (*(uint32_t *) ((a) + i))
+#define LE64(a,i)       (*(uint64_t *) ((a) + i))
 
 #define BE16(a,b)       ((uint8_t)(a) <<  8 | (uint8_t)(b) <<  0)
 #define BE32(a,b,c,d)   ((uint8_t)(a) << 24 | (uint8_t)(b) << 16 | (uint8_t)(c) <<  8 | (uint8_t)(d) <<  0)
 
-#define BYTE2WORD(x)    ((int16_t) (((uint8_t) (x) << 8) | (uint8_t) (x)))
 #define CLAMP16(s)      ((int16_t) (s) == (s)) ? (int16_t) (s) : (int16_t) (INT16_MAX ^ ((s) >> 4))
 
-/* equivalent to (int16_t) round(numerator / denominator *  in) */
-#define FIXEDMATH16_16(x,n,d)   ((int16_t) (((x) * ((int64_t) (n) << 16) / (d)) >> 16))
-
 /* 
 *   converts number of bytes to number of samples as per BRR's 16 sample to 9 byte ratio 
-*   equivalent to (int) round(16.0 / 9.0 * (double) in) 
+*   equivalent to (int64_t) round(16.0 / 9.0 * (double) in) 
 */
-#define BYTEPOS2BRRPOS(x)       ((int) (((int64_t) (x) * ((16 << 16) / 9) + 0x8000) >> 16))
+#define BYTEPOS2BRRPOS(x)       ((int64_t) (((int64_t) (x) * ((16 << 16) / 9) + 0x8000) >> 16))
 
-typedef struct BrrFilter_s
-{
-    int16_t a, b, tmp[2];
-} brrfilter_t;
+/* S-DSP clamp, compiles to a pair of conditional moves */
+#define DSP_CLAMP16(s)  ((s) < INT16_MIN ? INT16_MIN : (s) > INT16_MAX ? INT16_MAX : (s))
+
+/* decodes the 16 shifted nibbles of one block, v[0] and v[1] are the last two outputs */
+typedef void (*BrrFilterKernel_t)(const int16_t *in, int16_t *out, int16_t *v);
+
+static BrrDecodeMode_t brr_decode_mode = BRR_DECODE_CLASSIC;
+static bool load_dither = false;
+
+static DownmixMode_t downmix_mode = DOWNMIX_LEFT;
+static int downmix_channel = 0, num_downmix_weights = 0;
+static float downmix_weights[DOWNMIX_MAX_WEIGHTS];
 
-static void set_loop_points(Sample_t *s, const bool enable, const int start, const int end)
+static void set_loop_points(Sample_t *s, const bool enable, const int64_t start, const int64_t end)
 {
     assert(s != NULL);
 
@@ -39,188 +55,324 @@ static void set_loop_points(Sample_t *s, const bool enable, const int start, con
     s->samp_start = 0;
 }
 
-static bool create_sample_buffer(Sample_t **s, const int sample_len)
+static bool create_sample_buffer(Sample_t *s, const int64_t sample_len)
 {
     assert(s != NULL);
     assert(sample_len > 1);
 
-    (*s) = calloc(1, sizeof(Sample_t));
+    memset(s, 0, sizeof(Sample_t));
 
-    if((*s) == NULL)
+    s->audio.length = sample_len;
+    s->audio.buffer = (uint64_t) sample_len <= SIZE_MAX / sizeof *s->audio.buffer ? 
+                      malloc((size_t) sample_len * sizeof *s->audio.buffer) : NULL;
+
+    if(s->audio.buffer == NULL)
     {
-        showErrorMsgBox("Memory allocation error", "Insufficient memory!", NULL);
+        reportError("Memory allocation error", "Insufficient memory!", NULL);
         return false;
     }
 
-    (*s)->audio.length = sample_len;
+    return true;
+}
+
+/* 
+*   number of whole frames between data_pos and the end of the file, headers are
+*   parsed in place so a chunk size that overstates the data must never be trusted
+*/
+static int64_t clamp_frames(const int64_t claimed, const int64_t data_pos, const int frame_size, const int64_t file_len)
+{
+    const int64_t available = data_pos < file_len ? (file_len - data_pos) / frame_size : 0;
+
+    return claimed < available ? claimed : available;
+}
 
-    (*s)->audio.buffer = malloc((*s)->audio.length * sizeof *(*s)->audio.buffer);
+static const uint8_t W64_RIFF_GUID[16] = { 'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+static const uint8_t W64_WAVE_GUID[16] = { 'w', 'a', 'v', 'e', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
 
-    if((*s)->audio.buffer == NULL)
+typedef enum
+{
+    CONTAINER_NONE = 0,
+    CONTAINER_RIFF,
+    CONTAINER_RF64,
+    CONTAINER_W64,
+    CONTAINER_AIFF,
+    CONTAINER_8SVX
+} container_t;
+
+/* the chunks any of the parsers read, everything else is stepped over */
+typedef enum
+{
+    CHUNK_FMT = 0,
+    CHUNK_DATA,
+    CHUNK_SMPL,
+    CHUNK_CUE,
+    CHUNK_LIST,
+    CHUNK_RIFF_INST,
+    CHUNK_DS64,
+    CHUNK_COMM,
+    CHUNK_SSND,
+    CHUNK_MARK,
+    CHUNK_INST,
+    CHUNK_VHDR,
+    CHUNK_BODY,
+    NUM_CHUNK_TYPES
+} chunk_type_t;
+
+static const char *chunk_names[NUM_CHUNK_TYPES] = 
+{ 
+    "fmt ", "data", "smpl", "cue ", "LIST", "inst", "ds64", 
+    "COMM", "SSND", "MARK", "INST", "VHDR", "BODY" 
+};
+
+/* body offset and size of the first chunk of each type, pos is -1 if the file has none */
+typedef struct Chunk_Index_s
+{
+    container_t container;
+
+    int64_t pos[NUM_CHUNK_TYPES];
+    int64_t size[NUM_CHUNK_TYPES];
+} chunk_index_t;
+
+/* every other Wave64 chunk GUID is its RIFF id followed by the same 12 bytes as 'wave' */
+static bool is_w64_chunk(const char* chunk)
+{
+    return memcmp(chunk + 4, W64_WAVE_GUID + 4, 12) == 0;
+}
+
+static bool is_w64_file(const char* file_buf, const int64_t file_len)
+{
+    return file_len >= 40 && memcmp(file_buf, W64_RIFF_GUID, 16) == 0 && memcmp(file_buf + 24, W64_WAVE_GUID, 16) == 0;
+}
+
+static container_t detect_container(const char* file_buf, const int64_t file_len)
+{
+    if(file_len < 12) return CONTAINER_NONE;
+
+    if(memcmp(file_buf + 8, "WAVE", 4) == 0)
     {
-        showErrorMsgBox("Memory allocation error", "Insufficient memory!", NULL);
-        return false;
+        if(memcmp(file_buf, "RIFF", 4) == 0) return CONTAINER_RIFF;
+        if(memcmp(file_buf, "RF64", 4) == 0 || memcmp(file_buf, "BW64", 4) == 0) return CONTAINER_RF64;
+    }
+    else if(memcmp(file_buf, "FORM", 4) == 0)
+    {
+        if(memcmp(file_buf + 8, "AIFF", 4) == 0) return CONTAINER_AIFF;
+        if(memcmp(file_buf + 8, "8SVX", 4) == 0) return CONTAINER_8SVX;
     }
 
+    return is_w64_file(file_buf, file_len) ? CONTAINER_W64 : CONTAINER_NONE;
+}
+
+static bool is_chunk_id(const char* file_buf, const int64_t file_len, const int64_t pos)
+{
+    if(pos + 4 > file_len) return false;
+
+    for(int i = 0; i < 4; i++)
+        if(file_buf[pos + i] < 0x20 || file_buf[pos + i] > 0x7E) return false;
+
     return true;
 }
 
-void load_sample_and_free(Sample_t **s)
+static chunk_type_t get_chunk_type(const char* chunk)
 {
-    assert(s != NULL && *s != NULL);
-    assert((*s)->audio.buffer != NULL);
+    int type = 0;
 
-    setSampleEdit(*s);
+    while(type < NUM_CHUNK_TYPES && memcmp(chunk, chunk_names[type], 4) != 0) type++;
 
-    SBC_FREE((*s)->audio.buffer);
-    SBC_FREE((*s));
+    return (chunk_type_t) type;
 }
 
-static int find_chunk_name(const char* haystack, const char* needle, const int len)
+/* 
+*   follows the size fields from one chunk header to the next, so a file is walked once
+*   no matter how many chunks the parser needs and chunk ids inside audio data are never matched.
+*   RIFF and IFF chunks are padded to 2 bytes, Wave64 chunks to 8 and their sizes include the
+*   24 byte header
+*/
+static void index_chunks(const char* file_buf, const int64_t file_len, chunk_index_t *index)
 {
-    const uint32_t chunk  = LE32(needle, 0);
-    const char* temp = haystack;
+    const container_t container = detect_container(file_buf, file_len);
 
-    int position = -1, bytesToRead = len;
+    const bool w64 = container == CONTAINER_W64, 
+               big_endian = container == CONTAINER_AIFF || container == CONTAINER_8SVX;
 
-    while (--bytesToRead >= 0)
+    const int64_t hdr_size = w64 ? 24 : 8, align = w64 ? 8 : 2;
+    int64_t chunk_pos = w64 ? 40 : 12;
+
+    memset(index, 0, sizeof *index);
+
+    for(int i = 0; i < NUM_CHUNK_TYPES; i++) index->pos[i] = -1;
+
+    if((index->container = container) == CONTAINER_NONE) return;
+
+    while(chunk_pos + hdr_size <= file_len)
     {
-        const uint32_t chunkTest = LE32(temp++, 0);
+        const char *chunk = file_buf + chunk_pos;
+        const int64_t body = chunk_pos + hdr_size;
+
+        chunk_type_t type = get_chunk_type(chunk);
+        uint64_t size = 0;
 
-        if(chunk == chunkTest) 
+        if(w64)
         {
-            position = (int) (temp - haystack - 1);
-            break;
+            if((size = LE64(chunk, 16)) < 24) break;
+
+            size -= 24;
+            if(!is_w64_chunk(chunk)) type = NUM_CHUNK_TYPES;
         }
-    }
+        else if(big_endian) size = (uint32_t) BE32(chunk[4], chunk[5], chunk[6], chunk[7]);
+        else size = LE32(chunk, 4);
 
-    return position;
+        /* RF64 leaves 0xFFFFFFFF in the data chunk's size, the real one is in ds64 */
+        if(container == CONTAINER_RF64 && type == CHUNK_DATA && size == UINT32_MAX && index->size[CHUNK_DS64] >= 16)
+            size = LE64(file_buf, index->pos[CHUNK_DS64] + 8);
+
+        /* truncated files keep whatever made it to disk */
+        if(size > (uint64_t) (file_len - body)) size = (uint64_t) (file_len - body);
+
+        if(type < NUM_CHUNK_TYPES && index->pos[type] < 0)
+        {
+            index->pos[type]  = body;
+            index->size[type] = (int64_t) size;
+        }
+
+        chunk_pos = body + (int64_t) ((size + (uint64_t) align - 1) & ~(uint64_t) (align - 1));
+
+        /* some writers don't pad odd sized chunks, a pad byte is always zero and never the start of an id */
+        if(!w64 && (size & 1) && chunk_pos <= file_len && file_buf[chunk_pos - 1] != 0 && is_chunk_id(file_buf, file_len, chunk_pos - 1))
+            chunk_pos--;
+    }
 }
 
-static bool find_chunks(const char* haystack, const char *chunk[], int numchunks, const int len)
+static bool rawpcmread(const char* file_buf, const int64_t file_len, Sample_t *samp_load)
 {
-    const int MAIN_CHUNK_POS = 0, SUB1_CHUNK_POS = 8, SUB2_CHUNK_POS = 12;
 
-    if(find_chunk_name(haystack, chunk[0], len) != MAIN_CHUNK_POS) return false;
-    if(find_chunk_name(haystack, chunk[1], len) != SUB1_CHUNK_POS) return false;
+    assert(file_buf != NULL);
 
-    if(numchunks < 3) return true;
+    if(!create_sample_buffer(samp_load, file_len)) return false;
 
-    if(find_chunk_name(haystack, chunk[2], len) != SUB2_CHUNK_POS)
-    {
-        if(numchunks < 4) return false;
-        if(find_chunk_name(haystack, chunk[3], len) != SUB2_CHUNK_POS) return false;
-    }
+    convertToS16(file_buf, SAMP_FMT_S8, 1, samp_load->audio.buffer, samp_load->audio.length, false);
+
+    set_loop_points(samp_load, false, 0, samp_load->audio.length);
+    samp_load->rate = 16726.0;
 
     return true;
 }
 
-static bool rawpcmread(const char* file_buf, const int file_len)
+/* 
+*   fills in one weight per channel for the current downmix mode. mono files always read
+*   their only channel, and a channel past the last one picks the last one
+*/
+static void get_downmix_weights(const int num_chan, float *weights)
 {
-    Sample_t *samp_load = NULL;
+    const int last = num_chan - 1;
 
-    assert(file_buf != NULL);
+    memset(weights, 0, (size_t) num_chan * sizeof *weights);
 
-    if(!create_sample_buffer(&samp_load, file_len)) 
+    if(num_chan == 1)
     {
-        SBC_FREE(samp_load);
-        return false;
+        weights[0] = 1.f;
+        return;
+    }
+
+    switch(downmix_mode)
+    {
+        case DOWNMIX_RIGHT:   weights[1] = 1.f; break;
+        case DOWNMIX_MID:     weights[0] = 0.5f; weights[1] =  0.5f; break;
+        case DOWNMIX_SIDE:    weights[0] = 0.5f; weights[1] = -0.5f; break;
+        case DOWNMIX_CHANNEL: weights[downmix_channel < last ? downmix_channel : last] = 1.f; break;
+
+        case DOWNMIX_WEIGHTED:
+            if(num_downmix_weights == 0) 
+            {
+                for(int c = 0; c < num_chan; c++) weights[c] = 1.f / (float) num_chan;
+            }
+            else 
+            {
+                for(int c = 0; c < num_chan && c < num_downmix_weights; c++) weights[c] = downmix_weights[c];
+            }
+            break;
+
+        case DOWNMIX_LEFT:
+        default:              weights[0] = 1.f; break;
     }
+}
 
-    for(int i = 0; i < samp_load->audio.length; i++)
-        samp_load->audio.buffer[i] = BYTE2WORD(file_buf[i]);
+/* every interleaved channel of the file goes through one downmix pass into the new buffer */
+static void downmix_channels(const char *in, const SampFormat_t fmt, const int num_chan, Sample_t *samp_load)
+{
+    float *weights = NULL;
 
-    set_loop_points(samp_load, false, 0, samp_load->audio.length);
-    samp_load->rate = 16726.0;
+    SBC_CALLOC(num_chan, sizeof *weights, weights);
+    get_downmix_weights(num_chan, weights);
 
-    load_sample_and_free(&samp_load);
-    detectCenterPitch(false);
+    downmixToS16(in, fmt, num_chan, weights, samp_load->audio.buffer, samp_load->audio.length, load_dither);
 
-    return true;
+    SBC_FREE(weights);
 }
 
-static int wavparse(const char* file_buf, const int file_len)
+/* RIFF, RF64 and Wave64 all share the same fmt, data and smpl chunk bodies */
+static int wavparse(const char* file_buf, const int64_t file_len, const chunk_index_t *index, Sample_t *samp_load)
 {
-    Sample_t *samp_load = NULL;
-    
-    int smplpos = -1, data_pos = 0;
+    const int64_t fmt_pos = index->pos[CHUNK_FMT], data_pos = index->pos[CHUNK_DATA], smpl_pos = index->pos[CHUNK_SMPL];
+
     bool loop_enable = false;
 
-    uint32_t samp_rate  = 0, new_samp_len = 0,
-             loop_start = 0, loop_end = 0;
+    uint32_t samp_rate  = 0;
+    int64_t  new_samp_len = 0, loop_start = 0, loop_end = 0;
     int16_t num_chan = 0, bit_depth = 0;
+    uint16_t fmt_tag = 0;
+    int samp_size = 0;
+
+    SampFormat_t samp_fmt = SAMP_FMT_S16LE;
 
     assert(file_buf != NULL);
 
-    if((data_pos = find_chunk_name(file_buf, "data", file_len)) > 0) data_pos += 8;
-    else return 1;
+    if(data_pos < 0) return 1;
+    if(fmt_pos < 0 || index->size[CHUNK_FMT] < 16) return -1;
 
-    num_chan         = LE16(file_buf, 22);
-    samp_rate        = LE32(file_buf, 24);
-    bit_depth        = LE16(file_buf, 34);
-    new_samp_len     = LE32(file_buf, data_pos - 4);
+    fmt_tag          = LE16(file_buf, fmt_pos + 0);
+    num_chan         = LE16(file_buf, fmt_pos + 2);
+    samp_rate        = LE32(file_buf, fmt_pos + 4);
+    bit_depth        = LE16(file_buf, fmt_pos + 14);
 
-    if(num_chan > 2) return -1;
-    else if(num_chan == 2)
-        showErrorMsgBox("Stereo WAV File", "Stereo WAV file detected. Reading from left channel...", NULL);
+    /* WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start of its sub-format GUID */
+    if(fmt_tag == 0xFFFE && index->size[CHUNK_FMT] >= 26) fmt_tag = LE16(file_buf, fmt_pos + 24);
 
-    new_samp_len /= (bit_depth / 8);
-    new_samp_len /= num_chan;
-    
-    if(!create_sample_buffer(&samp_load, new_samp_len))
+    if(num_chan < 1 || bit_depth < 8 || bit_depth > 32) return -1;
+
+    samp_size = (bit_depth + 7) / 8;
+
+    /* 3 is IEEE float, anything else is read as integer PCM */
+    if(fmt_tag == 3) 
     {
-        SBC_FREE(samp_load);
-        return false;
+        if(samp_size != 4) return -1;
+        samp_fmt = SAMP_FMT_F32LE;
     }
-    
-    for(int i = 0; i < samp_load->audio.length; i++)
-    {
-        const int n = i * num_chan;
+    else samp_fmt = (SampFormat_t[]) { SAMP_FMT_U8, SAMP_FMT_S16LE, SAMP_FMT_S24LE, SAMP_FMT_S32LE }[samp_size - 1];
 
-        if(bit_depth == 8)
-        {
-            int8_t usamp = (int8_t) (file_buf[n + data_pos] ^ 0x80);
-            samp_load->audio.buffer[i] = BYTE2WORD(usamp);
-        }
-        else if(bit_depth == 16)
-        {
-            samp_load->audio.buffer[i] = LE16(file_buf, (n * 2) + data_pos);
-        }
-        else if(bit_depth == 24)
-        {
-            samp_load->audio.buffer[i] = LE16(file_buf, (n * 3) + data_pos + 1);
-        }
-        else
-        {
-            float fsamp = *(float *) (file_buf + (n * 4));
-            samp_load->audio.buffer[i] = (int16_t) floorf(fsamp * 32767.5f);
-        }
-    }
+    new_samp_len  = index->size[CHUNK_DATA];
+    new_samp_len /= samp_size;
+    new_samp_len /= num_chan;
+
+    new_samp_len = clamp_frames(new_samp_len, data_pos, samp_size * num_chan, file_len);
+
+    if(new_samp_len < 2) return 1;
+    if(!create_sample_buffer(samp_load, new_samp_len)) return 2;
+    
+    downmix_channels(file_buf + data_pos, samp_fmt, num_chan, samp_load);
 
-    if((smplpos = find_chunk_name(file_buf, "smpl", file_len)) > -1)
+    if(smpl_pos > -1 && index->size[CHUNK_SMPL] >= 52)
     {
         loop_enable = true;
 
-        smplpos += 52;
-
-        loop_start = LE32(file_buf, smplpos + 0);
-        loop_end   = LE32(file_buf, smplpos + 4);
+        loop_start = LE32(file_buf, smpl_pos + 44);
+        loop_end   = LE32(file_buf, smpl_pos + 48);
 
         loop_end++;
 
-        if(loop_start <= 0) loop_start = 0;
-
-        if((int) loop_end > samp_load->audio.length)
-                 loop_end = samp_load->audio.length;
-
-        if((int) loop_start > samp_load->audio.length)
-        {
-            loop_start  = 0;
-            loop_end    = samp_load->audio.length;
-            loop_enable = false;
-        }
+        if(loop_end > samp_load->audio.length)
+           loop_end = samp_load->audio.length;
 
-        if(loop_end <= 0)
+        if(loop_start > samp_load->audio.length)
         {
             loop_start  = 0;
             loop_end    = samp_load->audio.length;
@@ -237,8 +389,6 @@ static int wavparse(const char* file_buf, const int file_len)
     set_loop_points(samp_load, loop_enable, loop_start, loop_end);
     samp_load->rate = (double) samp_rate;
 
-    load_sample_and_free(&samp_load);
-
     return 0;
 }
 
@@ -323,96 +473,128 @@ double ConvertFromIeeeExtended(unsigned char (*bytes)[10])
         return f;
 }
 
-static bool aifparse(const char* file_buf, const int file_len)
+/* 
+*   the INST chunk's sustain loop, its begin and end are ids of markers in the MARK chunk.
+*   each marker is an id, a frame position and a pascal string padded to an even length
+*/
+static bool get_aif_loop(const char* file_buf, const chunk_index_t *index, int64_t *loop_start, int64_t *loop_end)
+{
+    const int64_t inst_pos = index->pos[CHUNK_INST], mark_pos = index->pos[CHUNK_MARK],
+                  mark_end = mark_pos + index->size[CHUNK_MARK];
+
+    int64_t marker = mark_pos + 2;
+    int num_markers = 0, begin_id = 0, end_id = 0, found = 0;
+
+    if(inst_pos < 0 || index->size[CHUNK_INST] < 20 || mark_pos < 0 || index->size[CHUNK_MARK] < 2) return false;
+
+    /* play mode 0 is no loop */
+    if(BE16(file_buf[inst_pos + 8], file_buf[inst_pos + 9]) == 0) return false;
+
+    begin_id    = BE16(file_buf[inst_pos + 10], file_buf[inst_pos + 11]);
+    end_id      = BE16(file_buf[inst_pos + 12], file_buf[inst_pos + 13]);
+    num_markers = BE16(file_buf[mark_pos], file_buf[mark_pos + 1]);
+
+    for(int m = 0; m < num_markers && marker + 7 <= mark_end; m++)
+    {
+        const char *mk = file_buf + marker;
+
+        const int id = BE16(mk[0], mk[1]);
+        const int64_t position = (uint32_t) BE32(mk[2], mk[3], mk[4], mk[5]);
+
+        if(id == begin_id) { *loop_start = position; found |= 1; }
+        if(id == end_id)   { *loop_end   = position; found |= 2; }
+
+        marker += 6 + (((uint8_t) mk[6] + 2) & ~1);
+    }
+
+    return found == 3 && *loop_start < *loop_end;
+}
+
+static bool aifparse(const char* file_buf, const int64_t file_len, const chunk_index_t *index, Sample_t *samp_load)
 {
-    Sample_t *samp_load = NULL;
+    const int64_t comm_pos = index->pos[CHUNK_COMM], ssnd_pos = index->pos[CHUNK_SSND];
 
-    int data_pos = 0, comm_pos = 0, num_chan = 0, bit_depth = 0, new_samp_len = 0;
+    int64_t data_pos = 0, new_samp_len = 0, loop_start = 0, loop_end = 0;
+    int num_chan = 0, bit_depth = 0, samp_size = 0;
     double samp_rate = 0.0;
     uint8_t samp_rate_data[10];
+    bool loop_enable = false;
+
+    SampFormat_t samp_fmt = SAMP_FMT_S16BE;
 
     assert(file_buf != NULL);
 
-    if((comm_pos = find_chunk_name(file_buf, "COMM", file_len)) < 0) return false;
-    if((data_pos = find_chunk_name(file_buf, "SSND", file_len)) > 0) data_pos += 16;
-    else return false;
+    if(comm_pos < 0 || index->size[CHUNK_COMM] < 18) return false;
+    if(ssnd_pos < 0 || index->size[CHUNK_SSND] < 8) return false;
 
-    memset(samp_rate_data, 0, 10);
+    /* SSND body starts with the offset to the first frame and a block size */
+    data_pos         = ssnd_pos + 8 + (uint32_t) BE32(file_buf[ssnd_pos], file_buf[ssnd_pos + 1], 
+                                                     file_buf[ssnd_pos + 2], file_buf[ssnd_pos + 3]);
+    new_samp_len     = index->size[CHUNK_SSND] - (data_pos - ssnd_pos);
 
-    num_chan         = BE16(file_buf[comm_pos + 8], file_buf[comm_pos + 9]);
-    bit_depth        = BE16(file_buf[comm_pos + 14], file_buf[comm_pos + 15]);
-    new_samp_len     = BE32(file_buf[data_pos - 12], file_buf[data_pos - 11],
-                            file_buf[data_pos - 10], file_buf[data_pos -  9]);
-    new_samp_len    -= 8;
+    num_chan         = BE16(file_buf[comm_pos + 0], file_buf[comm_pos + 1]);
+    bit_depth        = BE16(file_buf[comm_pos + 6], file_buf[comm_pos + 7]);
 
-    if(file_len < comm_pos + 26) return false;
-    memcpy(samp_rate_data, (file_buf + comm_pos + 16), 10);
+    memcpy(samp_rate_data, (file_buf + comm_pos + 8), 10);
     samp_rate = ConvertFromIeeeExtended(&samp_rate_data);
 
-    if(num_chan > 2 || bit_depth > 16) return false;
-    else if(num_chan == 2)
-        showErrorMsgBox("Stereo WAV File", "Stereo WAV file detected. Reading from left channel...", NULL);
+    if(num_chan < 1 || bit_depth > 32 || bit_depth < 8) return false;
 
+    samp_size = (bit_depth + 7) / 8;
+    samp_fmt  = (SampFormat_t[]) { SAMP_FMT_S8, SAMP_FMT_S16BE, SAMP_FMT_S24BE, SAMP_FMT_S32BE }[samp_size - 1];
 
-    new_samp_len /= (bit_depth / 8);
+    new_samp_len /= samp_size;
     new_samp_len /= num_chan;
-    
-    if(!create_sample_buffer(&samp_load, new_samp_len))
-    {
-        SBC_FREE(samp_load);
-        return false;
-    }
 
-    for(int i = 0; i < samp_load->audio.length; i++)
+    new_samp_len = clamp_frames(new_samp_len, data_pos, samp_size * num_chan, file_len);
+
+    if(new_samp_len < 2) return false;
+    if(!create_sample_buffer(samp_load, new_samp_len)) return false;
+
+    downmix_channels(file_buf + data_pos, samp_fmt, num_chan, samp_load);
+
+    if(get_aif_loop(file_buf, index, &loop_start, &loop_end) && loop_start < samp_load->audio.length)
     {
-        const int n = i * num_chan;
+        loop_enable = true;
 
-        if(bit_depth == 8)
-        {
-            samp_load->audio.buffer[i] = BYTE2WORD(file_buf[n + data_pos]);
-        }
-        else
-        {
-            int d = (n * 2) + data_pos;
-            samp_load->audio.buffer[i] = BE16(file_buf[d], file_buf[d + 1]);
-        }
+        if(loop_end > samp_load->audio.length)
+           loop_end = samp_load->audio.length;
+    }
+    else
+    {
+        loop_start  = 0;
+        loop_end    = samp_load->audio.length;
     }
 
-    set_loop_points(samp_load, false, 0, samp_load->audio.length);
+    set_loop_points(samp_load, loop_enable, loop_start, loop_end);
     samp_load->rate = samp_rate;
 
-    load_sample_and_free(&samp_load);
-
     return true;
 }
 
-static bool iffparse(const char* file_buf, const int file_len)
+static bool iffparse(const char* file_buf, const int64_t file_len, const chunk_index_t *index, Sample_t *samp_load)
 {
-    Sample_t *samp_load = NULL;
+    const int64_t vhdr_pos = index->pos[CHUNK_VHDR], data_pos = index->pos[CHUNK_BODY];
 
-    int data_pos = 0, samp_rate = 0, new_samp_len = 0, loop_start = 0, loop_end = 0;;
+    int64_t new_samp_len = 0, loop_start = 0, loop_end = 0;
+    int samp_rate = 0;
     bool loop_enable = false;
 
     assert(file_buf != NULL);
 
-    if((data_pos = find_chunk_name(file_buf, "BODY", file_len)) > 0) data_pos += 8;
-    else return false;
+    if(vhdr_pos < 0 || index->size[CHUNK_VHDR] < 14 || data_pos < 0) return false;
 
-    samp_rate        = BE16(file_buf[0x20], file_buf[0x21]);
-    new_samp_len     = BE32(file_buf[data_pos - 4], file_buf[data_pos - 3],
-                            file_buf[data_pos - 2], file_buf[data_pos - 1]);
-    
-    if(!create_sample_buffer(&samp_load, new_samp_len))
-    {
-        SBC_FREE(samp_load);
-        return false;
-    }
+    /* VHDR: one shot length, repeat length, samples per cycle, then the rate */
+    samp_rate        = BE16(file_buf[vhdr_pos + 12], file_buf[vhdr_pos + 13]);
+    new_samp_len     = clamp_frames(index->size[CHUNK_BODY], data_pos, 1, file_len);
+
+    if(new_samp_len < 2) return false;
+    if(!create_sample_buffer(samp_load, new_samp_len)) return false;
 
-    for(int i = 0; i < samp_load->audio.length; i++)
-            samp_load->audio.buffer[i] = BYTE2WORD(file_buf[i + data_pos]);
+    convertToS16(file_buf + data_pos, SAMP_FMT_S8, 1, samp_load->audio.buffer, samp_load->audio.length, false);
 
-    loop_start = BE32(file_buf[20], file_buf[21], file_buf[22], file_buf[23]);
-    loop_end   = BE32(file_buf[24], file_buf[25], file_buf[26], file_buf[27]);
+    loop_start = (uint32_t) BE32(file_buf[vhdr_pos + 0], file_buf[vhdr_pos + 1], file_buf[vhdr_pos + 2], file_buf[vhdr_pos + 3]);
+    loop_end   = (uint32_t) BE32(file_buf[vhdr_pos + 4], file_buf[vhdr_pos + 5], file_buf[vhdr_pos + 6], file_buf[vhdr_pos + 7]);
 
     if(loop_start > samp_load->audio.length)
     {
@@ -435,14 +617,11 @@ static bool iffparse(const char* file_buf, const int file_len)
     set_loop_points(samp_load, loop_enable, loop_start, loop_end);
     samp_load->rate = (double) samp_rate;
 
-    load_sample_and_free(&samp_load);
-
     return true;
 }
 
-static bool vcparse(const char* file_buf, const int file_len)
+static bool vcparse(const char* file_buf, const int64_t file_len, Sample_t *samp_load)
 {
-    Sample_t *samp_load = NULL;
 
     int data_pos = 0x1500, new_samp_len = 0x4000, loop_start = 0, loop_end = new_samp_len;
     bool loop_enable = false;
@@ -451,14 +630,9 @@ static bool vcparse(const char* file_buf, const int file_len)
 
     if(data_pos + new_samp_len >= file_len) return false;
 
-    if(!create_sample_buffer(&samp_load, new_samp_len))
-    {
-        SBC_FREE(samp_load);
-        return false;
-    }
+    if(!create_sample_buffer(samp_load, new_samp_len)) return false;
     
-    for(int i = 0; i < samp_load->audio.length; i++)
-        samp_load->audio.buffer[i] = BYTE2WORD(file_buf[i + data_pos]);
+    convertToS16(file_buf + data_pos, SAMP_FMT_S8, 1, samp_load->audio.buffer, samp_load->audio.length, false);
 
     if(file_buf[0x133B])
     {
@@ -491,97 +665,220 @@ static bool vcparse(const char* file_buf, const int file_len)
     set_loop_points(samp_load, loop_enable, loop_start, loop_end);
     samp_load->rate = 16744.0;
 
-    load_sample_and_free(&samp_load);
-
     return true;
 }
 
-static bool mulawdecode(const char* file_buf, const int file_len)
+/* only the last extension counts, ".al" turns up in too many directory names */
+static bool has_extension(const char *name, const char *ext)
 {
-    Sample_t *samp_load = NULL;
+    const char *dot = strrchr(name, '.');
+    return dot != NULL && strcasecmp(dot, ext) == 0;
+}
 
+/* drum machine ROM dumps default to 22050Hz, G.711 to telephone rate */
+static bool mulawdecode(const char* file_buf, const int64_t file_len, const CompandCurve_t curve, Sample_t *samp_load)
+{
     assert(file_buf != NULL);
 
-    if(!create_sample_buffer(&samp_load, file_len))
+    if(!create_sample_buffer(samp_load, file_len)) return false;
+
+    expandToS16((const uint8_t*) file_buf, samp_load->audio.buffer, samp_load->audio.length, curve);
+
+    set_loop_points(samp_load, false, 0, samp_load->audio.length);
+    samp_load->rate = curve == COMPAND_LINN ? 22050. : 8000.;
+
+    return true;
+}
+
+/*
+*   one kernel per filter, each coefficient is floor(v * numerator / denominator)
+*   truncated to 16 bits: 15/16 for filter 1, 61/32 and 15/16 for filter 2,
+*   115/64 and 13/16 for filter 3
+*/
+static void brr_filter_0(const int16_t *in, int16_t *out, int16_t *v)
+{
+    memcpy(out, in, 16 * sizeof *out);
+
+    v[1] = out[14];
+    v[0] = out[15];
+}
+
+static void brr_filter_1(const int16_t *in, int16_t *out, int16_t *v)
+{
+    int16_t v0 = v[0], v1 = v[1];
+
+    for(int i = 0; i < 16; i++)
     {
-        SBC_FREE(samp_load);
-        return false;
+        const int16_t a = (int16_t) ((v0 * 15) >> 4);
+
+        v1 = v0;
+        v0 = out[i] = (int16_t) (in[i] + a);
+    }
+
+    v[0] = v0;
+    v[1] = v1;
+}
+
+static void brr_filter_2(const int16_t *in, int16_t *out, int16_t *v)
+{
+    int16_t v0 = v[0], v1 = v[1];
+
+    for(int i = 0; i < 16; i++)
+    {
+        const int16_t a = (int16_t) ((v0 * 61) >> 5),
+                      b = (int16_t) ((v1 * 15) >> 4);
+
+        v1 = v0;
+        v0 = out[i] = (int16_t) (in[i] + a - b);
     }
 
-    for(int i = 0; i < samp_load->audio.length; i++)
+    v[0] = v0;
+    v[1] = v1;
+}
+
+static void brr_filter_3(const int16_t *in, int16_t *out, int16_t *v)
+{
+    int16_t v0 = v[0], v1 = v[1];
+
+    for(int i = 0; i < 16; i++)
     {
-        double   temp_decode = (file_buf[i] & 0x80) ? 1.0 : -1.0;
-        int32_t temp_samp = 0;
+        const int16_t a = (int16_t) ((v0 * 115) >> 6),
+                      b = (int16_t) ((v1 *  13) >> 4);
 
-        temp_decode *= pow(256, (double)(file_buf[i] & 0x7F) / 127) - 1;
-        temp_decode /= 255;
+        v1 = v0;
+        v0 = out[i] = (int16_t) (in[i] + a - b);
+    }
 
-        temp_samp = (int32_t)round(temp_decode * INT16_MAX);
+    v[0] = v0;
+    v[1] = v1;
+}
+
+static const BrrFilterKernel_t brr_filter_kernel[4] = { brr_filter_0, brr_filter_1, brr_filter_2, brr_filter_3 };
 
-        samp_load->audio.buffer[i] = CLAMP16(temp_samp);
+static void unpack_brr_nibbles(const uint8_t *data, const int shift, int16_t *out)
+{
+    if(brrSimdUnpackBlock(data, shift, out)) return;
+
+    for(int i = 0; i < 8; i++)
+    {
+        out[i * 2 + 0] = (int16_t) (((int8_t) data[i] >> 4) * (1 << shift));
+        out[i * 2 + 1] = (int16_t) (((int8_t) (data[i] << 4) >> 4) * (1 << shift));
     }
+}
 
-    set_loop_points(samp_load, false, 0, samp_load->audio.length);
-    samp_load->rate = 22050.;
+/*
+*   S-DSP kernels, the same integer pipeline as the SNES: the history is kept doubled,
+*   p2 is halved before use, every sum is clamped to 16 bits and then doubled with
+*   wraparound, so the output only ever has 15 bits of precision
+*/
+static void brr_dsp_filter_0(const int16_t *in, int16_t *out, int16_t *v)
+{
+    for(int i = 0; i < 16; i++)
+        out[i] = (int16_t) (in[i] * 2);
 
-    load_sample_and_free(&samp_load);
+    v[1] = out[14];
+    v[0] = out[15];
+}
 
-    return true;
+static void brr_dsp_filter_1(const int16_t *in, int16_t *out, int16_t *v)
+{
+    int v0 = v[0], v1 = v[1];
+
+    for(int i = 0; i < 16; i++)
+    {
+        int s = in[i] + (v0 >> 1) + ((-v0) >> 5);
+
+        s  = DSP_CLAMP16(s);
+        v1 = v0;
+        v0 = out[i] = (int16_t) (s * 2);
+    }
+
+    v[0] = (int16_t) v0;
+    v[1] = (int16_t) v1;
 }
 
-static void set_brr_coeff(brrfilter_t* f, char type)
+static void brr_dsp_filter_2(const int16_t *in, int16_t *out, int16_t *v)
 {
-    switch (type)
+    int v0 = v[0], v1 = v[1];
+
+    for(int i = 0; i < 16; i++)
     {
-    case 1:
-        f->a = FIXEDMATH16_16(f->tmp[0], 15, 16);
-        f->b = 0;
-        break; 
-                    
-    case 2:      
-        f->a = FIXEDMATH16_16(f->tmp[0], 61, 32);
-        f->b = FIXEDMATH16_16(f->tmp[1], 15, 16);
-        break;
-                    
-    case 3:
-        f->a = FIXEDMATH16_16(f->tmp[0], 115, 64);
-        f->b = FIXEDMATH16_16(f->tmp[1],  13, 16);
-        break;
+        const int p2 = v1 >> 1;
+        int s = in[i] + v0 - p2 + (p2 >> 4) + ((v0 * -3) >> 6);
 
-    default:
-        f->a = f->b = 0;
-        break;
+        s  = DSP_CLAMP16(s);
+        v1 = v0;
+        v0 = out[i] = (int16_t) (s * 2);
     }
+
+    v[0] = (int16_t) v0;
+    v[1] = (int16_t) v1;
 }
 
-static void filter_brr(brrfilter_t* f, const int16_t shifted_samp, int16_t *sample)
+static void brr_dsp_filter_3(const int16_t *in, int16_t *out, int16_t *v)
 {
-    const int16_t out = shifted_samp + f->a - f->b;
+    int v0 = v[0], v1 = v[1];
 
-    f->tmp[1] = f->tmp[0];
-    f->tmp[0] = out;
-    *sample = out;
+    for(int i = 0; i < 16; i++)
+    {
+        const int p2 = v1 >> 1;
+        int s = in[i] + v0 - p2 + ((v0 * -13) >> 7) + ((p2 * 3) >> 4);
+
+        s  = DSP_CLAMP16(s);
+        v1 = v0;
+        v0 = out[i] = (int16_t) (s * 2);
+    }
+
+    v[0] = (int16_t) v0;
+    v[1] = (int16_t) v1;
 }
 
-static bool brrdecode(const char* file_buf, const int file_len)
+static const BrrFilterKernel_t brr_dsp_filter_kernel[4] = { brr_dsp_filter_0, brr_dsp_filter_1, brr_dsp_filter_2, brr_dsp_filter_3 };
+
+void decodeBrrBlock(const uint8_t *block, int16_t *out, int16_t *v, const BrrDecodeMode_t mode)
 {
-    Sample_t *samp_load = NULL;
-    int16_t *src_buffer = NULL;
+    const int shift  = block[0] >> 4,
+              filter = (block[0] >> 2) & 3;
 
-    assert(file_buf != NULL);
+    int16_t shifted[16];
+
+    assert(block != NULL && out != NULL && v != NULL);
+
+    unpack_brr_nibbles(block + 1, shift > 12 ? 12 : shift, shifted);
+
+    if(mode == BRR_DECODE_CLASSIC)
+    {
+        brr_filter_kernel[filter](shifted, out, v);
+        return;
+    }
+
+    /* 
+    *   the S-DSP halves (nibble << shift), and shifts of 13-15 give -2048 for negative
+    *   nibbles and 0 otherwise. nibble << 12 >> 15 is -1 or 0, so both cases are one
+    *   shift pair picked per block
+    */
+    {
+        const int down = shift > 12 ? 15 : 1, up = shift > 12 ? 11 : 0;
+
+        for(int i = 0; i < 16; i++)
+            shifted[i] = (int16_t) ((shifted[i] >> down) * (1 << up));
+    }
+
+    brr_dsp_filter_kernel[filter](shifted, out, v);
+}
 
-    int data_pos = 0, end_pos = file_len, new_samp_len = 0, loop_start = 0, loop_end = 0;
-    char filter_flag = 0, shifter = 0;
+static bool brrdecode(const char* file_buf, const int64_t file_len, Sample_t *samp_load)
+{
+    int64_t data_pos = 0, num_blocks = 0, loop_start = 0, loop_end = 0;
+    bool loop_enable = false;
 
-    bool loop_enable = false, loopFlag = false, endFlag = false;
+    int16_t v[2] = { 0, 0 };
 
-    int16_t temp_samp;
-    brrfilter_t brrfilter;
+    assert(file_buf != NULL);
 
     if (file_len % 9 == 0)
     {
         data_pos = 0;
-        new_samp_len = BYTEPOS2BRRPOS(file_len);
 
         loop_enable = false;
         loop_start  = 0;
@@ -593,197 +890,279 @@ static bool brrdecode(const char* file_buf, const int file_len)
         loop_start  = BYTEPOS2BRRPOS(LE16(file_buf, 0));
 
         data_pos = 2;
-        new_samp_len = BYTEPOS2BRRPOS(file_len - 2);
     }
     else return false;
 
-    if(!create_sample_buffer(&samp_load, new_samp_len))
-    {
-        SBC_FREE(samp_load);
-        return false;
-    }
-
-    memset(&brrfilter, 0, sizeof(brrfilter_t));
-    memset(samp_load->audio.buffer, 0, samp_load->audio.length * sizeof *samp_load->audio.buffer);
+    if((num_blocks = (file_len - data_pos) / 9) < 1) return false;
 
-    src_buffer = (int16_t*) samp_load->audio.buffer;
+    if(!create_sample_buffer(samp_load, num_blocks * 16)) return false;
 
-    for(int i = 0; i < file_len - data_pos; i++)
+    for(int64_t block = 0; block < num_blocks; block++)
     {
-        const uint8_t in_byte = (uint8_t) file_buf[i + data_pos];
-
-        if (i % 9 == 0)
-        {
-            shifter = (in_byte & ~0x0F) >> 4;
-            if (shifter > 12) shifter = 12;
-
-            filter_flag = (in_byte & ~0xF3) >> 2;
-            if (filter_flag > 3) filter_flag = 3;
+        const uint8_t *in_block = (const uint8_t*) file_buf + data_pos + block * 9;
 
-            loopFlag = (in_byte & 0x02) ? true : false;
+        decodeBrrBlock(in_block, samp_load->audio.buffer + block * 16, v, brr_decode_mode);
 
-            if (in_byte & 0x01)
+        if (in_block[0] & 0x01)
+        {
+            if (in_block[0] & 0x02)
             {
-                endFlag = true;
-                end_pos = i + data_pos;
-
-                if (loopFlag && endFlag)
-                {
-                    loop_enable = true;
-                    loop_end = BYTEPOS2BRRPOS(end_pos + 7);
-                }
-                else
-                {
-                    loop_enable = false;
-                    loop_start = 16;
-                    loop_end = new_samp_len;
-                }
+                loop_enable = true;
+                loop_end = BYTEPOS2BRRPOS(data_pos + block * 9 + 7);
             }
             else
             {
-                end_pos = file_len;
+                loop_enable = false;
+                loop_start = 16;
+                loop_end = samp_load->audio.length;
             }
         }
+    }
 
-        else if (i % 9 != 0 && shifter <= 12)
-        {
-            char nibble = ((in_byte & ~0x0F) >> 4);
-            if (nibble > 7) nibble ^= -16;
+    set_loop_points(samp_load, loop_enable, loop_start, loop_end);
+
+    samp_load->rate = 16744.0;
+
+    return true;
+}
 
-            set_brr_coeff(&brrfilter, filter_flag);
-            filter_brr(&brrfilter, nibble << shifter, &temp_samp);
+/* 
+*   maps the whole file read-only so the parsers below can work on it in place,
+*   returns NULL for anything that can't be mapped (empty files, pipes, too big for the address space)
+*/
+static const char *map_sample_file(const char* file_path, int64_t *file_len)
+{
+    const char *file_buf = NULL;
 
-            *src_buffer++ = i + data_pos <= end_pos + 8 ? temp_samp : 0;
+#if defined (_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = NULL;
+    LARGE_INTEGER size;
 
-            nibble = (in_byte & ~0xF0);
-            if (nibble > 7) nibble ^= -16;
+    file = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE) return NULL;
 
-            set_brr_coeff(&brrfilter, filter_flag);
-            filter_brr(&brrfilter, nibble << shifter, &temp_samp);
+    if(GetFileSizeEx(file, &size) && size.QuadPart > 1 && (uint64_t) size.QuadPart <= SIZE_MAX)
+    {
+        if((mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
+        {
+            file_buf  = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            *file_len = (int64_t) size.QuadPart;
 
-            *src_buffer++ = i + data_pos <= end_pos + 8 ? temp_samp : 0;
+            /* the view keeps the mapping alive */
+            CloseHandle(mapping);
         }
     }
 
-    set_loop_points(samp_load, loop_enable, loop_start, loop_end);
+    CloseHandle(file);
+#else
+    struct stat sb;
+    void *view = MAP_FAILED;
+    int fd = -1;
 
-    samp_load->rate = 16744.0;
+    if((fd = open(file_path, O_RDONLY)) < 0) return NULL;
 
-    load_sample_and_free(&samp_load);
+    if(fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 1 && (uint64_t) sb.st_size <= SIZE_MAX)
+    {
+        if((view = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
+        {
+            madvise(view, (size_t) sb.st_size, MADV_SEQUENTIAL);
 
-    detectCenterPitch(false);
+            file_buf  = (const char*) view;
+            *file_len = (int64_t) sb.st_size;
+        }
+    }
 
-    return true;
+    close(fd);
+#endif
+
+    return file_buf;
+}
+
+static void unmap_sample_file(const char *file_buf, const int64_t file_len)
+{
+#if defined (_WIN32)
+    (void) file_len;
+    UnmapViewOfFile(file_buf);
+#else
+    munmap((void*) file_buf, (size_t) file_len);
+#endif
 }
 
-int loadFile(const char* file_path)
+/* fallback for files that can't be mapped */
+static char *read_sample_file(const char* file_path, int64_t *file_len)
 {
     char * file_buf = NULL;
-    int file_len = 0, sample_loaded = 1;
+    long len = 0;
+
+    FILE *fd = NULL;
+
+    if((fd = fopen(file_path, "rb")) == NULL)
+    {
+        reportError("Error 404", "File not found!", NULL);
+        return NULL;
+    }
 
-	FILE *fd = NULL;
+    fseek(fd, 0, SEEK_END);
+    len = ftell(fd);
+    rewind(fd);
 
-    if(file_path == NULL) return 0;
+    if(len <= 1)
+    {
+        fclose(fd);
+        return NULL;
+    }
 
-	fd = fopen(file_path, "rb");
+    if((file_buf = malloc((size_t) len * sizeof *file_buf)) != NULL)
+    {
+        if(fread(file_buf, 1, (size_t) len, fd) != (size_t) len)
+        {
+            reportError("File Read Error", "Cannot read file!", NULL);
+            SBC_FREE(file_buf);
+        }
+    }
 
-	if (fd == NULL)
-	{
-        showErrorMsgBox("Error 404", "File not found!", NULL);
-		return 0;
-	}
+    fclose(fd);
 
-	fseek(fd, 0, SEEK_END);
-	file_len = (int) ftell(fd);
-	rewind(fd);
+    *file_len = (int64_t) len;
 
-	file_buf = malloc(file_len * sizeof *file_buf);
+    return file_buf;
+}
 
-	if (file_buf)
-	{
-		if (fread(file_buf, 1, file_len, fd) != (size_t) file_len)
-		{
-            showErrorMsgBox("File Read Error", "Cannot read file!", NULL);
-            SBC_FREE(file_buf);
-            fclose(fd);
-            return 0;
-		}
-	}
-    else
+SampFileType_t readSampleFile(const char* file_path, Sample_t *samp)
+{
+    const char *mapped_buf = NULL;
+    char *file_buf = NULL;
+
+    int64_t file_len = 0;
+    SampFileType_t file_type = SAMP_FILE_ERROR;
+
+    assert(samp != NULL);
+
+    memset(samp, 0, sizeof(Sample_t));
+
+    if(file_path == NULL) return SAMP_FILE_ERROR;
+
+    if((mapped_buf = map_sample_file(file_path, &file_len)) != NULL)
     {
-        fclose(fd);
-        return 0;
+        file_type = decodeSampleBuffer(mapped_buf, file_len, file_path, samp);
+        unmap_sample_file(mapped_buf, file_len);
+
+        return file_type;
     }
 
-    fclose(fd);
+    if((file_buf = read_sample_file(file_path, &file_len)) == NULL) return SAMP_FILE_ERROR;
 
-    if(find_chunks(file_buf, (const char*[]){"RIFF", "WAVE", "fmt ", "JUNK"}, 4, file_len))
+    file_type = decodeSampleBuffer(file_buf, file_len, file_path, samp);
+
+    SBC_FREE(file_buf);
+
+    return file_type;
+}
+
+SampFileType_t decodeSampleBuffer(const char* file_buf, const int64_t file_len, const char* name_hint, Sample_t *samp)
+{
+    SampFileType_t file_type = SAMP_FILE_ERROR;
+    chunk_index_t index;
+
+    assert(samp != NULL);
+
+    memset(samp, 0, sizeof(Sample_t));
+
+    if(file_buf == NULL || file_len <= 1) return SAMP_FILE_ERROR;
+    if(name_hint == NULL) name_hint = "";
+
+    index_chunks(file_buf, file_len, &index);
+
+    if(index.container == CONTAINER_RIFF || index.container == CONTAINER_RF64 || index.container == CONTAINER_W64)
     {
         int success = 0;
 
-        if((success = wavparse(file_buf, file_len)) != 0)
+        if((success = wavparse(file_buf, file_len, &index, samp)) != 0)
         {
-            if(success < 2) showErrorMsgBox("WAV File Error!", success == 1 ?  
+            if(success < 2) reportError("WAV File Error!", success == 1 ?  
                                             "\'data\' chunk not found!" : 
                                             "Channel format not supported!", NULL);
-            sample_loaded = 0;
-        }            
+        }
+        else file_type = SAMP_FILE_WAV;
     }
     
-    else if(find_chunks(file_buf, (const char*[]){"FORM", "AIFF"}, 2, file_len))
+    else if(index.container == CONTAINER_AIFF)
     {
-        if(!aifparse(file_buf, file_len))
-        {
-            printf("Error reading AIF samples!\n");
-            sample_loaded = 0;
-        }
+        if(!aifparse(file_buf, file_len, &index, samp)) printf("Error reading AIF samples!\n");
+        else file_type = SAMP_FILE_AIFF;
     } 
     
-    else if(find_chunks(file_buf, (const char*[]){"FORM", "8SVX", "VHDR"}, 3, file_len))
+    else if(index.container == CONTAINER_8SVX)
     {
-        if(!iffparse(file_buf, file_len))
-        {
-            printf("Error reading IFF samples!\n");
-            sample_loaded = 0;
-        }
+        if(!iffparse(file_buf, file_len, &index, samp)) printf("Error reading IFF samples!\n");
+        else file_type = SAMP_FILE_IFF;
     }
     
-    else if(_strcasestr(file_path, ".vc"))
+    /* the rest have no header to go by */
+    else if(_strcasestr(name_hint, ".vc"))
     {
-        if(!vcparse(file_buf, file_len))
-        {
-            printf("Error reading VC samples!\n");
-            sample_loaded = 0;
-        }
+        if(!vcparse(file_buf, file_len, samp)) printf("Error reading VC samples!\n");
+        else file_type = SAMP_FILE_VC;
     }
-    else if(_strcasestr(file_path, ".brr"))
+    else if(_strcasestr(name_hint, ".brr"))
     {
-        if(!brrdecode(file_buf, file_len))
-        {
-            printf("Error reading BRR samples!\n");
-            sample_loaded = 0;
-        }
+        if(!brrdecode(file_buf, file_len, samp)) printf("Error reading BRR samples!\n");
+        else file_type = SAMP_FILE_BRR;
     }
 
-    else if(_strcasestr(file_path, ".bin") || _strcasestr(file_path, ".eii"))
+    else if(_strcasestr(name_hint, ".bin") || _strcasestr(name_hint, ".eii"))
     {
-        if(!mulawdecode(file_buf, file_len))
-        {
-                printf("Error reading MuLAW samples!\n");
-                sample_loaded = 0;
-        }
+        if(!mulawdecode(file_buf, file_len, getBinCurve(), samp)) printf("Error reading MuLAW samples!\n");
+        else file_type = getBinCurve() == COMPAND_ALAW ? SAMP_FILE_ALAW : SAMP_FILE_MULAW;
+    }
+    else if(has_extension(name_hint, ".ul") || has_extension(name_hint, ".ulaw"))
+    {
+        if(!mulawdecode(file_buf, file_len, COMPAND_ULAW, samp)) printf("Error reading MuLAW samples!\n");
+        else file_type = SAMP_FILE_MULAW;
+    }
+    else if(has_extension(name_hint, ".al") || has_extension(name_hint, ".alaw"))
+    {
+        if(!mulawdecode(file_buf, file_len, COMPAND_ALAW, samp)) printf("Error reading A-Law samples!\n");
+        else file_type = SAMP_FILE_ALAW;
     }
 
     else
     {
-        if(!rawpcmread(file_buf, file_len))
-        {
-            printf("Error reading RAW samples!\n");
-            sample_loaded = 0;
-        }
+        if(!rawpcmread(file_buf, file_len, samp)) printf("Error reading RAW samples!\n");
+        else file_type = SAMP_FILE_RAW;
     }
 
-    SBC_FREE(file_buf);
+    if(file_type == SAMP_FILE_ERROR)
+    {
+        SBC_FREE(samp->audio.buffer);
+    }
+
+    return file_type;
+}
+
+BrrDecodeMode_t getBrrDecodeMode(void) { return brr_decode_mode; }
+void setBrrDecodeMode(const BrrDecodeMode_t mode) { brr_decode_mode = mode; }
+
+bool getLoadDither(void) { return load_dither; }
+void setLoadDither(const bool dither) { load_dither = dither; }
+
+DownmixMode_t getDownmixMode(void) { return downmix_mode; }
+void setDownmixMode(const DownmixMode_t mode) { downmix_mode = mode < NUM_DOWNMIX_MODES ? mode : DOWNMIX_LEFT; }
+
+int getDownmixChannel(void) { return downmix_channel; }
+void setDownmixChannel(const int channel) { downmix_channel = channel < 0 ? 0 : channel; }
+
+int getDownmixWeights(float *weights, const int max_weights)
+{
+    for(int c = 0; c < num_downmix_weights && c < max_weights; c++) weights[c] = downmix_weights[c];
+    return num_downmix_weights;
+}
+
+/* non-finite weights are dropped to 0 so a bad conf line can't turn a file into noise */
+void setDownmixWeights(const float *weights, const int num_weights)
+{
+    num_downmix_weights = num_weights < DOWNMIX_MAX_WEIGHTS ? num_weights : DOWNMIX_MAX_WEIGHTS;
+    if(num_downmix_weights < 0) num_downmix_weights = 0;
 
-    return sample_loaded;
+    for(int c = 0; c < num_downmix_weights; c++) downmix_weights[c] = isfinite(weights[c]) ? weights[c] : 0.f;
 }
@@ -1,9 +1,22 @@
 #include <stdlib.h>
 #include <math.h>
-
-#include "sbc_utils.h"
+#include <fcntl.h>
+#include <stdatomic.h>
+
+#if defined (_WIN32)
+#include <Windows.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "sbc_common.h"
 #include "sbc_samp_edit.h"
 #include "sbc_filesave.h"
+#include "sbc_brr_simd.h"
+#include "sbc_compand.h"
+#include "sbc_threadpool.h"
 
 #define BE16(a)     (uint16_t) (((a) & 0xFF00) >>  8 | ((a) & 0x00FF) << 8 ) 
 
@@ -12,9 +25,135 @@
 
 /* 
 *   converts number of samples to number of bytes as per BRR's 16 sample to 9 byte ratio 
-*   equivalent to (int) round(9.0 * (double) in / 16) 
+*   equivalent to (int64_t) round(9.0 * (double) in / 16) 
 */
-#define BRRPOS2BYTEPOS(x)       ((int) (((9 * (((int64_t) (x) << 16) / 16)) + 0x8000) >> 16))
+#define BRRPOS2BYTEPOS(x)       ((int64_t) (((9 * (((int64_t) (x) << 16) / 16)) + 0x8000) >> 16))
+
+#define BRR_CANDIDATES      52      /* 13 shifts x 4 filters */
+#define BRR_BEAM_DEPTH      8       /* blocks of lookahead before the quality encoder commits a block */
+#define BRR_MAX_BEAM_WIDTH  64
+
+#define OUT_BLOCK_SIZE      (1 << 20)   /* bytes gathered before each write to the output file */
+#define OUT_TEMP_TRIES      16          /* names tried before giving up on creating a temp file */
+
+static BrrEncodeMode_t brr_encode_mode = BRR_ENCODE_FAST;
+static int brr_beam_width = 8, brr_time_budget = 500;
+
+/* numbers every temp file this process makes, so no two exports ever write to the same one */
+static _Atomic unsigned int temp_count = 0;
+
+/* 
+*   every format is written through one of these, headers and converted samples are
+*   gathered in block and reach the file OUT_BLOCK_SIZE bytes at a time instead of one
+*   sample per fwrite. file is a temp file next to the real one, see writeSampleFile
+*/
+typedef struct Out_File_s
+{
+    FILE *file;
+    uint8_t *block;
+    size_t used;
+} out_file_t;
+
+/* how the samples are stored in the file */
+typedef enum
+{
+    OUT_S16 = 0,    /* as they are in memory */
+    OUT_S16BE,
+    OUT_U8,
+    OUT_S8,
+    OUT_LINN,       /* OUT_LINN + CompandCurve_t */
+    OUT_ULAW,
+    OUT_ALAW
+} out_fmt_t;
+
+static bool out_flush(out_file_t *out)
+{
+    const size_t used = out->used;
+
+    out->used = 0;
+
+    return used == 0 || fwrite(out->block, 1, used, out->file) == used;
+}
+
+static bool out_write(out_file_t *out, const void *data, size_t len)
+{
+    const uint8_t *src = (const uint8_t*) data;
+
+    /* anything bigger than a block would only be copied for nothing */
+    if(len >= OUT_BLOCK_SIZE) return out_flush(out) && fwrite(src, 1, len, out->file) == len;
+
+    while(len > 0)
+    {
+        size_t n = OUT_BLOCK_SIZE - out->used;
+
+        if(n == 0)
+        {
+            if(!out_flush(out)) return false;
+            continue;
+        }
+
+        if(n > len) n = len;
+
+        memcpy(out->block + out->used, src, n);
+
+        out->used += n;
+        src += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+/* converts length samples straight into the block, a block's worth at a time */
+static bool out_samples(out_file_t *out, const int16_t *in, int64_t length, const out_fmt_t fmt)
+{
+    const size_t samp_size = (fmt == OUT_S16 || fmt == OUT_S16BE) ? 2 : 1;
+
+    if(fmt == OUT_S16) return out_write(out, in, (size_t) length * samp_size);
+
+    while(length > 0)
+    {
+        const int64_t room = (int64_t) ((OUT_BLOCK_SIZE - out->used) / samp_size),
+                      n = length < room ? length : room;
+
+        uint8_t *dst = out->block + out->used;
+
+        if(n == 0)
+        {
+            if(!out_flush(out)) return false;
+            continue;
+        }
+
+        switch(fmt)
+        {
+        case OUT_S16BE:
+            for(int64_t i = 0; i < n; i++)
+            {
+                dst[2 * i]     = (uint8_t) ((uint16_t) in[i] >> 8);
+                dst[2 * i + 1] = (uint8_t) in[i];
+            }
+            break;
+
+        case OUT_U8:
+            for(int64_t i = 0; i < n; i++) dst[i] = (uint8_t) ((in[i] >> 8) ^ 0x80);
+            break;
+
+        case OUT_S8:
+            for(int64_t i = 0; i < n; i++) dst[i] = (uint8_t) (in[i] >> 8);
+            break;
+
+        default:
+            compressFromS16(in, dst, n, (CompandCurve_t) (fmt - OUT_LINN));
+            break;
+        }
+
+        out->used += (size_t) n * samp_size;
+        in += n;
+        length -= n;
+    }
+
+    return true;
+}
 
 static uint32_t get_chunk_id(const char *chunk_name)
 {
@@ -22,7 +161,50 @@ static uint32_t get_chunk_id(const char *chunk_name)
     return *(uint32_t*) chunk_name;
 }
 
-static bool write_wav_hdr(FILE *out_file, const Sample_t *samp)
+#pragma pack(push,1)
+/* fmt chunk body, shared by RIFF, RF64 and Wave64 */
+typedef struct Wav_Fmt_s
+{
+    uint16_t comp_type;
+    uint16_t num_chan;
+    uint32_t samp_per_sec;
+    uint32_t byte_per_sec;
+    uint16_t block_align;
+    uint16_t bits_per_samp;
+} wav_fmt_t;
+#pragma pack(pop)
+
+#define WAV_SMPL_SIZE   68      /* sizeof(Smpl_Header_s) */
+#define W64_HDR_SIZE    24      /* GUID and 64-bit size in front of every Wave64 chunk */
+#define W64_ALIGN(x)    (((x) + 7) & ~(uint64_t) 7)
+
+static const uint8_t W64_RIFF_GUID[16] = { 'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+static const uint8_t W64_WAVE_GUID[16] = { 'w', 'a', 'v', 'e', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+
+static void set_wav_fmt(wav_fmt_t *fmt, const Sample_t *samp, const uint16_t bit_depth)
+{
+    fmt->comp_type = 1;
+    fmt->num_chan = 1;
+    fmt->samp_per_sec = (uint32_t) floor(samp->rate);
+    fmt->byte_per_sec = (fmt->samp_per_sec * fmt->num_chan * bit_depth) / 8;
+    fmt->block_align  = (fmt->num_chan * bit_depth) / 8;
+    fmt->bits_per_samp  = bit_depth;
+}
+
+/* Wave64 chunk header, the GUID is the RIFF id followed by the tail of the 'wave' GUID */
+static bool write_w64_chunk_hdr(out_file_t *out, const char *chunk_name, const uint64_t body_size)
+{
+    uint8_t hdr[W64_HDR_SIZE];
+    const uint64_t chunk_size = body_size + W64_HDR_SIZE;
+
+    memcpy(hdr, chunk_name, 4);
+    memcpy(hdr + 4, W64_WAVE_GUID + 4, 12);
+    memcpy(hdr + 16, &chunk_size, 8);
+
+    return out_write(out, hdr, W64_HDR_SIZE);
+}
+
+static bool write_wav_hdr(out_file_t *out, const Sample_t *samp, const bool bit16)
 {
 	/* RIFF WAVE format header for writing WAV files */
 
@@ -37,12 +219,7 @@ static bool write_wav_hdr(FILE *out_file, const Sample_t *samp)
         {
             uint32_t fmt__id;
             uint32_t fmt__size;
-            uint16_t comp_type;
-            uint16_t num_chan;
-            uint32_t samp_per_sec;
-            uint32_t byte_per_sec;
-            uint16_t block_align;
-            uint16_t bits_per_samp;
+            wav_fmt_t body;
         } fmt_;
 
         struct data_Chunk_s
@@ -53,7 +230,7 @@ static bool write_wav_hdr(FILE *out_file, const Sample_t *samp)
     } wav_hdr;
 #pragma pack(pop)
 
-	const uint16_t bit_depth = exporting16bit() ? 16 : 8;
+	const uint16_t bit_depth = bit16 ? 16 : 8;
     const uint32_t samp_len = (uint32_t) samp->audio.length,
                    data_size = samp_len * (bit_depth / 8);
 
@@ -64,24 +241,83 @@ static bool write_wav_hdr(FILE *out_file, const Sample_t *samp)
     wav_hdr.wave_id = get_chunk_id("WAVE");
 
     wav_hdr.fmt_.fmt__id = get_chunk_id("fmt ");
-    wav_hdr.fmt_.fmt__size = (uint32_t) (sizeof(struct fmt__Chunk_s) - 8);
-    wav_hdr.fmt_.comp_type = 1;
-    wav_hdr.fmt_.num_chan = 1;
-    wav_hdr.fmt_.samp_per_sec = (uint32_t) floor(samp->rate);
-    wav_hdr.fmt_.byte_per_sec = (wav_hdr.fmt_.samp_per_sec * wav_hdr.fmt_.num_chan * bit_depth) / 8;
-    wav_hdr.fmt_.block_align  = (wav_hdr.fmt_.num_chan * bit_depth) / 8;
-    wav_hdr.fmt_.bits_per_samp  = bit_depth;
+    wav_hdr.fmt_.fmt__size = (uint32_t) sizeof(wav_fmt_t);
+    set_wav_fmt(&wav_hdr.fmt_.body, samp, bit_depth);
 
     wav_hdr.data.data_id = get_chunk_id("data");
     wav_hdr.data.data_size = data_size; 
 
-    if(samp->is_looped) wav_hdr.riff_size += 68;   // sizeof(Smpl_Header_s)
+    if(samp->is_looped) wav_hdr.riff_size += WAV_SMPL_SIZE;
+
+    return out_write(out, &wav_hdr, hdr_numb);
+}
+
+/* 
+*   RF64 is RIFF with the RIFF and data sizes set to 0xFFFFFFFF and the real
+*   64-bit sizes moved into a ds64 chunk right after the WAVE id
+*/
+static bool write_rf64_hdr(out_file_t *out, const Sample_t *samp, const bool bit16)
+{
+#pragma pack(push,1)
+    struct Rf64_Header_u
+    {
+        uint32_t rf64_id;
+        uint32_t riff_size;
+        uint32_t wave_id;
+
+        struct ds64_Chunk_s
+        {
+            uint32_t ds64_id;
+            uint32_t ds64_size;
+            uint64_t riff_size;
+            uint64_t data_size;
+            uint64_t samp_count;
+            uint32_t table_len;
+        } ds64;
+
+        struct fmt__Chunk_s
+        {
+            uint32_t fmt__id;
+            uint32_t fmt__size;
+            wav_fmt_t body;
+        } fmt_;
+
+        struct data_Chunk_s
+        {
+            uint32_t data_id;
+            uint32_t data_size;
+        } data;
+    } rf64_hdr;
+#pragma pack(pop)
+
+	const uint16_t bit_depth = bit16 ? 16 : 8;
+    const uint64_t samp_len = (uint64_t) samp->audio.length,
+                   data_size = samp_len * (bit_depth / 8);
+
+    const size_t hdr_numb = sizeof(struct Rf64_Header_u);
+
+    rf64_hdr.rf64_id = get_chunk_id("RF64");
+    rf64_hdr.riff_size = UINT32_MAX;
+    rf64_hdr.wave_id = get_chunk_id("WAVE");
+
+    rf64_hdr.ds64.ds64_id = get_chunk_id("ds64");
+    rf64_hdr.ds64.ds64_size = (uint32_t) (sizeof(struct ds64_Chunk_s) - 8);
+    rf64_hdr.ds64.riff_size = data_size + (hdr_numb - 8) + (samp->is_looped ? WAV_SMPL_SIZE : 0);
+    rf64_hdr.ds64.data_size = data_size;
+    rf64_hdr.ds64.samp_count = samp_len;
+    rf64_hdr.ds64.table_len = 0;
 
-    // tests for num bytes written, instead of num elements
-    return (fwrite(&wav_hdr, 1, hdr_numb, out_file) == hdr_numb);
+    rf64_hdr.fmt_.fmt__id = get_chunk_id("fmt ");
+    rf64_hdr.fmt_.fmt__size = (uint32_t) sizeof(wav_fmt_t);
+    set_wav_fmt(&rf64_hdr.fmt_.body, samp, bit_depth);
+
+    rf64_hdr.data.data_id = get_chunk_id("data");
+    rf64_hdr.data.data_size = UINT32_MAX;
+
+    return out_write(out, &rf64_hdr, hdr_numb);
 }
 
-static bool write_smpl_hdr(FILE *out_file, const Sample_t *samp)
+static bool write_smpl_hdr(out_file_t *out, const Sample_t *samp, const bool w64)
 {
 	/* smpl header for writing WAV file loop */
 
@@ -114,53 +350,91 @@ static bool write_smpl_hdr(FILE *out_file, const Sample_t *samp)
     } smpl_hdr;
 #pragma pack(pop)
 
-    const size_t hdr_numb = sizeof(struct Smpl_Header_s);
-    const uint32_t samp_len = (uint32_t) samp->audio.length;
+    const size_t hdr_numb = sizeof(struct Smpl_Header_s), body_numb = hdr_numb - 8;
+    const int64_t samp_len = samp->audio.length,
+                  loop_start = samp->loop_start >= samp_len ? 0 : samp->loop_start,
+                  loop_end   = samp->loop_end   >= samp_len ? samp_len - 1 : samp->loop_end;
 
     memset(&smpl_hdr, 0, hdr_numb);  // barely any of this chunk's data is used, but still needs to be included
 
     smpl_hdr.smpl_id   = get_chunk_id("smpl");
-    smpl_hdr.smpl_size = (uint32_t) (hdr_numb - 8);
+    smpl_hdr.smpl_size = (uint32_t) body_numb;
     smpl_hdr.midi_note = 60;
     smpl_hdr.num_loops = 1;
 
-    smpl_hdr.loop_start = samp->loop_start >= (int) samp->audio.length ? 0 : (uint32_t) samp->loop_start;
-    smpl_hdr.loop_end   = samp->loop_end >= (int) samp_len ? samp_len - 1 : (uint32_t) samp->loop_end;
+    /* smpl only has room for 32-bit loop points */
+    smpl_hdr.loop_start = loop_start > UINT32_MAX ? UINT32_MAX : (uint32_t) loop_start;
+    smpl_hdr.loop_end   = loop_end   > UINT32_MAX ? UINT32_MAX : (uint32_t) loop_end;
 
-    // tests for num bytes written, instead of num elements
-    return (fwrite(&smpl_hdr, 1, hdr_numb, out_file) == hdr_numb);
+    if(w64) return write_w64_chunk_hdr(out, "smpl", body_numb) && out_write(out, &smpl_hdr.manufacturer, body_numb);
+
+    return out_write(out, &smpl_hdr, hdr_numb);
+}
+
+static bool write_wav_data(out_file_t *out, const Sample_t *samp, const bool bit16)
+{
+    /* 8-bit WAV is unsigned */
+    return out_samples(out, samp->audio.buffer, samp->audio.length, bit16 ? OUT_S16 : OUT_U8);
 }
 
-static bool save_wav(FILE *out_file, Sample_t *samp)
+/* plain RIFF unless the file would pass 4GB, then RF64 */
+static bool save_wav(out_file_t *out, const Sample_t *samp, const bool bit16)
 {
+    const uint64_t data_size = (uint64_t) samp->audio.length * (bit16 ? 2 : 1);
+    const bool rf64 = data_size > UINT32_MAX - 256;
+
     assert(samp != NULL);
     assert(samp->audio.buffer != NULL);
     assert(samp->audio.length > 1);
 
-    if(!write_wav_hdr(out_file, samp)) return false;
+    if(!(rf64 ? write_rf64_hdr(out, samp, bit16) : write_wav_hdr(out, samp, bit16))) return false;
 
-    if(exporting16bit())
-    {
-        for(int i = 0; i < samp->audio.length; i++)
-        {
-            if(fwrite(&samp->audio.buffer[i], 1, 2, out_file) != 2) return false;
-        }
-    }
-    else
-    {
-        for(int i = 0; i < samp->audio.length; i++)
-        {
-            uint8_t temp_samp = (samp->audio.buffer[i] >> 8) ^ 0x80;
-            if(fwrite(&temp_samp, 1, 1, out_file) != 1) return false;
-        }
-    }
+    if(!write_wav_data(out, samp, bit16)) return false;
 
-    if(*isSampEditLoopEnabled()) 
-        if(!write_smpl_hdr(out_file, samp)) return false;
+    if(samp->is_looped) 
+        if(!write_smpl_hdr(out, samp, false)) return false;
     
     return true;
 }
 
+/* Sony Wave64, fmt and smpl go in front of data so only data needs padding to 8 bytes */
+static bool save_w64(out_file_t *out, const Sample_t *samp, const bool bit16)
+{
+	const uint16_t bit_depth = bit16 ? 16 : 8;
+    const uint64_t data_size = (uint64_t) samp->audio.length * (bit_depth / 8),
+                   smpl_size = samp->is_looped ? W64_ALIGN(W64_HDR_SIZE + WAV_SMPL_SIZE - 8) : 0,
+                   file_size = 40 + W64_HDR_SIZE + sizeof(wav_fmt_t) + smpl_size + W64_ALIGN(W64_HDR_SIZE + data_size);
+
+    const uint8_t pad[8] = { 0 };
+    wav_fmt_t fmt;
+
+    assert(samp != NULL);
+    assert(samp->audio.buffer != NULL);
+    assert(samp->audio.length > 1);
+
+    set_wav_fmt(&fmt, samp, bit_depth);
+
+    if(!out_write(out, W64_RIFF_GUID, 16)) return false;
+    if(!out_write(out, &file_size, 8)) return false;
+    if(!out_write(out, W64_WAVE_GUID, 16)) return false;
+
+    if(!write_w64_chunk_hdr(out, "fmt ", sizeof fmt)) return false;
+    if(!out_write(out, &fmt, sizeof fmt)) return false;
+
+    if(samp->is_looped)
+    {
+        const size_t smpl_pad = (size_t) (smpl_size - (W64_HDR_SIZE + WAV_SMPL_SIZE - 8));
+
+        if(!write_smpl_hdr(out, samp, true)) return false;
+        if(!out_write(out, pad, smpl_pad)) return false;
+    }
+
+    if(!write_w64_chunk_hdr(out, "data", data_size)) return false;
+    if(!write_wav_data(out, samp, bit16)) return false;
+
+    return out_write(out, pad, (size_t) (W64_ALIGN(data_size) - data_size));
+}
+
 /* Copyright (C) 1988-1991 Apple Computer, Inc.
  * All rights reserved.
  *
@@ -243,7 +517,7 @@ void ConvertToIeeeExtended(double num, uint8_t (*bytes)[10])
     (*bytes)[9] = (uint8_t) (loMant);
 }
 
-static bool write_aif_hdr(FILE *out_file, const Sample_t *samp)
+static bool write_aif_hdr(out_file_t *out, const Sample_t *samp, const bool bit16)
 {
 	/* FORM AIFF format header for writing AIF files */
 
@@ -276,7 +550,7 @@ static bool write_aif_hdr(FILE *out_file, const Sample_t *samp)
     } aif_hdr;
 #pragma pack(pop)
 
-    const uint16_t bit_depth = exporting16bit() ? 16  : 8, num_chan = 1;
+    const uint16_t bit_depth = bit16 ? 16  : 8, num_chan = 1;
     const size_t hdr_numb = sizeof(struct Aif_Header_s);
     const uint32_t samp_len = (uint32_t) samp->audio.length,
                    data_len = samp_len * (bit_depth / 8);
@@ -297,40 +571,28 @@ static bool write_aif_hdr(FILE *out_file, const Sample_t *samp)
     aif_hdr.ssnd.ssnd_size = BE32(data_len);
     aif_hdr.ssnd.offset = aif_hdr.ssnd.block_size = 0;
 
-    // tests for num bytes written, instead of num elements
-    return (fwrite(&aif_hdr, 1, hdr_numb, out_file) == hdr_numb);
+    return out_write(out, &aif_hdr, hdr_numb);
 }
 
-static bool save_aif(FILE *out_file, Sample_t *samp)
+static bool save_aif(out_file_t *out, const Sample_t *samp, const bool bit16)
 {
     assert(samp != NULL);
     assert(samp->audio.buffer != NULL);
     assert(samp->audio.length > 1);
 
-    if(!write_aif_hdr(out_file, samp)) return false;
-
-    if(exporting16bit())
-    {
-        for(int i = 0; i < samp->audio.length; i++)
-        {
-            int16_t temp_samp = BE16(samp->audio.buffer[i]);
-            if(fwrite(&temp_samp, 1, 2, out_file) != 2) return false;
-        }
-    }
-    else
+    /* AIFF chunk sizes are 32-bit */
+    if((uint64_t) samp->audio.length * (bit16 ? 2 : 1) > UINT32_MAX - 64)
     {
-        for(int i = 0; i < samp->audio.length; i++)
-        {
-            int8_t temp_samp = (samp->audio.buffer[i] >> 8);
-            if(fwrite(&temp_samp, 1, 1, out_file) != 1) return false;
-        }
+        errno = EFBIG;
+        return false;
     }
 
+    if(!write_aif_hdr(out, samp, bit16)) return false;
 
-    return true;    
+    return out_samples(out, samp->audio.buffer, samp->audio.length, bit16 ? OUT_S16BE : OUT_S8);
 }
 
-static bool write_iff_hdr(FILE *out_file, const Sample_t *samp)
+static bool write_iff_hdr(out_file_t *out, const Sample_t *samp)
 {
 	/* FORM 8SVX format header for writing IFF files */
 
@@ -387,25 +649,25 @@ static bool write_iff_hdr(FILE *out_file, const Sample_t *samp)
     svx8_hdr.body.body_id = get_chunk_id("BODY");
     svx8_hdr.body.body_size = BE32(samp_len);
 
-    // tests for num bytes written, instead of num elements
-    return (fwrite(&svx8_hdr, 1, hdr_numb, out_file) == hdr_numb);
+    return out_write(out, &svx8_hdr, hdr_numb);
 }
 
-static bool save_iff(FILE *out_file, const Sample_t *samp)
+static bool save_iff(out_file_t *out, const Sample_t *samp)
 {
     assert(samp != NULL);
     assert(samp->audio.buffer != NULL);
     assert(samp->audio.length > 1);
 
-    if(!write_iff_hdr(out_file, samp)) return false;
-
-    for (int i = 0; i < samp->audio.length; i++)
+    /* so are 8SVX's */
+    if((uint64_t) samp->audio.length > UINT32_MAX - 64)
     {
-        int8_t temp_samp = (samp->audio.buffer[i] & 0xFF00) >> 8;
-        if(fwrite(&temp_samp, 1, 1, out_file) < 1) return false;
+        errno = EFBIG;
+        return false;
     }
 
-    return true;
+    if(!write_iff_hdr(out, samp)) return false;
+
+    return out_samples(out, samp->audio.buffer, samp->audio.length, OUT_S8);
 }
 
 static int16_t CLAMP16(int n)
@@ -514,53 +776,384 @@ static double AdpcmMashS(int16_t* value, int filter, int16_t* inputBuffer, int s
     return sqrt(d2);
 }
 
-static void AdpcmBlockMashI(signed short* ip, unsigned char* obuff, signed short* v)
+/*
+*   integer-only scoring of one shift/filter candidate, same quantizer as AdpcmMashS.
+*   the square-error is summed exactly in 64 bits, so candidates compare without sqrt,
+*   and the candidate is abandoned as soon as it can no longer beat the current minimum.
+*   if it runs to the end and vout is given, the filter history after the block is stored there.
+*/
+static inline uint64_t adpcm_score_i(const int filter, const int16_t *ip, const int16_t *v,
+                                     const int shiftStep, const uint64_t bound, int16_t *vout)
 {
-    int shift = 1, shift_min = 0;
-    int coeff = 0, coeff_min = 0;
+    const int bias = (4 << shiftStep) + ((1 << shiftStep) >> 2);
 
-    double dmin = 0.0;
+    int v0 = v[0], v1 = v[1];
+    uint64_t d2 = 0;
 
-    memset(obuff, 0, 9);
+    for (int i = 0; i < 16; i++)
+    {
+        int vlin = 0, d, c;
+
+        /* filter is a constant in every caller, so this folds away */
+        if (filter == 1)
+        {
+            vlin = (v0 >> 1) + ((-v0) >> 5);
+        }
+        else if (filter == 2)
+        {
+            vlin = v0 + ((-(v0 + (v0 >> 1))) >> 5) - (v1 >> 1) + (v1 >> 5);
+        }
+        else if (filter == 3)
+        {
+            vlin = v0 + ((-(v0 + (v0 << 2) + (v0 << 3))) >> 7) - (v1 >> 1) + ((v1 + (v1 >> 1)) >> 4);
+        }
+
+        d = (ip[i] >> 1) - vlin;
+
+        /* take advantage of wrapping */
+        if (d < -16384 && d > -32768) d += 32768;
+
+        d += bias;
+        c = d > 0 ? (d * 2) >> shiftStep : 0;
+        if (c > 15) c = 15;
+        c -= 8;
+
+        v1 = v0;
+        v0 = (int16_t) (CLAMP16(vlin + ((c * (1 << shiftStep)) >> 1)) * 2);
+
+        d = ip[i] - v0;
+        d2 += (uint64_t) ((int64_t) d * d);
+
+        if (d2 >= bound) return d2;
+    }
+
+    if (vout != NULL)
+    {
+        vout[0] = (int16_t) v0;
+        vout[1] = (int16_t) v1;
+    }
+
+    return d2;
+}
+
+typedef uint64_t (*AdpcmScore_t)(const int16_t*, const int16_t*, const int, const uint64_t, int16_t*);
+
+static uint64_t adpcm_score_f0(const int16_t *ip, const int16_t *v, const int s, const uint64_t b, int16_t *o) { return adpcm_score_i(0, ip, v, s, b, o); }
+static uint64_t adpcm_score_f1(const int16_t *ip, const int16_t *v, const int s, const uint64_t b, int16_t *o) { return adpcm_score_i(1, ip, v, s, b, o); }
+static uint64_t adpcm_score_f2(const int16_t *ip, const int16_t *v, const int s, const uint64_t b, int16_t *o) { return adpcm_score_i(2, ip, v, s, b, o); }
+static uint64_t adpcm_score_f3(const int16_t *ip, const int16_t *v, const int s, const uint64_t b, int16_t *o) { return adpcm_score_i(3, ip, v, s, b, o); }
+
+static const AdpcmScore_t score_filter[4] = { adpcm_score_f0, adpcm_score_f1, adpcm_score_f2, adpcm_score_f3 };
+
+static int adpcm_block_search_i(const int16_t *ip, const int16_t *v)
+{
+    uint64_t dmin = UINT64_MAX;
+    int best = 0;
+
+    for (int shift = 0; shift < 13; shift++)
+    {
+        for (int coeff = 0; coeff < 4; coeff++)
+        {
+            const uint64_t d = score_filter[coeff](ip, v, shift, dmin, NULL);
+
+            if (d < dmin)
+            {
+                dmin = d;
+                best = (shift << 2) | coeff;
+            }
+        }
+    }
+
+    return best;
+}
+
+#ifdef DEBUG
+/* blocks encoded between checks against the reference search, which costs as much as encoding them again */
+#define BRR_REF_CHECK_EVERY 64
+
+static _Atomic unsigned int ref_check_count = 0;
+
+/* original floating point search, only used to check the fast searches are bit-exact */
+static int adpcm_block_search_ref(int16_t *ip, int16_t *v)
+{
+    double dmin = 0.0;
+    int best = 0;
 
-    for (shift = 0; shift < 13; shift++)
+    for (int shift = 0; shift < 13; shift++)
     {
-        for (coeff = 0; coeff < 4; coeff++)
+        for (int coeff = 0; coeff < 4; coeff++)
         {
-            double d = AdpcmMashS(&v[0], coeff, ip, shift, NULL);
+            double d = AdpcmMashS(v, coeff, ip, shift, NULL);
 
             if ((!shift && !coeff) || d < dmin)
             {
-                coeff_min = coeff;
                 dmin = d;
-                shift_min = shift;
+                best = (shift << 2) | coeff;
             }
         }
     }
 
+    return best;
+}
+#endif
+
+static void AdpcmBlockMashI(signed short* ip, unsigned char* obuff, signed short* v)
+{
+    int shift_min = 0, coeff_min = 0, best = -1;
+
+    memset(obuff, 0, 9);
+
+    /* scores all 52 candidates at once if the CPU allows it, otherwise branch-and-bound in integers */
+    if ((best = brrSimdBlockSearch(ip, v)) < 0) best = adpcm_block_search_i(ip, v);
+
+#ifdef DEBUG
+    if (atomic_fetch_add(&ref_check_count, 1) % BRR_REF_CHECK_EVERY == 0) assert(best == adpcm_block_search_ref(ip, v));
+#endif
+
+    shift_min = best >> 2;
+    coeff_min = best & 3;
+
     obuff[0] = (char)((shift_min << 4) | (coeff_min << 2));
 
     AdpcmMashS(&v[0], coeff_min, ip, shift_min, obuff + 1);
 }
 
-static bool save_brr(FILE *out_file, const Sample_t *samp)
+/*
+*   one hypothesis of the quality encoder: the filter history it ends on, its total
+*   square-error so far and the last BRR_BEAM_DEPTH blocks it chose, as a ring buffer
+*/
+typedef struct Brr_Path_s
 {
-    bool success = true, loop_enable = false;
-    int brr_offset = 0, block_count = 0, pad_offset = 0;
-    int sample_length = 0, block_offset = 0;
+    int16_t v[2];
+    uint64_t err;
+    uint8_t blocks[BRR_BEAM_DEPTH][9];
+} brr_path_t;
+
+typedef struct Brr_Child_s
+{
+    int16_t v[2];
+    uint64_t err;
+    int parent, candidate;
+} brr_child_t;
+
+static void load_brr_block(const Sample_t *samp, const int64_t block, const int block_offset, int16_t *out)
+{
+    const int64_t i = block * 16;
+
+    for (int j = 0; j < 16; j++)
+    {
+        if (i < 16 && j <= block_offset)
+            out[j] = 0;
+        else
+            out[j] = samp->audio.buffer[i + j - block_offset];
+    }
+}
+
+static void encode_brr_greedy(const Sample_t *samp, const int block_offset, const int64_t first_block,
+                              const int64_t num_blocks, int16_t *v, uint8_t *out)
+{
+    for (int64_t block = first_block; block < num_blocks; block++)
+    {
+        int16_t tempSamp[16];
+
+        load_brr_block(samp, block, block_offset, tempSamp);
+        AdpcmBlockMashI(tempSamp, out + block * 9, v);
+    }
+}
+
+/* lowest error first, ties broken by parent and then candidate, the order the next beam is kept in */
+static bool brr_child_before(const brr_child_t *x, const brr_child_t *y)
+{
+    if (x->err != y->err) return x->err < y->err;
+    if (x->parent != y->parent) return x->parent < y->parent;
+    return x->candidate < y->candidate;
+}
+
+/*
+*   puts child in the next beam if it's one of the best width. paths with the same history behave
+*   identically from here on, so it only replaces one that ends on the same history if it's cheaper.
+*   returns how many children the beam has now
+*/
+static int offer_brr_child(brr_child_t *best, int num_best, const int width, const brr_child_t *child)
+{
+    int k = num_best;
+
+    for (int i = 0; i < num_best; i++)
+    {
+        if (best[i].v[0] != child->v[0] || best[i].v[1] != child->v[1]) continue;
+
+        if (!brr_child_before(child, &best[i])) return num_best;
+
+        k = i;
+        break;
+    }
+
+    /* a new history goes on the end, pushing the worst out if the beam is full */
+    if (k == num_best)
+    {
+        if (num_best == width && !brr_child_before(child, &best[width - 1])) return num_best;
+        if (num_best < width) num_best++;
+
+        k = num_best - 1;
+    }
+
+    for (; k > 0 && brr_child_before(child, &best[k - 1]); k--) best[k] = best[k - 1];
+
+    best[k] = *child;
+
+    return num_best;
+}
+
+/*
+*   offers every candidate of the next block for one path. once the beam is full its worst error is the
+*   bound: a candidate is abandoned as soon as it reaches it, the same way the fast search prunes, and
+*   one that beats it already has the filter history it ends on
+*/
+static int expand_brr_path(const int16_t *samp, const brr_path_t *path, const int index,
+                           brr_child_t *best, int num_best, const int width)
+{
+    for (int cand = 0; cand < BRR_CANDIDATES; cand++)
+    {
+        const bool full = num_best == width;
+        const uint64_t bound = full ? best[width - 1].err - path->err : UINT64_MAX;
+        brr_child_t child;
+        uint64_t err = 0;
+
+        /* every child costs at least as much as its parent */
+        if (full && best[width - 1].err <= path->err) break;
+
+        if ((err = score_filter[cand & 3](samp, path->v, cand >> 2, bound, child.v)) >= bound) continue;
+
+        child.err = path->err + err;
+        child.parent = index;
+        child.candidate = cand;
+
+        num_best = offer_brr_child(best, num_best, width, &child);
+    }
+
+    return num_best;
+}
+
+static void commit_brr_block(const brr_path_t *path, const int64_t block, uint8_t *out)
+{
+    memcpy(out + block * 9, path->blocks[block % BRR_BEAM_DEPTH], 9);
+}
+
+/*
+*   quality encoder: keeps the best `width` block sequences instead of only the best block,
+*   so a block that is slightly worse on its own can be chosen when it leaves a better filter
+*   history for the blocks after it. a block is committed once it is BRR_BEAM_DEPTH blocks old,
+*   and paths that disagree with it are dropped. if the time budget runs out, the best path
+*   is committed as it stands and the rest of the sample is encoded greedily. it's a block's
+*   worth of work at a time on one thread, which is already less than a pool takes to sync
+*/
+static void encode_brr_beam(const Sample_t *samp, const int block_offset, const int64_t num_blocks, uint8_t *out)
+{
+    const int width = brr_beam_width;
+    const uint64_t start_ms = getMonotonicMs();
+
+    int16_t block_samp[16];
+    brr_path_t *paths = NULL, *next = NULL;
+    brr_child_t *children = NULL;
+
+    int num_paths = 1;
+    int64_t committed = 0, block = 0;
+
+    SBC_CALLOC(width, sizeof *paths, paths);
+    SBC_CALLOC(width, sizeof *next, next);
+    SBC_CALLOC(width, sizeof *children, children);
+
+    for (block = 0; block < num_blocks; block++)
+    {
+        const int slot = (int) (block % BRR_BEAM_DEPTH);
+        int num_next = 0;
+
+        if (brr_time_budget > 0 && getMonotonicMs() - start_ms > (uint64_t) brr_time_budget)
+        {
+            SBC_LOG(BRR TIME BUDGET EXCEEDED AT BLOCK, %lld, (long long) block);
+            break;
+        }
+
+        load_brr_block(samp, block, block_offset, block_samp);
+
+        /* paths stay in order of error, so once one costs more than the beam's worst so do the rest */
+        for (int i = 0; i < num_paths; i++)
+        {
+            if (num_next == width && children[width - 1].err <= paths[i].err) break;
+
+            num_next = expand_brr_path(block_samp, &paths[i], i, children, num_next, width);
+        }
+
+        for (int i = 0; i < num_next; i++)
+        {
+            const brr_child_t *child = &children[i];
+            brr_path_t *path = &next[i];
+
+            memcpy(path->blocks, paths[child->parent].blocks, sizeof path->blocks);
+            memset(path->blocks[slot], 0, 9);
+
+            path->v[0] = paths[child->parent].v[0];
+            path->v[1] = paths[child->parent].v[1];
+            path->err  = child->err;
+
+            path->blocks[slot][0] = (uint8_t)(((child->candidate >> 2) << 4) | ((child->candidate & 3) << 2));
+            AdpcmMashS(path->v, child->candidate & 3, block_samp, child->candidate >> 2, path->blocks[slot] + 1);
+
+            assert(path->v[0] == child->v[0] && path->v[1] == child->v[1]);
+        }
+
+        memcpy(paths, next, (size_t) num_next * sizeof *next);
+        num_paths = num_next;
+
+        if (block - committed + 1 >= BRR_BEAM_DEPTH)
+        {
+            const int commit_slot = (int) (committed % BRR_BEAM_DEPTH);
+            int kept = 0;
+
+            commit_brr_block(&paths[0], committed, out);
+
+            for (int k = 0; k < num_paths; k++)
+            {
+                if (memcmp(paths[k].blocks[commit_slot], paths[0].blocks[commit_slot], 9) == 0)
+                    paths[kept++] = paths[k];
+            }
+
+            num_paths = kept;
+            committed++;
+        }
+    }
+
+    for (; committed < block; committed++)
+        commit_brr_block(&paths[0], committed, out);
+
+    if (block < num_blocks)
+    {
+        int16_t v[2] = { paths[0].v[0], paths[0].v[1] };
+        encode_brr_greedy(samp, block_offset, block, num_blocks, v, out);
+    }
+
+    SBC_FREE(children);
+    SBC_FREE(next);
+    SBC_FREE(paths);
+}
+
+uint8_t *encodeBrrBuffer(const Sample_t *samp, size_t *brr_len, const BrrEncodeMode_t mode)
+{
+    bool loop_enable = false;
+    int brr_offset = 0, block_count = 0, pad_offset = 0, block_offset = 0;
+    int64_t sample_length = 0, num_blocks = 0;
 
-    size_t brr_len = 0;
     uint8_t* brr_buffer = NULL;
-    int16_t v[2] = { 0, 0 };
 
-    assert(samp != NULL);
+    assert(samp != NULL && brr_len != NULL);
     assert(samp->audio.buffer != NULL);
     assert(samp->audio.length > 1);
 
     loop_enable = samp->is_looped;
     brr_offset = loop_enable ? 2 : 0;
     sample_length = loop_enable ? samp->loop_end : samp->audio.length;
-    block_offset = (sample_length % 16) == 0 ? 0 : 16 - (sample_length % 16);
+    block_offset = (sample_length % 16) == 0 ? 0 : 16 - (int) (sample_length % 16);
+    num_blocks = (sample_length + block_offset) / 16;
 
     for (int i = 0; i < 16; i++)
     {
@@ -573,42 +1166,27 @@ static bool save_brr(FILE *out_file, const Sample_t *samp)
 
     block_count = pad_offset + brr_offset;
 
-    if((brr_len = (size_t) (BRRPOS2BYTEPOS(sample_length + block_offset)) + block_count) < 10) return false;
+    if((*brr_len = (size_t) (BRRPOS2BYTEPOS(sample_length + block_offset)) + block_count) < 10) return NULL;
 
-    SBC_CALLOC(brr_len, sizeof *brr_buffer, brr_buffer);
+    SBC_CALLOC(*brr_len, sizeof *brr_buffer, brr_buffer);
 
-    for (int i = 0; i < sample_length + block_offset; i += 16)
+    if (mode == BRR_ENCODE_QUALITY && brr_beam_width > 1)
     {
-        int16_t tempSamp[16];
-        uint8_t tempBrr  [9];
-
-        for (int j = 0; j < 16; j++)
-        {
-            if (i < 16 && j <= block_offset) 
-                tempSamp[j] = 0;
-            else if ((i + j) < sample_length + block_offset)
-                tempSamp[j] = samp->audio.buffer[i + j - block_offset];
-            else
-                break;
-        }
-
-        AdpcmBlockMashI(tempSamp, tempBrr, (short*)&v);
-
-        for (int b = 0; b < 9; b++)
-        {
-            if (block_count + b < (int) brr_len)
-                brr_buffer[block_count + b] = tempBrr[b];
-            else
-                break;
-
-            if (loop_enable && b == 0)
-                brr_buffer[block_count + b] ^= 2;
-        }
+        encode_brr_beam(samp, block_offset, num_blocks, brr_buffer + block_count);
+    }
+    else
+    {
+        int16_t v[2] = { 0, 0 };
+        encode_brr_greedy(samp, block_offset, 0, num_blocks, v, brr_buffer + block_count);
+    }
 
-        block_count += 9;
+    if (loop_enable)
+    {
+        for (int64_t b = 0; b < num_blocks; b++)
+            brr_buffer[block_count + b * 9] ^= 2;
     }
 
-    brr_buffer[brr_len - 9] ^= 1;
+    brr_buffer[*brr_len - 9] ^= 1;
 
     if (loop_enable)
     {
@@ -617,113 +1195,193 @@ static bool save_brr(FILE *out_file, const Sample_t *samp)
         brr_buffer[0] = (uint8_t)(start_loop_block & ~0xFF00);
         brr_buffer[1] = (uint8_t)((start_loop_block & ~0x00FF) >> 8);
     }
-        
-    if(fwrite(brr_buffer, 1, brr_len, out_file) != brr_len) success = false;
+
+    return brr_buffer;
+}
+
+static bool save_brr(out_file_t *out, const Sample_t *samp)
+{
+    bool success = true;
+    size_t brr_len = 0;
+    uint8_t* brr_buffer = NULL;
+
+    if((brr_buffer = encodeBrrBuffer(samp, &brr_len, brr_encode_mode)) == NULL) return false;
+
+    if(!out_write(out, brr_buffer, brr_len)) success = false;
 
     SBC_FREE(brr_buffer);
 
     return success;
 }
 
-static bool save_mu(FILE *out_file, const Sample_t *samp)
+static bool save_mu(out_file_t *out, const Sample_t *samp, const CompandCurve_t curve)
 {
     assert(samp != NULL);
     assert(samp->audio.buffer != NULL);
     assert(samp->audio.length > 1);
 
-    for (int i = 0; i < samp->audio.length; i++)
-    {
-        const int16_t temp_samp = samp->audio.buffer[i];
-        const double encoding = (255.0 * (double) abs(temp_samp)) / 32767.0;
-        uint8_t encodedSample = (uint8_t) round(log(1.0 + encoding) * 22.91);
-
-        if(temp_samp > 0) encodedSample ^= 0x80;
-        if(fwrite(&encodedSample, 1, 1, out_file) < 1) return false;
-    }
-
-    return true;
+    return out_samples(out, samp->audio.buffer, samp->audio.length, (out_fmt_t) (OUT_LINN + curve));
 }
 
-static bool save_raw(FILE *out_file, const Sample_t *samp)
+static bool save_raw(out_file_t *out, const Sample_t *samp, const bool bit16)
 {
     assert(samp != NULL);
     assert(samp->audio.buffer != NULL);
     assert(samp->audio.length > 1);
 
-    if(exporting16bit()) return (fwrite(samp->audio.buffer, 
-                                    sizeof *samp->audio.buffer, 
-                                    samp->audio.length, 
-                                    out_file) == (size_t) samp->audio.length);
+    return out_samples(out, samp->audio.buffer, samp->audio.length, bit16 ? OUT_S16 : OUT_S8);
+}
+
+/* 
+*   a temp file name for filepath, in the same directory so the final rename can't cross devices. the
+*   process id and temp_count make it unique, so two exports to the same path never share a temp file
+*/
+static char *get_temp_path(const char *filepath)
+{
+    const size_t len = strlen(filepath) + 32;
+    char *temp_path = NULL;
+
+#if defined (_WIN32)
+    const unsigned long pid = (unsigned long) GetCurrentProcessId();
+#else
+    const unsigned long pid = (unsigned long) getpid();
+#endif
+
+    SBC_MALLOC(len, sizeof *temp_path, temp_path);
+    snprintf(temp_path, len, "%s.%lu-%u.tmp", filepath, pid, atomic_fetch_add(&temp_count, 1));
 
-    for (int i = 0; i < samp->audio.length; i++)
+    return temp_path;
+}
+
+/* creates the temp file, never opening one that's already there */
+static FILE *create_temp_file(const char *temp_path)
+{
+    FILE *file = NULL;
+    int fd = -1;
+
+#if defined (_WIN32)
+    if((fd = _open(temp_path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE)) < 0) return NULL;
+    if((file = _fdopen(fd, "wb")) == NULL) _close(fd);
+#else
+    if((fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0666)) < 0) return NULL;
+    if((file = fdopen(fd, "wb")) == NULL) close(fd);
+#endif
+
+    return file;
+}
+
+/* opens a new temp file for filepath, its name goes in temp_path */
+static bool open_out_file(out_file_t *out, const char *filepath, char **temp_path)
+{
+    memset(out, 0, sizeof *out);
+
+    /* a name can only be taken by a temp file a crashed export left behind, the next one is tried */
+    for(int i = 0; i < OUT_TEMP_TRIES && out->file == NULL; i++)
     {
-        int8_t temp_samp = (samp->audio.buffer[i]) >> 8;
-        if(fwrite(&temp_samp, 1, 1, out_file) < 1) return false;
+        SBC_FREE(*temp_path);
+
+        *temp_path = get_temp_path(filepath);
+        out->file = create_temp_file(*temp_path);
+
+        if(out->file == NULL && errno != EEXIST) break;
     }
 
+    if(out->file == NULL) return false;
+
+    /* the block does all the buffering */
+    setvbuf(out->file, NULL, _IONBF, 0);
+
+    SBC_MALLOC(OUT_BLOCK_SIZE, sizeof *out->block, out->block);
+
     return true;
 }
 
-static bool cleanup_and_close(const char* filepath, FILE **out_file, Sample_t **samp)
+/* makes sure the data is on disk before the rename can make it visible */
+static bool sync_out_file(FILE *file)
 {
-    bool success = true;
-    long file_len = 1;
+    if(fflush(file) != 0) return false;
+
+#if defined (_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+/* 
+*   writes out what's left of the block and renames the temp file over filepath, so a file
+*   that's being replaced only ever changes from the old contents to the complete new ones.
+*   if keep is false or anything fails, the temp file is removed and filepath is left alone
+*/
+static bool close_out_file(out_file_t *out, const char *temp_path, const char *filepath, bool keep)
+{
+    if(keep) keep = out_flush(out) && sync_out_file(out->file);
+    if(fclose(out->file) != 0) keep = false;
 
-    assert(out_file  != NULL &&   samp  != NULL);
-    assert(*out_file != NULL && (*samp) != NULL);
+    SBC_FREE(out->block);
+    out->file = NULL;
 
-    SBC_FREE((*samp)->audio.buffer);
-    SBC_FREE((*samp));
+#if defined (_WIN32)
+    /* rename won't replace an existing file on Windows */
+    if(keep && !MoveFileExA(temp_path, filepath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        errno = EACCES;
+        keep = false;
+    }
+#else
+    if(keep && rename(temp_path, filepath) != 0) keep = false;
+#endif
 
-	fseek((*out_file), 0, SEEK_END);
-    file_len = ftell(*out_file);
+    if(!keep)
+    {
+        const int err = errno;
 
-    if(fclose((*out_file)) != 0) success = false;
-    if(file_len == 0) if(remove(filepath) != 0) success = false;
+        remove(temp_path);
+        errno = err;
+    }
 
-    return success;
+    return keep;
 }
 
-void saveFile (const char* filepath)
+bool writeSampleFile(const char* filepath, const Sample_t *samp, const bool bit16)
 {
-	Sample_t *samp_export = NULL, *samp_edit = getSampleEdit();
-    const size_t EXT_LEN = 4, buf_size = sizeof *samp_edit->audio.buffer;
+    const size_t EXT_LEN = 4;
 
+    Sample_t samp_export;
+    out_file_t out;
+
+    int64_t samp_start = 0;
     size_t pathlen;
     bool success = 1;
 
-    FILE *out_file = NULL;
+    char *temp_path = NULL;
     char file_type[8];
 
-    assert(samp_edit != NULL);
+    assert(samp != NULL);
 
-    if(isStringEmpty(filepath)) return;
-    if(samp_edit->audio.buffer == NULL || samp_edit->audio.length <= 1) return;
+    if(isStringEmpty(filepath)) return false;
+    if(samp->audio.buffer == NULL || samp->audio.length <= 1) return false;
 
-	if((out_file = fopen(filepath, "wb")) == NULL)
-	{
-		showErrorMsgBox("File Write Error", "Unable to save file! ", strerror(errno));
-		return;
-	}
+    samp_start = samp->samp_start;
+    if(samp->audio.length - samp_start <= 0) return false;
 
-    SBC_CALLOC(1, sizeof(Sample_t), samp_export);
+    /* a view of samp from its sample start onwards, the savers never write to the buffer so nothing is copied */
+    memset(&samp_export, 0, sizeof samp_export);
 
-    samp_export->audio.length = samp_edit->audio.length - samp_edit->samp_start;
-    
-    if(samp_export->audio.length <= 0)
-    {
-        fclose(out_file);
-        SBC_FREE(samp_export);
-        return;
-    }
+    samp_export.audio.buffer = samp->audio.buffer + samp_start;
+    samp_export.audio.length = samp->audio.length - samp_start;
 
-    SBC_MALLOC(samp_export->audio.length, buf_size, samp_export->audio.buffer);
-    memcpy(samp_export->audio.buffer, samp_edit->audio.buffer + samp_edit->samp_start, samp_export->audio.length * buf_size);
+    samp_export.rate       = samp->rate;
+    samp_export.is_looped  = samp->is_looped;
+    samp_export.loop_end   = samp->loop_end   - samp_start;
+    samp_export.loop_start = samp->loop_start - samp_start;
 
-    samp_export->rate       = samp_edit->rate;
-    samp_export->is_looped  = samp_edit->is_looped;
-    samp_export->loop_end   = samp_edit->loop_end   - samp_edit->samp_start;
-    samp_export->loop_start = samp_edit->loop_start - samp_edit->samp_start;
+    if(!open_out_file(&out, filepath, &temp_path))
+    {
+        reportError("File Write Error", "Unable to save file! ", strerror(errno));
+        SBC_FREE(temp_path);
+        return false;
+    }
 
     pathlen = strlen(filepath);
     memset(file_type, '\0', 8);
@@ -731,33 +1389,48 @@ void saveFile (const char* filepath)
     if(pathlen - (_strcasestr(filepath, ".wav") - filepath) == EXT_LEN) 
     { 
         memcpy(file_type, "WAV", 4);
-        success = save_wav(out_file, samp_export);
+        success = save_wav(&out, &samp_export, bit16);
+    }
+    else if(pathlen - (_strcasestr(filepath, ".w64") - filepath) == EXT_LEN) 
+    { 
+        memcpy(file_type, "Wave64", 7);
+        success = save_w64(&out, &samp_export, bit16);
     }
     else if((pathlen - (_strcasestr(filepath, ".aif")  - filepath) == EXT_LEN) ||
             (pathlen - (_strcasestr(filepath, ".aiff") - filepath) == EXT_LEN + 1))
     {
         memcpy(file_type, "AIFF", 5);
-        success = save_aif(out_file, samp_export);
+        success = save_aif(&out, &samp_export, bit16);
     }
     else if(pathlen - (_strcasestr(filepath, ".iff") - filepath) == EXT_LEN)
     {
         memcpy(file_type, "8SVX", 5);
-        success = save_iff(out_file, samp_export);
+        success = save_iff(&out, &samp_export);
     }
     else if(pathlen - (_strcasestr(filepath, ".brr") - filepath) == EXT_LEN) 
     {
         memcpy(file_type, "BRR", 4);
-        success = save_brr(out_file, samp_export);
+        success = save_brr(&out, &samp_export);
     }
     else if(pathlen - (_strcasestr(filepath, ".bin") - filepath) == EXT_LEN)
+    {
+        snprintf(file_type, 8, "%s", getBinCurve() == COMPAND_ALAW ? "A-Law" : "mu-Law");
+        success = save_mu(&out, &samp_export, getBinCurve());
+    }
+    else if(pathlen - (_strcasestr(filepath, ".ul") - filepath) == EXT_LEN - 1)
     {
         memcpy(file_type, "mu-Law", 7);
-        success = save_mu(out_file, samp_export);
+        success = save_mu(&out, &samp_export, COMPAND_ULAW);
+    }
+    else if(pathlen - (_strcasestr(filepath, ".al") - filepath) == EXT_LEN - 1)
+    {
+        memcpy(file_type, "A-Law", 6);
+        success = save_mu(&out, &samp_export, COMPAND_ALAW);
     }
     else
     {
         memcpy(file_type, "raw PCM", 8);
-        success = save_raw(out_file, samp_export);
+        success = save_raw(&out, &samp_export, bit16);
     }
 
     if(!success)
@@ -766,9 +1439,29 @@ void saveFile (const char* filepath)
         memset(box_msg, '\0', 46);
 
         snprintf(box_msg, 46, "Unexpected error while writing %s file!\n", file_type);
-        showErrorMsgBox("File Write Error", box_msg, strerror(errno));
+        reportError("File Write Error", box_msg, strerror(errno));
+    }
+
+    if(!close_out_file(&out, temp_path, filepath, success) && success) 
+    {
+		reportError("File Close Error", "Unexpected error while closing file!\n", strerror(errno));
+        success = false;
     }
 
-    if(!cleanup_and_close(filepath, &out_file, &samp_export)) 
-		showErrorMsgBox("File Close Error", "Unexpected error while closing file!\n", strerror(errno));
+    SBC_FREE(temp_path);
+
+    return success;
+}
+
+BrrEncodeMode_t getBrrEncodeMode(void) { return brr_encode_mode; }
+void setBrrEncodeMode(const BrrEncodeMode_t mode) { brr_encode_mode = mode; }
+
+int getBrrBeamWidth(void) { return brr_beam_width; }
+
+void setBrrBeamWidth(const int width)
+{
+    brr_beam_width = width < 1 ? 1 : width > BRR_MAX_BEAM_WIDTH ? BRR_MAX_BEAM_WIDTH : width;
 }
+
+int getBrrTimeBudget(void) { return brr_time_budget; }
+void setBrrTimeBudget(const int ms) { brr_time_budget = ms < 0 ? 0 : ms; }
@@ -7,6 +7,7 @@
 
 #include "sbc_samp_edit.h"
 #include "sbc_optmenu.h"
+#include "sbc_audio.h"
 
 #include "sbc_textbox.h"
 
@@ -18,6 +19,7 @@ bool paintSBC(void)
     bool repaint = repaint_gui;
 
 	if(updateTextboxCursor()) repaint = repaint_gui = true;
+	if(updateOptionsStats()) repaint = repaint_gui = true;
 	if(!getRepaintTimer()) return false;
 
 	paintGUI();
@@ -187,3 +189,92 @@ bool isMouseOnSlider(void) { return mouse_on_slider; }
 void handleSampleNameText(const char *samp_name) { setSampleNameBoxText(samp_name); }
 void handleSampleRateText(const double rate) { setSampleRateBoxText(rate); }
 void handleResampleRateText(const double rate) { setResampleRateBoxText(rate); }
+
+void handleResampleDone(void)
+{
+	if(!resampleIsReady()) return;
+
+	if(finishResample())
+	{
+		drawNewWave();
+
+		if(!optionsIsShowing()) repaintWaveform();
+
+		handleSampleRateText(*getSampleEditSampleRate());
+		repaintGUI();
+	}
+}
+
+/* what's printed over the live waveform, rewritten every frame while recording */
+static char record_status[64] = "";
+
+void toggleRecording(void)
+{
+	Sample_t samp;
+
+	if(!isRecording())
+	{
+		if(!startRecording()) return;
+
+		click_button(getRecButton(), true);
+
+		snprintf(record_status, sizeof record_status, "REC");
+
+		if(!optionsIsShowing()) showRecordingWave(getRecordingTake(), record_status);
+
+		repaintGUI();
+		return;
+	}
+
+	showRecordingWave(NULL, NULL);
+	click_button(getRecButton(), false);
+
+	/* the take's buffer becomes the edit buffer as it is, nothing recorded is copied again */
+	if(stopRecording(&samp))
+	{
+		setUndoBuffer();
+		adoptSampleEdit(&samp);
+
+		handleSampleNameText("RECORDING");
+		handleSampleRateText(*getSampleEditSampleRate());
+
+		click_button(getLoopButton(), false);
+
+		drawNewWave();
+		resetZoom();
+		resetSliders();
+	}
+
+	if(!optionsIsShowing()) repaintWaveform();
+
+	repaintGUI();
+}
+
+void handleRecording(void)
+{
+	const Record_Take_t *take = NULL;
+
+	if(!isRecording()) return;
+
+	if(updateRecording() < 0)
+	{
+		toggleRecording();
+		return;
+	}
+
+	take = getRecordingTake();
+
+	snprintf(record_status, sizeof record_status, "REC %.1fs  LATENCY %.0fms  OVERRUNS %llu",
+			 (double) take->length / getRecordingSampleRate(), getRecordingLatency(), 
+			 (unsigned long long) getRecordingOverruns());
+
+	if(!optionsIsShowing()) showRecordingWave(take, record_status);
+}
+
+void handlePitchDetected(const double rate, const int resample)
+{
+	if(resample) handleResampleRateText(rate);
+	else handleSampleRateText(rate);
+
+	repaintGUI();
+}
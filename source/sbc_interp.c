@@ -0,0 +1,458 @@
+#include <math.h>
+
+#include "sbc_common.h"
+#include "sbc_interp.h"
+
+/* same values as the old per-sample conversion, with the divisor picked instead of branching */
+#define S16TOF32(x)		(float) ((double) (x) / ((x) > 0 ? 32767. : 32768.))
+#define FRAC_SCALE		4294967296.0
+
+/* S-DSP clamp, compiles to a pair of conditional moves */
+#define DSP_CLAMP16(s)	((s) < INT16_MIN ? INT16_MIN : (s) > INT16_MAX ? INT16_MAX : (s))
+
+/* outputs gathered per integer Gaussian batch */
+#define GAUSS_BATCH		64
+
+/*
+*   the S-DSP's own 11 bit Gaussian table, as dumped from the SNES. the four taps for a
+*   fractional position i (0 .. 255) are gauss[255 - i], gauss[511 - i], gauss[256 + i] and gauss[i],
+*   oldest sample first, and every row sums to ~2048
+*/
+static const int16_t gauss[512] =
+{
+	   0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	   1,    1,    1,    1,    1,    1,    1,    1,    1,    1,    1,    2,    2,    2,    2,    2,
+	   2,    2,    3,    3,    3,    3,    3,    4,    4,    4,    4,    4,    5,    5,    5,    5,
+	   6,    6,    6,    6,    7,    7,    7,    8,    8,    8,    9,    9,    9,   10,   10,   10,
+	  11,   11,   11,   12,   12,   13,   13,   14,   14,   15,   15,   15,   16,   16,   17,   17,
+	  18,   19,   19,   20,   20,   21,   21,   22,   23,   23,   24,   24,   25,   26,   27,   27,
+	  28,   29,   29,   30,   31,   32,   32,   33,   34,   35,   36,   36,   37,   38,   39,   40,
+	  41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51,   52,   53,   54,   55,   56,
+	  58,   59,   60,   61,   62,   64,   65,   66,   67,   69,   70,   71,   73,   74,   76,   77,
+	  78,   80,   81,   83,   84,   86,   87,   89,   90,   92,   94,   95,   97,   99,  100,  102,
+	 104,  106,  107,  109,  111,  113,  115,  117,  118,  120,  122,  124,  126,  128,  130,  132,
+	 134,  137,  139,  141,  143,  145,  147,  150,  152,  154,  156,  159,  161,  163,  166,  168,
+	 171,  173,  175,  178,  180,  183,  186,  188,  191,  193,  196,  199,  201,  204,  207,  210,
+	 212,  215,  218,  221,  224,  227,  230,  233,  236,  239,  242,  245,  248,  251,  254,  257,
+	 260,  263,  267,  270,  273,  276,  280,  283,  286,  290,  293,  297,  300,  304,  307,  311,
+	 314,  318,  321,  325,  328,  332,  336,  339,  343,  347,  351,  354,  358,  362,  366,  370,
+	 374,  378,  381,  385,  389,  393,  397,  401,  405,  410,  414,  418,  422,  426,  430,  434,
+	 439,  443,  447,  451,  456,  460,  464,  469,  473,  477,  482,  486,  491,  495,  499,  504,
+	 508,  513,  517,  522,  527,  531,  536,  540,  545,  550,  554,  559,  563,  568,  573,  577,
+	 582,  587,  592,  596,  601,  606,  611,  615,  620,  625,  630,  635,  640,  644,  649,  654,
+	 659,  664,  669,  674,  678,  683,  688,  693,  698,  703,  708,  713,  718,  723,  728,  732,
+	 737,  742,  747,  752,  757,  762,  767,  772,  777,  782,  787,  792,  797,  802,  806,  811,
+	 816,  821,  826,  831,  836,  841,  846,  851,  855,  860,  865,  870,  875,  880,  884,  889,
+	 894,  899,  904,  908,  913,  918,  923,  927,  932,  937,  941,  946,  951,  955,  960,  965,
+	 969,  974,  978,  983,  988,  992,  997, 1001, 1005, 1010, 1014, 1019, 1023, 1027, 1032, 1036,
+	1040, 1045, 1049, 1053, 1057, 1061, 1066, 1070, 1074, 1078, 1082, 1086, 1090, 1094, 1098, 1102,
+	1106, 1109, 1113, 1117, 1121, 1125, 1128, 1132, 1136, 1139, 1143, 1146, 1150, 1153, 1157, 1160,
+	1164, 1167, 1170, 1174, 1177, 1180, 1183, 1186, 1190, 1193, 1196, 1199, 1202, 1205, 1207, 1210,
+	1213, 1216, 1219, 1221, 1224, 1227, 1229, 1232, 1234, 1237, 1239, 1241, 1244, 1246, 1248, 1251,
+	1253, 1255, 1257, 1259, 1261, 1263, 1265, 1267, 1269, 1270, 1272, 1274, 1275, 1277, 1279, 1280,
+	1282, 1283, 1284, 1286, 1287, 1288, 1290, 1291, 1292, 1293, 1294, 1295, 1296, 1297, 1297, 1298,
+	1299, 1300, 1300, 1301, 1302, 1302, 1303, 1303, 1303, 1304, 1304, 1304, 1304, 1304, 1305, 1305
+};
+
+/* 
+*  Input samples are 16-bit signed PCM.
+*  offset is the fractional sampling position (0.0 .. 0.999inf).
+*  Output is -32768.0 .. 32767.0f.
+*/
+static inline double getGaussianInterpolation(const double s0, const double s1, const double s2, const double s3, const double offset)
+{
+	const int32_t i = (int32_t) (offset * 256.0f);
+
+	return ((s0 * gauss[255 - i]) + (s1 * gauss[511 - i]) + (s2 * gauss[256 + i]) + (s3 * gauss[i])) / 2048.0;
+}
+
+static inline double getCubicInterpolation(const double s0, const double s1, const double s2, const double s3, const double offset)
+{
+	const double a = (3. * (s1 - s2) - s0 + s3) / 2.,
+				 b = 2. * s2 + s0 - (5. * s1 + s3) / 2.,
+				 c = (s2 - s0) / 2.;
+
+	return (((a * offset) + b) * offset + c) * offset + s1;
+}
+
+static inline double getLinearInterpolations(const double s2, const double s3, const double offset)
+{
+	return s2 + (offset * (s3 - s2));
+}
+
+void applySampleInterpolation(const Interpolation_t *i, double *outL, double *outR, const double offset)
+{
+	switch(i->type)
+	{
+		case NEAREST:
+
+			*outL = i->tmpL[3];
+			*outR = i->tmpL[3];
+
+			break;
+
+		case LINEAR:
+
+			*outL = getLinearInterpolations(i->tmpL[2], i->tmpL[3], offset);
+			*outR = getLinearInterpolations(i->tmpR[2], i->tmpR[3], offset);
+
+			break;
+
+		case CUBIC:
+
+			*outL = getCubicInterpolation(i->tmpL[0], i->tmpL[1], i->tmpL[2], i->tmpL[3], offset);
+			*outR = getCubicInterpolation(i->tmpR[0], i->tmpR[1], i->tmpR[2], i->tmpR[3], offset);
+
+			break;
+
+		case GAUSS:
+                        
+			*outL = getGaussianInterpolation(i->tmpL[0], i->tmpL[1], i->tmpL[2], i->tmpL[3], offset);
+			*outR = getGaussianInterpolation(i->tmpR[0], i->tmpR[1], i->tmpR[2], i->tmpR[3], offset);
+
+			break;
+	}
+}
+
+void shiftFilterCoeff(Interpolation_t *i, const float in_samp)
+{
+	i->tmpL[0] = i->tmpL[1];
+	i->tmpL[1] = i->tmpL[2];
+	i->tmpL[2] = i->tmpL[3];
+	i->tmpL[3] = in_samp;
+	
+	i->tmpR[0] = i->tmpR[1];
+	i->tmpR[1] = i->tmpR[2];
+	i->tmpR[2] = i->tmpR[3];
+	i->tmpR[3] = in_samp;
+}
+
+void clearInterpolation(Interpolation_t* i)
+{
+	memset(i, 0, sizeof *i - sizeof(i->type));
+}
+
+
+void clearVoice(Voice_t *v)
+{
+	const InterpolationType_t type = v->type;
+
+	memset(v, 0, sizeof *v);
+	v->type = type;
+}
+
+/* the float interpolators, the same sums as applySampleInterpolation on the mono history */
+static inline double interpolate_voice(const int16_t *h, const uint32_t frac, const InterpolationType_t type)
+{
+	const double offset = (double) frac / FRAC_SCALE;
+
+	switch(type)
+	{
+		case NEAREST: return h[3];
+		case LINEAR:  return getLinearInterpolations(h[2], h[3], offset);
+		case CUBIC:   return getCubicInterpolation(h[0], h[1], h[2], h[3], offset);
+		case GAUSS:   return getGaussianInterpolation(h[0], h[1], h[2], h[3], offset);
+	}
+
+	return 0.0;
+}
+
+/*
+*   steps past the current output the same way incrementSample used to: every input sample the position
+*   crosses is shifted into the history, and a loop restarts exactly on loop_start. returns false,
+*   without moving, once the voice runs off the end of its buffer
+*/
+static inline bool advance_voice(Voice_t *v)
+{
+	const uint64_t next = (uint64_t) v->frac + v->step;
+	const int64_t whole = v->pos + (int64_t) (next >> 32);
+
+	if(whole > v->length)
+	{
+		v->ended = true;
+		return false;
+	}
+
+	if(whole == v->pos + 1)
+	{
+		v->hist[0] = v->hist[1];
+		v->hist[1] = v->hist[2];
+		v->hist[2] = v->hist[3];
+		v->hist[3] = v->buffer[v->pos];
+	}
+	else if(whole > v->pos)
+	{
+		/* a step of more than a sample shifts in everything it passes, only the last four can matter */
+		for(int64_t p = whole - v->pos > 4 ? whole - 4 : v->pos; p < whole; p++)
+		{
+			v->hist[0] = v->hist[1];
+			v->hist[1] = v->hist[2];
+			v->hist[2] = v->hist[3];
+			v->hist[3] = v->buffer[p];
+		}
+	}
+
+	v->pos  = whole;
+	v->frac = (uint32_t) next;
+
+	if(v->looped && (v->pos > v->loop_end || (v->pos == v->loop_end && v->frac > 0)))
+	{
+		v->pos  = v->loop_start;
+		v->frac = 0;
+	}
+
+	return true;
+}
+
+/*
+*   type is a constant in each of the kernels below, so the switch drops out of the loop. the kernels
+*   step a local copy of the voice, otherwise every history store might alias the sample buffer
+*   and nothing would stay in a register
+*/
+static inline int render_voice(Voice_t *voice, float *out, const int frames, const InterpolationType_t type)
+{
+	Voice_t v = *voice;
+	int n = 0;
+
+	for(; n < frames && !v.ended; n++)
+	{
+		const float y = S16TOF32(interpolate_voice(v.hist, v.frac, type));
+
+		if(!advance_voice(&v)) break;
+
+		out[n] = y;
+	}
+
+	*voice = v;
+
+	if(n < frames) memset(out + n, 0, (size_t) (frames - n) * sizeof *out);
+
+	return n;
+}
+
+static int render_nearest(Voice_t *v, float *out, const int frames) { return render_voice(v, out, frames, NEAREST); }
+static int render_linear(Voice_t *v, float *out, const int frames)  { return render_voice(v, out, frames, LINEAR);  }
+static int render_cubic(Voice_t *v, float *out, const int frames)   { return render_voice(v, out, frames, CUBIC);   }
+
+/*
+*   the S-DSP's integer Gaussian: each tap is scaled down to 16 bits on its own, the first three
+*   wrap around as a 16 bit sum, the last is added and clamped, and the low bit is dropped.
+*   s and g hold each output's four samples and four coefficients, oldest first
+*/
+typedef void (*GaussKernel_t)(const int16_t (*s)[4], const int16_t (*g)[4], float *out, const int count);
+typedef void (*GaussKernelS16_t)(const int16_t (*s)[4], const int16_t (*g)[4], int16_t *out, const int count);
+
+/* gauss laid out by row, so gathering an output's coefficients is a single 8 byte copy */
+static int16_t gauss_rows[256][4];
+
+static GaussKernel_t gauss_kernel = NULL;
+static GaussKernelS16_t gauss_kernel_s16 = NULL;
+
+static inline int16_t sdsp_gauss(const int16_t *s, const int16_t *g)
+{
+	int y = ((s[0] * g[0]) >> 11) + ((s[1] * g[1]) >> 11) + ((s[2] * g[2]) >> 11);
+
+	y = (int16_t) y;
+	y += (s[3] * g[3]) >> 11;
+
+	return (int16_t) (DSP_CLAMP16(y) & ~1);
+}
+
+static void scalar_gauss(const int16_t (*s)[4], const int16_t (*g)[4], float *out, const int count)
+{
+	for(int n = 0; n < count; n++)
+	{
+		const int16_t y = sdsp_gauss(s[n], g[n]);
+
+		out[n] = S16TOF32(y);
+	}
+}
+
+static void scalar_gauss_s16(const int16_t (*s)[4], const int16_t (*g)[4], int16_t *out, const int count)
+{
+	for(int n = 0; n < count; n++) out[n] = sdsp_gauss(s[n], g[n]);
+}
+
+#ifdef SBC_X86_SIMD
+/* the 32 bit products of two outputs' taps, scaled down by 11 bits, one output per vector */
+__attribute__((target("sse2")))
+static inline void sse2_gauss_taps(const int16_t *s, const int16_t *g, __m128i *first, __m128i *second)
+{
+	const __m128i a = _mm_loadu_si128((const __m128i*) s), b = _mm_loadu_si128((const __m128i*) g),
+	              p_lo = _mm_mullo_epi16(a, b), p_hi = _mm_mulhi_epi16(a, b);
+
+	*first  = _mm_srai_epi32(_mm_unpacklo_epi16(p_lo, p_hi), 11);
+	*second = _mm_srai_epi32(_mm_unpackhi_epi16(p_lo, p_hi), 11);
+}
+
+/* four outputs' sums, transposed so each tap sits in its own vector */
+__attribute__((target("sse2")))
+static inline __m128i sse2_gauss_4(const int16_t (*s)[4], const int16_t (*g)[4])
+{
+	__m128i o0, o1, o2, o3, lo01, lo23, hi01, hi23, y;
+
+	sse2_gauss_taps(s[0], g[0], &o0, &o1);
+	sse2_gauss_taps(s[2], g[2], &o2, &o3);
+
+	lo01 = _mm_unpacklo_epi32(o0, o1);
+	lo23 = _mm_unpacklo_epi32(o2, o3);
+	hi01 = _mm_unpackhi_epi32(o0, o1);
+	hi23 = _mm_unpackhi_epi32(o2, o3);
+
+	y = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi64(lo01, lo23), _mm_unpackhi_epi64(lo01, lo23)),
+	                  _mm_unpacklo_epi64(hi01, hi23));
+
+	/* wraps the first three taps to 16 bits */
+	y = _mm_srai_epi32(_mm_slli_epi32(y, 16), 16);
+
+	return _mm_add_epi32(y, _mm_unpackhi_epi64(hi01, hi23));
+}
+
+/* S16TOF32 on two outputs, the division is done in double just like the macro so the results match */
+__attribute__((target("sse2")))
+static inline __m128 sse2_s16_to_f32(const __m128i y)
+{
+	const __m128d q = _mm_cvtepi32_pd(y),
+	              d = _mm_or_pd(_mm_and_pd(_mm_cmpgt_pd(q, _mm_setzero_pd()), _mm_set1_pd(32767.)),
+	                            _mm_andnot_pd(_mm_cmpgt_pd(q, _mm_setzero_pd()), _mm_set1_pd(32768.)));
+
+	return _mm_cvtpd_ps(_mm_div_pd(q, d));
+}
+
+/* eight outputs at a time, the saturating pack does the final clamp */
+__attribute__((target("sse2")))
+static void sse2_gauss(const int16_t (*s)[4], const int16_t (*g)[4], float *out, const int count)
+{
+	const __m128i drop_lsb = _mm_set1_epi16((int16_t) ~1);
+	int n = 0;
+
+	for(; n + 8 <= count; n += 8)
+	{
+		const __m128i y16 = _mm_and_si128(_mm_packs_epi32(sse2_gauss_4(s + n, g + n), sse2_gauss_4(s + n + 4, g + n + 4)), drop_lsb),
+		              lo = _mm_srai_epi32(_mm_unpacklo_epi16(y16, y16), 16), hi = _mm_srai_epi32(_mm_unpackhi_epi16(y16, y16), 16);
+
+		_mm_storeu_ps(out + n,     _mm_movelh_ps(sse2_s16_to_f32(lo), sse2_s16_to_f32(_mm_shuffle_epi32(lo, 0x4E))));
+		_mm_storeu_ps(out + n + 4, _mm_movelh_ps(sse2_s16_to_f32(hi), sse2_s16_to_f32(_mm_shuffle_epi32(hi, 0x4E))));
+	}
+
+	for(; n < count; n++)
+	{
+		const int16_t y = sdsp_gauss(s[n], g[n]);
+
+		out[n] = S16TOF32(y);
+	}
+}
+
+__attribute__((target("sse2")))
+static void sse2_gauss_s16(const int16_t (*s)[4], const int16_t (*g)[4], int16_t *out, const int count)
+{
+	const __m128i drop_lsb = _mm_set1_epi16((int16_t) ~1);
+	int n = 0;
+
+	for(; n + 8 <= count; n += 8)
+	{
+		const __m128i y = _mm_packs_epi32(sse2_gauss_4(s + n, g + n), sse2_gauss_4(s + n + 4, g + n + 4));
+
+		_mm_storeu_si128((__m128i*) (out + n), _mm_and_si128(y, drop_lsb));
+	}
+
+	for(; n < count; n++) out[n] = sdsp_gauss(s[n], g[n]);
+}
+#endif /* SBC_X86_SIMD */
+
+static void init_gauss(void)
+{
+	for(int i = 0; i < 256; i++)
+	{
+		gauss_rows[i][0] = gauss[255 - i];
+		gauss_rows[i][1] = gauss[511 - i];
+		gauss_rows[i][2] = gauss[256 + i];
+		gauss_rows[i][3] = gauss[i];
+	}
+
+	gauss_kernel = scalar_gauss;
+	gauss_kernel_s16 = scalar_gauss_s16;
+
+#ifdef SBC_X86_SIMD
+	if(__builtin_cpu_supports("sse2"))
+	{
+		gauss_kernel = sse2_gauss;
+		gauss_kernel_s16 = sse2_gauss_s16;
+	}
+#endif
+}
+
+/*
+*   steps the voice for a batch of outputs first, gathering each one's history and table row,
+*   then runs the integer Gaussian over the whole batch at once
+*/
+static int render_gauss(Voice_t *voice, float *out, const int frames)
+{
+	Voice_t v = *voice;
+	int16_t s[GAUSS_BATCH][4], g[GAUSS_BATCH][4];
+	int done = 0;
+
+	while(done < frames && !v.ended)
+	{
+		const int want = frames - done < GAUSS_BATCH ? frames - done : GAUSS_BATCH;
+		int n = 0;
+
+		for(; n < want; n++)
+		{
+			/* the top 8 bits of the S-DSP's 12 bit pitch counter pick the row */
+			memcpy(s[n], v.hist, sizeof s[n]);
+			memcpy(g[n], gauss_rows[v.frac >> 24], sizeof g[n]);
+
+			if(!advance_voice(&v)) break;
+		}
+
+		gauss_kernel((const int16_t (*)[4]) s, (const int16_t (*)[4]) g, out + done, n);
+
+		done += n;
+	}
+
+	*voice = v;
+
+	if(done < frames) memset(out + done, 0, (size_t) (frames - done) * sizeof *out);
+
+	return done;
+}
+
+RenderKernel_t getRenderKernel(const InterpolationType_t type)
+{
+	switch(type)
+	{
+		case NEAREST: return render_nearest;
+		case LINEAR:  return render_linear;
+		case CUBIC:   return render_cubic;
+		case GAUSS:   break;
+	}
+
+	if(gauss_kernel == NULL) init_gauss();
+
+	return render_gauss;
+}
+
+void sdspGaussian(const int16_t (*s)[4], const uint8_t *row, int16_t *out, const int count)
+{
+	int16_t g[GAUSS_BATCH][4];
+
+	if(gauss_kernel_s16 == NULL) init_gauss();
+
+	for(int done = 0; done < count; done += GAUSS_BATCH)
+	{
+		const int n = count - done < GAUSS_BATCH ? count - done : GAUSS_BATCH;
+
+		for(int k = 0; k < n; k++) memcpy(g[k], gauss_rows[row[done + k]], sizeof g[k]);
+
+		gauss_kernel_s16(s + done, (const int16_t (*)[4]) g, out + done, n);
+	}
+}
+
+uint64_t getVoiceStep(const double samp_rate, const double out_rate, const InterpolationType_t type)
+{
+	/* the S-DSP's pitch counter only has 12 fractional bits */
+	if(type == GAUSS) return (uint64_t) llround(samp_rate / out_rate * 4096.0) << 20;
+
+	return (uint64_t) llround(samp_rate / out_rate * FRAC_SCALE);
+}
@@ -14,6 +14,56 @@
 
 #include "sbc_textbox.h"
 
+/*
+*   two tracker style octaves, the bottom row from an octave under POLY_ROOT_NOTE and the top row
+*   from it, the row above each one holding the sharps
+*/
+static const SDL_Scancode note_keys[] =
+{
+    SDL_SCANCODE_Z, SDL_SCANCODE_S, SDL_SCANCODE_X, SDL_SCANCODE_D, SDL_SCANCODE_C, SDL_SCANCODE_V,
+    SDL_SCANCODE_G, SDL_SCANCODE_B, SDL_SCANCODE_H, SDL_SCANCODE_N, SDL_SCANCODE_J, SDL_SCANCODE_M,
+    SDL_SCANCODE_COMMA, SDL_SCANCODE_L, SDL_SCANCODE_PERIOD, SDL_SCANCODE_SEMICOLON, SDL_SCANCODE_SLASH
+};
+
+static const SDL_Scancode note_keys_high[] =
+{
+    SDL_SCANCODE_Q, SDL_SCANCODE_2, SDL_SCANCODE_W, SDL_SCANCODE_3, SDL_SCANCODE_E, SDL_SCANCODE_R,
+    SDL_SCANCODE_5, SDL_SCANCODE_T, SDL_SCANCODE_6, SDL_SCANCODE_Y, SDL_SCANCODE_7, SDL_SCANCODE_U,
+    SDL_SCANCODE_I, SDL_SCANCODE_9, SDL_SCANCODE_O, SDL_SCANCODE_0, SDL_SCANCODE_P
+};
+
+#define NUM_NOTE_KEYS (sizeof note_keys / sizeof *note_keys)
+
+static bool note_held[2][NUM_NOTE_KEYS];
+
+/* 
+*   keyState only says which keys are down, so each one is checked against whether its note is already
+*   playing. that ignores key repeats and catches releases that were missed, new notes only start if play is set
+*/
+static void handle_note_keys(const uint8_t* keyState, const bool play)
+{
+    for(int row = 0; row < 2; row++)
+    {
+        const SDL_Scancode *keys = row ? note_keys_high : note_keys;
+
+        for(int i = 0; i < (int) NUM_NOTE_KEYS; i++)
+        {
+            const uint8_t note = (uint8_t) (POLY_ROOT_NOTE + (row - 1) * 12 + i);
+
+            if(keyState[keys[i]] && !note_held[row][i] && play)
+            {
+                note_held[row][i] = true;
+                queueNote(note);
+            }
+            else if(!keyState[keys[i]] && note_held[row][i])
+            {
+                note_held[row][i] = false;
+                releaseNote(note);
+            }
+        }
+    }
+}
+
 void handle_keydown(const uint8_t* keyState)
 {
     if(isTextboxEditing())
@@ -51,10 +101,11 @@ void handle_keydown(const uint8_t* keyState)
             repaintWaveform();
         }
 
+        else if(keyState[SDL_SCANCODE_R])
+            toggleRecording();
+
         else if(keyState[SDL_SCANCODE_X])
         {
-            audioPaused();
-
             if(keyState[SDL_SCANCODE_LSHIFT] || keyState[SDL_SCANCODE_RSHIFT])
             {
                 if(handleSampleCrop())
@@ -91,8 +142,6 @@ void handle_keydown(const uint8_t* keyState)
 
         else if(keyState[SDL_SCANCODE_V])
         {
-            audioPaused();
-
             if(handleSamplePaste())
             {
                 drawNewWave();
@@ -103,8 +152,6 @@ void handle_keydown(const uint8_t* keyState)
 
         else if(keyState[SDL_SCANCODE_Z])
         {
-            audioPaused();
-            
             if(handleUndo())
             {
                 drawNewWave();
@@ -125,6 +172,8 @@ void handle_keydown(const uint8_t* keyState)
 
         if(optionsIsShowing()) return;
 
+        handle_note_keys(keyState, true);
+
         if(keyState[SDL_SCANCODE_LEFT])
         {
             if(keyState[SDL_SCANCODE_RIGHT]) return;
@@ -157,8 +206,6 @@ void handle_keydown(const uint8_t* keyState)
 
         else if(keyState[SDL_SCANCODE_DELETE])
         {
-            audioPaused();
-            
             if(handleSampleDelete())
             {
                 drawNewWave();
@@ -178,6 +225,8 @@ void handle_keydown(const uint8_t* keyState)
 
 void handle_keyup(const uint8_t* keyState)
 {
+    handle_note_keys(keyState, false);
+
     if(wasButtonClicked(getOptButton()))
     {
         click_button(getOptButton(), false);
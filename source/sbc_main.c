@@ -20,8 +20,10 @@
 #include "sbc_buttons.h"
 #include "sbc_sliders.h"
 
+#include "sbc_pitch.h"
 #include "sbc_fileload.h"
 #include "sbc_filedialog.h"
+#include "sbc_batch.h"
 
 static SDL_Texture* logo = NULL;
 
@@ -36,6 +38,11 @@ int main(int argc, char* argv[])
 	_CrtSetReportFile( _CRT_ERROR | _CRT_WARN , _CRTDBG_FILE_STDERR );
 #endif
 
+	if (isBatchArg(argc, argv)) return runBatch(argc, argv);
+
+	setErrorHandler(showErrorMsgBox);
+	setPitchDetectedCallback(handlePitchDetected);
+
 	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
 
 	if (!init())
@@ -77,6 +84,9 @@ int main(int argc, char* argv[])
 		while (!programShouldQuit())
 		{
 			handleFileDialogEvents();
+			handleResampleDone();
+			handleRecording();
+			if(updateAutoBufferSize()) repaintOptions();
 
 			while (SDL_PollEvent(&e) > 0) handleEvents(&e);
 
@@ -104,6 +114,7 @@ int main(int argc, char* argv[])
 				playAudio();
 				repaintGUI();
 			}
+			else if (notesPlaying()) playAudio();
 			else audioPaused();
 		}
 
@@ -22,7 +22,8 @@ static void scale_mouse(int* x, int *y, const int scale)
 void handleMouse(const void *event)
 {
     const SDL_Event *e = (const SDL_Event*) event;
-    int mouse_x, mouse_y, wave_focus;
+    int mouse_x, mouse_y;
+    int64_t wave_focus;
     
     if(e->window.event == SDL_WINDOWEVENT_LEAVE)
     {
@@ -4,17 +4,54 @@
 
 #include "sbc_optmenu.h"
 #include "sbc_audio.h"
+#include "sbc_fileload.h"
+#include "sbc_filesave.h"
 #include "sbc_screen.h"
 #include "sbc_gui.h"
 
-static bool show_optmenu = false, update_optmenu = false;
+static bool show_optmenu = false, update_optmenu = false, show_stats = false;
 static const Rect_t astriid_rect = { 5, 155, 160, 16, 0 };
 
-static Button_t *interpolationButtons[4], *bufferSizeButtons[4], 
-                *deviceSampRateButtons[4], *wavExport[2], *brr_button;
+/* the callback stats take the place of the output and input device menus */
+static const Rect_t stats_rect = { 155, 17, 231, 160, SBCMPURPLE };
+static uint64_t stats_timer = 0;
+
+static Button_t *interpolationButtons[4], *bufferSizeButtons[5], 
+                *deviceSampRateButtons[4], *wavExport[2], *brrEncodeButtons[2], 
+                *brrDecodeButtons[2], *brr_button, *downmixButton, *sdspPreviewButton,
+                *statsButton, *statsResetButton, *statsDumpButton;
+
+static char downmix_text[16];
 
 static Select_Menu_t *audioDrvMenu, *outputDevMenu, *inputDevMenu;
 
+/* one button cycles through LEFT, RIGHT, MID, SIDE, CH1 to CH8 and MIX */
+static const char *get_downmix_text(void)
+{
+    const char *mode_text[] = { "L", "R", "MID", "SIDE", "CH", "MIX" };
+    const DownmixMode_t mode = getDownmixMode();
+
+    if(mode == DOWNMIX_CHANNEL) snprintf(downmix_text, sizeof downmix_text, "DMX:CH%d", getDownmixChannel() + 1);
+    else snprintf(downmix_text, sizeof downmix_text, "DMX:%s", mode_text[mode]);
+
+    return downmix_text;
+}
+
+static void cycle_downmix(void)
+{
+    const DownmixMode_t mode = getDownmixMode();
+
+    if(mode == DOWNMIX_CHANNEL && getDownmixChannel() < 7) setDownmixChannel(getDownmixChannel() + 1);
+    else if(mode == DOWNMIX_SIDE) 
+    {
+        setDownmixChannel(0);
+        setDownmixMode(DOWNMIX_CHANNEL);
+    }
+    else setDownmixMode((DownmixMode_t) ((mode + 1) % NUM_DOWNMIX_MODES));
+
+    downmixButton->text = get_downmix_text();
+}
+
 static void initAudioDrvMenu(void)
 {
     audioDrvMenu = createSelectMenu("Audio Devices:", SDL_GetNumAudioDrivers(), 
@@ -58,20 +95,44 @@ void initOptMenu(void)
                     (const char*[]) {"NEAREST", "LINEAR", "CUBIC", "GAUSSIAN"}, SBCDPURPLE, 1, 
                     getCurrentInterpolationType());
 
-    initRadButtons(bufferSizeButtons, (Rect_t) { 390, 31, 64, 11, SBCDPURPLE }, 4,
-                    (const char*[]) {"256", "512", "1024", "2048"}, 0xFF000000, 1, 
-                    getAudioBufferSize());
+    /* rows a little tighter than elsewhere, so AUTO fits under the four sizes */
+    initRadButtons(bufferSizeButtons, (Rect_t) { 390, 29, 64, 9, SBCDPURPLE }, 5,
+                    (const char*[]) {"256", "512", "1024", "2048", "AUTO"}, 0xFF000000, 1, 
+                    isAutoBufferSize() ? 4 : getAudioBufferSize());
 
-    initRadButtons(deviceSampRateButtons, (Rect_t) { 460, 31, 64, 11, SBCDPURPLE }, 4,
+    initRadButtons(deviceSampRateButtons, (Rect_t) { 460, 29, 64, 9, SBCDPURPLE }, 4,
                     (const char*[]) {"32000Hz", "44100Hz", "48000Hz", "96000Hz"}, 0xFF000000, 1, 
                     getDeviceSampleRate());
     
     initRadButtons(wavExport, (Rect_t) { 4, 105, 68, 11, SBCDPURPLE }, 2,
                     (const char*[]) {"8-bit", "16-bit"}, SBCDPURPLE, 1, (int) exporting16bit());
 
+    initRadButtons(brrEncodeButtons, (Rect_t) { 76, 105, 72, 11, SBCDPURPLE }, 2,
+                    (const char*[]) {"BRR FAST", "BRR HQ"}, SBCDPURPLE, 1, (int) getBrrEncodeMode());
+
+    initRadButtons(brrDecodeButtons, (Rect_t) { 468, 107, 64, 13, SBCDPURPLE }, 2,
+                    (const char*[]) {"CLASSIC", "S-DSP"}, SBCDPURPLE, 1, (int) getBrrDecodeMode());
+
     brr_button = createButton((Rect_t) { 4, SAMPLE_HEIGHT - 26, 146, 11, SBCDPURPLE }, 
                     RAD_BUTTON, "BRR SAMPLE SELECT", 0xFF000000, 1);
 
+    downmixButton = createButton((Rect_t) { 468, 134, 68, 12, TRACKGREY }, 
+                    TXT_BUTTON, get_downmix_text(), 0xFF000000, 1);
+
+    sdspPreviewButton = createButton((Rect_t) { 4, 118, 146, 11, SBCDPURPLE }, 
+                    RAD_BUTTON, "S-DSP PREVIEW", 0xFF000000, 1);
+
+    click_button(sdspPreviewButton, isSdspPreview());
+
+    statsButton = createButton((Rect_t) { 318, 2, 64, 12, TRACKGREY }, 
+                    TXT_BUTTON, "STATS", 0xFF000000, 1);
+
+    statsResetButton = createButton((Rect_t) { 160, 162, 64, 12, TRACKGREY }, 
+                    TXT_BUTTON, "RESET", 0xFF000000, 1);
+
+    statsDumpButton = createButton((Rect_t) { 228, 162, 80, 12, TRACKGREY }, 
+                    TXT_BUTTON, "WRITE LOG", 0xFF000000, 1);
+
     initAudioDrvMenu();
     initOutputDevMenu();
     initInputDevMenu();
@@ -80,15 +141,22 @@ void initOptMenu(void)
 void freeOptMenu(void)
 {
     destroyRadButtons(interpolationButtons, 4);
-    destroyRadButtons(bufferSizeButtons, 4);
+    destroyRadButtons(bufferSizeButtons, 5);
     destroyRadButtons(deviceSampRateButtons, 4);
     destroyRadButtons(wavExport, 2);
+    destroyRadButtons(brrEncodeButtons, 2);
+    destroyRadButtons(brrDecodeButtons, 2);
 
     destroySelectMenu(&audioDrvMenu);
     destroySelectMenu(&outputDevMenu);
     destroySelectMenu(&inputDevMenu);
     
     destroyButton(&brr_button);
+    destroyButton(&downmixButton);
+    destroyButton(&sdspPreviewButton);
+    destroyButton(&statsButton);
+    destroyButton(&statsResetButton);
+    destroyButton(&statsDumpButton);
 }
 
 bool optMenuMouseDown(const int x, const int y)
@@ -97,7 +165,25 @@ bool optMenuMouseDown(const int x, const int y)
 
     if(!show_optmenu) return false;
 
-    if((selection = selectMenuHitbox(outputDevMenu, x, y)) > -1)
+    if(hitbox(&statsButton->rect, x, y))
+    {
+        selection = 1;
+        show_stats ^= true;
+        statsButton->text = show_stats ? "DEVICES" : "STATS";
+    }
+    else if(show_stats && hitbox(&statsResetButton->rect, x, y))
+    {
+        selection = 1;
+        resetAudioEngineStats();
+    }
+    else if(show_stats && hitbox(&statsDumpButton->rect, x, y))
+    {
+        selection = 1;
+        dumpAudioEngineStats();
+    }
+    else if(show_stats && hitbox(&stats_rect, x, y))
+        return false;
+    else if((selection = selectMenuHitbox(outputDevMenu, x, y)) > -1)
     {
         if(selection >= outputDevMenu->max || selection == outputDevMenu->current) return false;
         
@@ -136,12 +222,18 @@ bool optMenuMouseDown(const int x, const int y)
         setInterpolationType(selection);
         radButtonClick(interpolationButtons, 4, getCurrentInterpolationType());
     }
-    else if((selection = radButtonHitbox(bufferSizeButtons, 4, x, y)) > -1)
+    else if((selection = radButtonHitbox(bufferSizeButtons, 5, x, y)) > -1)
     {
-        if(selection > 3) return false;
-        if(!setAudioBufferSize(selection)) return false;
+        if(selection > 4) return false;
 
-        radButtonClick(bufferSizeButtons, 4, getAudioBufferSize());
+        if(selection == 4)
+        {
+            if(isAutoBufferSize()) return false;
+            setAutoBufferSize(true);
+        }
+        else if(!setAudioBufferSize(selection)) return false;
+
+        radButtonClick(bufferSizeButtons, 5, isAutoBufferSize() ? 4 : getAudioBufferSize());
     }
     else if((selection = radButtonHitbox(deviceSampRateButtons, 4, x, y)) > -1)
     {
@@ -157,12 +249,39 @@ bool optMenuMouseDown(const int x, const int y)
         set16bitExport(selection);
         radButtonClick(wavExport, 2, exporting16bit());
     }
+    else if((selection = radButtonHitbox(brrEncodeButtons, 2, x, y)) > -1)
+    {
+        if(selection > 1) return false;
+
+        setBrrEncodeMode((BrrEncodeMode_t) selection);
+        radButtonClick(brrEncodeButtons, 2, (int) getBrrEncodeMode());
+    }
+    else if((selection = radButtonHitbox(brrDecodeButtons, 2, x, y)) > -1)
+    {
+        if(selection > 1) return false;
+
+        setBrrDecodeMode((BrrDecodeMode_t) selection);
+        radButtonClick(brrDecodeButtons, 2, (int) getBrrDecodeMode());
+    }
+    else if(hitbox(&downmixButton->rect, x, y))
+    {
+        selection = 1;
+        cycle_downmix();
+        SBC_LOG(DOWNMIX, %s, downmixButton->text);
+    }
     else if(hitbox(&brr_button->rect, x, y))
     {
         selection = 1;
         click_button(brr_button, brr_button->clicked ^ 1);
         SBC_LOG(BRR SELECT, %s, brr_button->clicked ? "TRUE" : "FALSE");
     }
+    else if(hitbox(&sdspPreviewButton->rect, x, y))
+    {
+        selection = 1;
+        setSdspPreview(!isSdspPreview());
+        click_button(sdspPreviewButton, isSdspPreview());
+        SBC_LOG(S-DSP PREVIEW, %s, isSdspPreview() ? "TRUE" : "FALSE");
+    }
     else if(hitbox(&astriid_rect, x, y))
     {
 #if defined (_WIN32)
@@ -185,14 +304,20 @@ bool optMenuMouseMove(const int x, const int y, const int mouse_is_down)
 
     (void) mouse_is_down;
 
-    if(selectMenuHitbox(outputDevMenu, x, y) > -1) update = true;
+    if(hitbox(&statsButton->rect, x, y)) update = true;
+    else if(show_stats && hitbox(&stats_rect, x, y)) update = false;
+    else if(selectMenuHitbox(outputDevMenu, x, y) > -1) update = true;
     else if(selectMenuHitbox(inputDevMenu, x, y) > -1) update = true;
     else if(selectMenuHitbox(audioDrvMenu, x, y) > -1) update = true;
     else if(radButtonHitbox(interpolationButtons, 4, x, y) > -1) update = true;
-    else if(radButtonHitbox(bufferSizeButtons, 4, x, y) > -1) update = true;
+    else if(radButtonHitbox(bufferSizeButtons, 5, x, y) > -1) update = true;
     else if(radButtonHitbox(deviceSampRateButtons, 4, x, y) > -1) update = true;
     else if(radButtonHitbox(wavExport, 2, x, y) > -1) update = true;
+    else if(radButtonHitbox(brrEncodeButtons, 2, x, y) > -1) update = true;
+    else if(radButtonHitbox(brrDecodeButtons, 2, x, y) > -1) update = true;
+    else if(hitbox(&downmixButton->rect, x, y)) update = true;
     else if(hitbox(&brr_button->rect, x, y)) update = true;
+    else if(hitbox(&sdspPreviewButton->rect, x, y)) update = true;
     else if(hitbox(&astriid_rect, x, y)) update = true;
 
     return update;
@@ -206,26 +331,113 @@ static void paintSelectMenus(void)
     draw_Vline(386, 0, 17, 0xFF2E2E2E);
     draw_Vline(154, 0, 17, 0xFFBEBEBE);
 
-    paintSelectMenu(outputDevMenu);
-    paintSelectMenu(inputDevMenu);
+    if(!show_stats)
+    {
+        paintSelectMenu(outputDevMenu);
+        paintSelectMenu(inputDevMenu);
+    }
+
     paintSelectMenu(audioDrvMenu);
 }
 
+static double stats_ms(const uint64_t total, const uint64_t count) { return (double) total / (count > 0 ? (double) count : 1.0) / 1e6; }
+
+/* the bin at least pct of a size's callbacks fell under, as the percent of the deadline it stands for */
+static const char *load_text(const Audio_Stats_Snapshot_t *snap, const int size, const double pct, char *text, const size_t len)
+{
+    const int bin = getAudioStatsLoadPercentile(snap, size, pct);
+
+    if(getAudioStatsLoadCount(snap, size) == 0) snprintf(text, len, "   -");
+    else if(bin == AUDIO_STATS_BINS - 1) snprintf(text, len, "OVER");
+    else snprintf(text, len, "<%2d%%", (bin + 1) * 10);
+
+    return text;
+}
+
+static void paintStats(void)
+{
+    const int text_c[2] = { 0xFF121212, SBCLGREY }, size_c[2] = { SCROLLPINK, 0xFF121212 }, off[2] = { 1, 1 }, 
+              x = stats_rect.x + 4, size = getAudioBufferSize(), graph_y = stats_rect.y + 138, graph_h = 30;
+
+    Audio_Stats_Snapshot_t snap;
+    char line[40], med[8], p99[8];
+    uint64_t peak = 1;
+    int y = stats_rect.y + 4;
+
+    getAudioEngineStats(&snap);
+
+    fill_rect(stats_rect);
+
+    print_string_shadow("Callback Stats:", stats_rect.x + 1, 5, (int[]) {1, 0}, (int[]) {SBCMPURPLE, 0xFF121212}, 1);
+
+    snprintf(line, sizeof line, "CALLBACKS %llu", (unsigned long long) snap.callbacks);
+    print_string_shadow(line, x, y, off, text_c, 1);
+
+    snprintf(line, sizeof line, "DEADLINE  %.2fms", (double) snap.deadline / 1e6);
+    print_string_shadow(line, x, y += 10, off, text_c, 1);
+
+    snprintf(line, sizeof line, "RENDER    %.2f/%.2fms", stats_ms(snap.render_total, snap.callbacks), stats_ms(snap.render_max, 1));
+    print_string_shadow(line, x, y += 10, off, text_c, 1);
+
+    snprintf(line, sizeof line, "JITTER    %.2f/%.2fms", stats_ms(snap.jitter_total, snap.intervals), stats_ms(snap.jitter_max, 1));
+    print_string_shadow(line, x, y += 10, off, text_c, 1);
+
+    snprintf(line, sizeof line, "OVERLOADS %llu  LATE %llu", (unsigned long long) snap.overloads, (unsigned long long) snap.late);
+    print_string_shadow(line, x, y += 10, off, text_c, 1);
+
+    print_string_shadow("SIZE   CALLS  MED  P99", x, y += 14, off, text_c, 1);
+
+    for(int i = 0; i < AUDIO_STATS_SIZES; i++)
+    {
+        snprintf(line, sizeof line, "%4d %7llu %s %s", 256 << i, (unsigned long long) getAudioStatsLoadCount(&snap, i),
+                 load_text(&snap, i, 50.0, med, sizeof med), load_text(&snap, i, 99.0, p99, sizeof p99));
+
+        print_string_shadow(line, x, y += 10, off, i == size ? size_c : text_c, 1);
+    }
+
+    /* the current buffer size's load, 10% of the deadline per bar, the last one for callbacks that missed it */
+    for(int j = 0; j < AUDIO_STATS_BINS; j++) 
+        if(snap.load[size][j] > peak) peak = snap.load[size][j];
+
+    for(int j = 0; j < AUDIO_STATS_BINS; j++)
+    {
+        const int h = (int) ((snap.load[size][j] * (uint64_t) graph_h + peak - 1) / peak);
+
+        if(h > 0) fill_rect((Rect_t) { x + j * 20, graph_y - h, 18, h, j == AUDIO_STATS_BINS - 1 ? SCROLLPINK : SBCLPURPLE });
+    }
+
+    draw_Hline(x, graph_y, AUDIO_STATS_BINS * 20 - 2, 0xFF121212);
+
+    paint_button(statsResetButton);
+    paint_button(statsDumpButton);
+}
+
 static void paintInterpolationSelect(void)
 {
+    paint_button(bufferSizeButtons[4]);
+
     for(int i = 0; i < 4; i++)
     {
         paint_button(interpolationButtons[i]);
         paint_button(bufferSizeButtons[i]);
         paint_button(deviceSampRateButtons[i]);
 
-        if(i < 2) paint_button(wavExport[i]);
+        if(i < 2)
+        {
+            paint_button(wavExport[i]);
+            paint_button(brrEncodeButtons[i]);
+            paint_button(brrDecodeButtons[i]);
+        }
     }
 
     print_string_shadow("Interpolation:", interpolationButtons[0]->rect.x - 1, 
                         interpolationButtons[0]->rect.y - interpolationButtons[0]->rect.h + 2, 
                         (int[]) {1, 1}, (int[]) {0xFF121212, SBCLGREY}, 1 );
 
+    print_string_shadow("BRR Dec:", brrDecodeButtons[0]->rect.x - 1, 
+                        brrDecodeButtons[0]->rect.y - brrDecodeButtons[0]->rect.h + 2, 
+                        (int[]) {1, 1}, (int[]) {0xFF121212, SBCLGREY}, 1 );
+
     print_string_shadow("Device Settings:", bufferSizeButtons[0]->rect.x - 1, 
                         4, (int[]) {1, 0}, (int[]) {SBCMPURPLE, 0xFF121212}, 1 );
 
@@ -237,7 +449,7 @@ static void paintInterpolationSelect(void)
                         deviceSampRateButtons[0]->rect.y - deviceSampRateButtons[0]->rect.h, 
                         (int[]) {1, 1}, (int[]) {0xFF121212, SBCLGREY}, 1 );
 
-    print_string_shadow("Export Bit Depth:", wavExport[0]->rect.x - 1,  wavExport[0]->rect.y - wavExport[0]->rect.h, 
+    print_string_shadow("Export Settings:", wavExport[0]->rect.x - 1,  wavExport[0]->rect.y - wavExport[0]->rect.h, 
                         (int[]) {1, 1}, (int[]) {0xFF121212, SBCLGREY}, 1 );
 }
 
@@ -266,7 +478,12 @@ void paintOptions(void)
     paintSelectMenus();
     paintInterpolationSelect();
 
+    if(show_stats) paintStats();
+    paint_button(statsButton);
+
     paint_button(brr_button);
+    paint_button(downmixButton);
+    paint_button(sdspPreviewButton);
 
     repaintGUI();
     update_optmenu = false;
@@ -291,5 +508,14 @@ void showOptions(void)
 }
 
 void repaintOptions(void) { if(show_optmenu) update_optmenu = true; }
+
+bool updateOptionsStats(void)
+{
+    if(!show_optmenu || !show_stats || SDL_GetTicks64() - stats_timer < 250) return false;
+
+    stats_timer = SDL_GetTicks64();
+
+    return (update_optmenu = true);
+}
 bool optionsIsShowing(void) { return show_optmenu; }
 Button_t* getBrrButton(void)  { return brr_button; }
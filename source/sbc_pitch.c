@@ -11,15 +11,16 @@
 #define pitch_thread_t void* 
 #endif
 
-#include "sbc_utils.h"
+#include "sbc_common.h"
 #include "sbc_pitch.h"
-#include "sbc_gui.h"
 #include "sbc_samp_edit.h"
 
 #define SIN(x)  ((x) < 0 ? -1 : 1) 
 #define C_FREQ  523.251130601
 #define S162FLOAT(x)   ((float) (x) / INT16_MAX)
 
+static PitchDetected_t pitch_detected = NULL;
+
 /*
 *   autocorrelation based on:
 *       https://medium.com/@jeremygustine/guitar-tuner-pitch-detection-for-dummies-64c4ae27e7ae
@@ -152,41 +153,46 @@ double get_rate_from_loop_len(const int length)
     return (freq / divider);
 }
 
+double detectSampleRate(const int16_t *samples, const int length)
+{
+    const double rate = round(samp_rate_from_c(samples, length));
+
+    return rate < (C_FREQ * 2) ? 16744 : rate;
+}
+
+static void set_detected_rate(const double rate, const int resample)
+{
+    if(resample) setResampleRate(rate);
+    else setSampleEditSampleRate(rate);
+
+    if(pitch_detected != NULL) pitch_detected(rate, resample);
+}
+
+void setPitchDetectedCallback(const PitchDetected_t callback) { pitch_detected = callback; }
+
 pitch_thread_t detect_pitch(void* arg) 
 {
     int16_t *samp_buffer = NULL, *samp_edit = (int16_t*) *getSampleEditBuffer();;
     
-    const int samp_len = *getSampleEditLength() > 0x2000 ? 0x2000 : *getSampleEditLength();
+    const int samp_len = *getSampleEditLength() > 0x2000 ? 0x2000 : (int) *getSampleEditLength();
     const int resample = arg == NULL ? 0 : *(int*) arg;
 
     double rate = 0;
 
     if(samp_edit == NULL || samp_len < 2)
     {
-        showErrorMsgBox("Threading Error!", "Unable to access sample buffer in pitch detect thread!", NULL);
+        reportError("Threading Error!", "Unable to access sample buffer in pitch detect thread!", NULL);
         return EXIT_THREAD;
     }
 
     SBC_CALLOC(samp_len, sizeof *samp_buffer, samp_buffer);
     memcpy(samp_buffer, *getSampleEditBuffer(), samp_len * sizeof *samp_buffer);
 
-    rate = round(samp_rate_from_c(samp_buffer, samp_len));
-    if(rate < (C_FREQ * 2)) rate = 16744;
+    rate = detectSampleRate(samp_buffer, samp_len);
 
     SBC_FREE(samp_buffer);
     
-    if(resample)
-    {
-        setResampleRate(rate);
-        handleResampleRateText(rate);
-    }
-    else
-    {
-        setSampleEditSampleRate(rate);
-        handleSampleRateText(*getSampleEditSampleRate());
-    }
-    
-    repaintGUI();
+    set_detected_rate(rate, resample);
 
     SBC_FREE(arg);
 
@@ -197,26 +203,17 @@ pitch_thread_t detect_pitch(void* arg)
 
 void detectCenterPitch(const int resample)
 {
-    const int length = *getSampleEditLength(),
-              loop_len = *getLoopEnd() - *getLoopStart();
+    const int64_t length = *getSampleEditLength(),
+                  loop_len = *getLoopEnd() - *getLoopStart();
 
     int *resample_arg = NULL;
 
     if(length <= 1) return;
     if(length <= 0x400 && loop_len <= 0x80) 
     {
-        const double rate = get_rate_from_loop_len(loop_len);
+        const double rate = get_rate_from_loop_len((int) loop_len);
         
-        if(resample)
-        {
-            setResampleRate(rate);
-            handleResampleRateText(rate);
-        }
-        else
-        {
-            setSampleEditSampleRate(rate);
-            handleSampleRateText(*getSampleEditSampleRate());
-        }
+        set_detected_rate(rate, resample);
 
         SBC_LOG(ADJUSTED FREQ, %lf, rate);
         return;
@@ -235,7 +232,7 @@ void detectCenterPitch(const int resample)
             FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
                             NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR)&lpMsgBuf, 0, NULL);
     
-            showErrorMsgBox("Threading Error!", "Unable to create pitch detect thread!", lpMsgBuf);
+            reportError("Threading Error!", "Unable to create pitch detect thread!", lpMsgBuf);
         }
 #else
         pthread_t pitch_thread;
@@ -247,7 +244,7 @@ void detectCenterPitch(const int resample)
         
         if(pthread_create(&pitch_thread, NULL, detect_pitch, resample_arg) != 0)
         {
-            showErrorMsgBox("Threading Error!", "Unable to create pitch detect thread!", strerror(errno));
+            reportError("Threading Error!", "Unable to create pitch detect thread!", strerror(errno));
         }
 #endif
     }
@@ -0,0 +1,238 @@
+#include <math.h>
+
+#include "sbc_common.h"
+#include "sbc_poly.h"
+
+/* outputs each voice renders before they're added into the mix */
+#define POLY_BLOCK          256
+
+/* a short fade in so a stolen voice doesn't click, and a longer one out on release */
+#define POLY_ATTACK_FRAMES  32
+#define POLY_RELEASE_FRAMES 1024
+
+/* adds in into mix, scaled by a gain that starts at gain and moves by step each output */
+typedef void (*MixKernel_t)(float *mix, const float *in, const float gain, const float step, const int count);
+
+static MixKernel_t mix_kernel = NULL;
+
+static void scalar_mix(float *mix, const float *in, const float gain, const float step, const int count)
+{
+    for(int i = 0; i < count; i++) mix[i] += in[i] * (gain + step * (float) i);
+}
+
+#ifdef SBC_X86_SIMD
+/* four outputs at a time, each lane's gain worked out the same way as the scalar loop's */
+__attribute__((target("sse2")))
+static void sse2_mix(float *mix, const float *in, const float gain, const float step, const int count)
+{
+    const __m128 g = _mm_set1_ps(gain), s = _mm_set1_ps(step), four = _mm_set1_ps(4.f);
+    __m128 index = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+    int i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        const __m128 gains = _mm_add_ps(g, _mm_mul_ps(s, index));
+
+        _mm_storeu_ps(mix + i, _mm_add_ps(_mm_loadu_ps(mix + i), _mm_mul_ps(_mm_loadu_ps(in + i), gains)));
+
+        index = _mm_add_ps(index, four);
+    }
+
+    for(; i < count; i++) mix[i] += in[i] * (gain + step * (float) i);
+}
+#endif /* SBC_X86_SIMD */
+
+static void init_mix(void)
+{
+    mix_kernel = scalar_mix;
+
+#ifdef SBC_X86_SIMD
+    if(__builtin_cpu_supports("sse2")) mix_kernel = sse2_mix;
+#endif
+}
+
+/*
+*   the source's buffer and loop points, and the step for this voice's note. a note keyed on before
+*   there's any source has nothing to play yet, and only ends once a source it's past the end of is set
+*/
+static void load_source(const Poly_Mixer_t *m, Poly_Voice_t *v)
+{
+    v->voice.type       = m->source.type;
+    v->voice.buffer     = m->source.buffer;
+    v->voice.length     = m->source.buffer != NULL ? m->source.length : 0;
+    v->voice.loop_start = m->source.loop_start;
+    v->voice.loop_end   = m->source.loop_end;
+    v->voice.looped     = m->source.looped;
+    v->voice.step       = m->out_rate > 0.0 ? getVoiceStep(m->samp_rate * v->ratio, m->out_rate, v->voice.type) : 0;
+    v->voice.ended      = v->voice.buffer == NULL || v->voice.pos >= v->voice.length;
+}
+
+/* starts a linear ramp from wherever the gain is now to target over frames outputs */
+static void ramp_gain(Poly_Voice_t *v, const float target, const int frames)
+{
+    v->target    = target;
+    v->ramp      = frames;
+    v->gain_step = (target - v->gain) / (float) frames;
+}
+
+static void step_gain(Poly_Voice_t *v, const int frames)
+{
+    v->ramp -= frames;
+    v->gain  = v->ramp > 0 ? v->gain + v->gain_step * (float) frames : v->target;
+}
+
+/* free voices first, then released ones, then the oldest */
+static bool steal_before(const Poly_Voice_t *a, const Poly_Voice_t *b)
+{
+    if(a->active != b->active) return !a->active;
+    if(a->released != b->released) return a->released;
+
+    return a->age < b->age;
+}
+
+void resetPolyMixer(Poly_Mixer_t *m)
+{
+    memset(m->voices, 0, sizeof m->voices);
+    m->age = 0;
+}
+
+void setPolySource(Poly_Mixer_t *m, const Voice_t *source, const double samp_rate, const double out_rate)
+{
+    m->source    = *source;
+    m->samp_rate = samp_rate;
+    m->out_rate  = out_rate;
+
+    for(int i = 0; i < POLY_NUM_VOICES; i++)
+    {
+        if(m->voices[i].active) load_source(m, &m->voices[i]);
+    }
+}
+
+double getPolyNoteRatio(const uint8_t note) { return pow(2.0, ((double) note - POLY_ROOT_NOTE) / 12.0); }
+
+int keyOnPolyNote(Poly_Mixer_t *m, const uint8_t note, const uint8_t velocity, const int64_t start)
+{
+    Poly_Voice_t *v = NULL;
+    int slot = 0;
+
+    for(int i = 1; i < POLY_NUM_VOICES; i++)
+    {
+        if(steal_before(&m->voices[i], &m->voices[slot])) slot = i;
+    }
+
+    v = &m->voices[slot];
+
+    memset(v, 0, sizeof *v);
+
+    v->voice.pos = start;
+
+    v->ratio  = getPolyNoteRatio(note);
+    v->note   = note;
+    v->age    = m->age++;
+    v->active = true;
+
+    load_source(m, v);
+    ramp_gain(v, (float) (velocity > 127 ? 127 : velocity) / 127.f, POLY_ATTACK_FRAMES);
+
+    return slot;
+}
+
+void keyOffPolyNote(Poly_Mixer_t *m, const uint8_t note)
+{
+    for(int i = 0; i < POLY_NUM_VOICES; i++)
+    {
+        Poly_Voice_t *v = &m->voices[i];
+
+        if(!v->active || v->released || v->note != note) continue;
+
+        v->released = true;
+        ramp_gain(v, 0.f, POLY_RELEASE_FRAMES);
+    }
+}
+
+void keyOffPolyMixer(Poly_Mixer_t *m)
+{
+    for(int i = 0; i < POLY_NUM_VOICES; i++)
+    {
+        Poly_Voice_t *v = &m->voices[i];
+
+        if(!v->active || v->released) continue;
+
+        v->released = true;
+        ramp_gain(v, 0.f, POLY_RELEASE_FRAMES);
+    }
+}
+
+bool isPolyMixerActive(const Poly_Mixer_t *m)
+{
+    for(int i = 0; i < POLY_NUM_VOICES; i++)
+    {
+        if(m->voices[i].active) return true;
+    }
+
+    return false;
+}
+
+/*
+*   each voice renders a block with its own interpolation kernel and pitch step, then the block
+*   is added into the mix through its gain ramp, and at a flat gain once the ramp has finished
+*/
+bool mixPolyVoices(Poly_Mixer_t *m, float *mix, const int frames)
+{
+    float block[POLY_BLOCK];
+    bool sounding = false;
+
+    if(mix_kernel == NULL) init_mix();
+
+    for(int i = 0; i < POLY_NUM_VOICES; i++)
+    {
+        Poly_Voice_t *v = &m->voices[i];
+        const RenderKernel_t render = getRenderKernel(v->voice.type);
+
+        for(int done = 0; done < frames && v->active; done += POLY_BLOCK)
+        {
+            const int n = frames - done < POLY_BLOCK ? frames - done : POLY_BLOCK,
+                      rendered = render(&v->voice, block, n),
+                      ramp = v->ramp < rendered ? v->ramp : rendered;
+
+            if(ramp > 0)
+            {
+                mix_kernel(mix + done, block, v->gain, v->gain_step, ramp);
+                step_gain(v, ramp);
+            }
+
+            if(rendered > ramp && v->gain != 0.f) mix_kernel(mix + done + ramp, block + ramp, v->gain, 0.f, rendered - ramp);
+
+            if(v->voice.ended || (v->released && v->ramp <= 0)) v->active = false;
+        }
+
+        sounding |= v->active;
+    }
+
+    return sounding;
+}
+
+void renderPolyEvents(Poly_Mixer_t *m, const Poly_Event_t *events, const int num_events, float *out, const int64_t frames)
+{
+    int64_t done = 0;
+    int e = 0;
+
+    memset(out, 0, (size_t) frames * sizeof *out);
+
+    while(done < frames)
+    {
+        int64_t next = frames;
+
+        for(; e < num_events && events[e].frame <= done; e++)
+        {
+            if(events[e].velocity > 0) keyOnPolyNote(m, events[e].note, events[e].velocity, m->source.pos);
+            else keyOffPolyNote(m, events[e].note);
+        }
+
+        if(e < num_events && events[e].frame < next) next = events[e].frame;
+        if(next - done > POLY_BLOCK * 64) next = done + POLY_BLOCK * 64;
+
+        mixPolyVoices(m, out + done, (int) (next - done));
+        done = next;
+    }
+}
@@ -0,0 +1,177 @@
+#include "sbc_common.h"
+#include "sbc_record.h"
+
+/* samples the drain moves through at a time */
+#define DRAIN_BLOCK 4096
+
+bool initRecordRing(Record_Ring_t *r, const size_t min_size)
+{
+    size_t size = 1;
+
+    while(size < min_size) size <<= 1;
+
+    memset(r, 0, sizeof *r);
+
+    SBC_MALLOC(size, sizeof *r->data, r->data);
+    r->size = size;
+
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+
+    return true;
+}
+
+void freeRecordRing(Record_Ring_t *r)
+{
+    SBC_FREE(r->data);
+    r->size = 0;
+}
+
+/*
+*   each side only ever stores its own index. the release on that store publishes the samples
+*   (or frees the space) before the other side's acquire can see the index move
+*/
+size_t writeRecordRing(Record_Ring_t *r, const int16_t *in, const size_t count)
+{
+    const size_t head = atomic_load_explicit(&r->head, memory_order_relaxed),
+                 tail = atomic_load_explicit(&r->tail, memory_order_acquire),
+                 space = r->size - (head - tail), n = count < space ? count : space,
+                 at = head & (r->size - 1), first = n < r->size - at ? n : r->size - at;
+
+    memcpy(r->data + at, in, first * sizeof *in);
+    memcpy(r->data, in + first, (n - first) * sizeof *in);
+
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+
+    return n;
+}
+
+size_t readRecordRing(Record_Ring_t *r, int16_t *out, const size_t max)
+{
+    const size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed),
+                 head = atomic_load_explicit(&r->head, memory_order_acquire),
+                 fill = head - tail, n = max < fill ? max : fill,
+                 at = tail & (r->size - 1), first = n < r->size - at ? n : r->size - at;
+
+    memcpy(out, r->data + at, first * sizeof *out);
+    memcpy(out + first, r->data, (n - first) * sizeof *out);
+
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+
+    return n;
+}
+
+size_t getRecordRingFill(Record_Ring_t *r)
+{
+    return atomic_load_explicit(&r->head, memory_order_acquire) - atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+/* doubles the capacity, always in whole chunks, so appending stays linear however long the take gets */
+static bool grow_take(Record_Take_t *t, const int64_t need)
+{
+    int64_t capacity = t->capacity > 0 ? t->capacity : RECORD_CHUNK, num_peaks = 0;
+    int16_t *buffer = NULL, (*peaks)[2] = NULL;
+
+    while(capacity < need) capacity *= 2;
+
+    num_peaks = capacity / RECORD_PEAK_BLOCK;
+
+    errno = 0;
+
+    if((buffer = realloc(t->buffer, (size_t) capacity * sizeof *buffer)) == NULL)
+    {
+        reportError("Memory Allocation Error!", "Recording ran out of memory! ", strerror(errno));
+        return false;
+    }
+
+    t->buffer = buffer;
+
+    if((peaks = realloc(t->peaks, (size_t) num_peaks * sizeof *peaks)) == NULL)
+    {
+        reportError("Memory Allocation Error!", "Recording ran out of memory! ", strerror(errno));
+        return false;
+    }
+
+    t->peaks = peaks;
+    t->capacity = capacity;
+    t->peak_capacity = num_peaks;
+
+    return true;
+}
+
+bool appendRecordTake(Record_Take_t *t, const int16_t *in, const int64_t count)
+{
+    if(t->length + count > t->capacity && !grow_take(t, t->length + count)) return false;
+
+    memcpy(t->buffer + t->length, in, (size_t) count * sizeof *in);
+
+    for(int64_t i = t->length; i < t->length + count; i++)
+    {
+        int16_t *peak = t->peaks[i / RECORD_PEAK_BLOCK];
+        const int16_t s = t->buffer[i];
+
+        if(i % RECORD_PEAK_BLOCK == 0)
+        {
+            peak[0] = peak[1] = s;
+            continue;
+        }
+
+        if(s < peak[0]) peak[0] = s;
+        if(s > peak[1]) peak[1] = s;
+    }
+
+    t->length += count;
+    t->num_peaks = (t->length + RECORD_PEAK_BLOCK - 1) / RECORD_PEAK_BLOCK;
+
+    return true;
+}
+
+int64_t drainRecordRing(Record_Ring_t *r, Record_Take_t *t)
+{
+    int16_t block[DRAIN_BLOCK];
+    int64_t total = 0;
+    size_t n = 0;
+
+    while((n = readRecordRing(r, block, DRAIN_BLOCK)) > 0)
+    {
+        if(!appendRecordTake(t, block, (int64_t) n)) return -1;
+
+        total += (int64_t) n;
+    }
+
+    return total;
+}
+
+bool finishRecordTake(Record_Take_t *t, Sample_t *samp, const double rate)
+{
+    int16_t *buffer = NULL;
+
+    if(t->length < 2)
+    {
+        freeRecordTake(t);
+        return false;
+    }
+
+    /* only ever shrinks, so if it can't be done in place the untrimmed buffer is just as good */
+    if((buffer = realloc(t->buffer, (size_t) t->length * sizeof *buffer)) == NULL) buffer = t->buffer;
+
+    memset(samp, 0, sizeof *samp);
+
+    samp->audio.buffer = buffer;
+    samp->audio.length = t->length;
+    samp->loop_end     = t->length;
+    samp->rate         = rate;
+
+    t->buffer = NULL;
+    freeRecordTake(t);
+
+    return true;
+}
+
+void freeRecordTake(Record_Take_t *t)
+{
+    SBC_FREE(t->buffer);
+    SBC_FREE(t->peaks);
+
+    memset(t, 0, sizeof *t);
+}
@@ -0,0 +1,568 @@
+#include <math.h>
+
+#include "sbc_common.h"
+#include "sbc_samp_edit.h"
+#include "sbc_resample.h"
+#include "sbc_threadpool.h"
+
+#define RESAMPLE_PI         3.14159265358979323846
+
+#define RESAMPLE_PHASES     1024        /* rows of the interpolated bank, for rates without a small ratio between them */
+#define RESAMPLE_MAX_PHASES 4096        /* the most rows an exact bank is built with */
+#define RESAMPLE_MAX_BANK   (1 << 22)   /* coefficients, 16MB */
+#define RESAMPLE_MAX_TAPS   4096
+#define RESAMPLE_CHUNK      (1 << 16)   /* outputs per pool task, and the least worth spinning up a pool for */
+
+typedef float (*DotProduct_t)(const int16_t *x, const float *h, const int taps);
+
+/* taps at the lower of the two rates, Kaiser beta, and the cutoff as a fraction of the lower rate's Nyquist */
+typedef struct Filter_Spec_s
+{
+    int taps;
+    double beta;
+    double cutoff;
+} filter_spec_t;
+
+static const filter_spec_t filter_specs[NUM_RESAMPLE_QUALITIES] =
+{
+    {  0,  0.0, 0.00 },     /* nearest, no filter */
+    { 32,  6.0, 0.85 },     /* ~60dB stopband */
+    { 48,  8.6, 0.88 },     /* ~90dB */
+    { 96, 10.5, 0.92 }      /* ~105dB */
+};
+
+static ResampleQuality_t resample_quality = RESAMPLE_GOOD;
+
+typedef struct Resampler_s
+{
+    const int16_t *in;
+    int64_t length, samp_start, loop_start, loop_end;
+    bool looped;
+
+    /* exact bank, output i sits (i * step_num - offset_num) / phases input samples in */
+    bool exact;
+    int64_t step_num, offset_num;
+
+    /* interpolated bank, output i sits at i * step - offset, between two of the rows */
+    double step, offset;
+
+    int taps, phases;
+    float *bank;
+    double fc, beta;
+
+    /* the first outputs at or after samp_start and loop_end */
+    int64_t start_out, loop_end_out;
+
+    DotProduct_t dot;
+} resampler_t;
+
+static int64_t gcd64(int64_t a, int64_t b)
+{
+    while(b != 0)
+    {
+        const int64_t t = a % b;
+
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+static int64_t floor_div(const int64_t a, const int64_t b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+static int64_t ceil_div(const int64_t a, const int64_t b)  { return -floor_div(-a, b); }
+
+static double bessel_i0(const double x)
+{
+    const double q = x * x / 4.0;
+    double sum = 1.0, term = 1.0;
+
+    for(int k = 1; k < 100 && term > sum * 1e-17; k++)
+    {
+        term *= q / ((double) k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+/*
+*   the filter for an output phase samples past tap taps / 2 - 1, fc in cycles per input sample.
+*   every row is scaled to unity gain at DC, so there's no ripple from phase to phase
+*/
+static void build_phase(float *row, double *tmp, const int taps, const double phase, const double fc, const double beta)
+{
+    const double half = (double) (taps / 2), i0_beta = bessel_i0(beta);
+    double sum = 0.0;
+
+    for(int j = 0; j < taps; j++)
+    {
+        const double t = (double) (j - taps / 2 + 1) - phase, r = t / half, x = 2.0 * fc * t;
+
+        tmp[j] = 0.0;
+
+        if(fabs(r) >= 1.0) continue;
+
+        tmp[j] = 2.0 * fc * (x == 0.0 ? 1.0 : sin(RESAMPLE_PI * x) / (RESAMPLE_PI * x)) * bessel_i0(beta * sqrt(1.0 - r * r)) / i0_beta;
+        sum += tmp[j];
+    }
+
+    for(int j = 0; j < taps; j++) row[j] = (float) (tmp[j] / sum);
+}
+
+/*
+*   sixteen partial sums, added up in the same order as the SSE2 version's lanes
+*   so both give bit-identical results
+*/
+static float scalar_dot(const int16_t *x, const float *h, const int taps)
+{
+    float acc[16] = { 0.f }, lane[4];
+
+    for(int j = 0; j < taps; j += 16)
+    {
+        for(int k = 0; k < 16; k++) acc[k] += (float) x[j + k] * h[j + k];
+    }
+
+    for(int k = 0; k < 4; k++) lane[k] = (acc[k] + acc[k + 4]) + (acc[k + 8] + acc[k + 12]);
+
+    return (lane[0] + lane[2]) + (lane[1] + lane[3]);
+}
+
+#ifdef SBC_X86_SIMD
+/* sign extends 4 of the 8 samples in s to float */
+__attribute__((target("sse2")))
+static inline __m128 sse2_widen_lo(const __m128i s) { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)); }
+
+__attribute__((target("sse2")))
+static inline __m128 sse2_widen_hi(const __m128i s) { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)); }
+
+/* four accumulators, so each add doesn't have to wait for the one before it */
+__attribute__((target("sse2")))
+static float sse2_dot(const int16_t *x, const float *h, const int taps)
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+
+    for(int j = 0; j < taps; j += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*) (x + j)), b = _mm_loadu_si128((const __m128i*) (x + j + 8));
+
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(sse2_widen_lo(a), _mm_loadu_ps(h + j)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(sse2_widen_hi(a), _mm_loadu_ps(h + j + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(sse2_widen_lo(b), _mm_loadu_ps(h + j + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(sse2_widen_hi(b), _mm_loadu_ps(h + j + 12)));
+    }
+
+    acc0 = _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3));
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+
+    return _mm_cvtss_f32(acc0);
+}
+#endif /* SBC_X86_SIMD */
+
+static DotProduct_t get_dot_product(void)
+{
+#ifdef SBC_X86_SIMD
+    if(__builtin_cpu_supports("sse2")) return sse2_dot;
+#endif
+    return scalar_dot;
+}
+
+/* index of the first output at or after input sample x */
+static int64_t get_out_index(const resampler_t *r, const int64_t x)
+{
+    if(r->exact) return ceil_div(x * r->phases + r->offset_num, r->step_num);
+
+    return (int64_t) ceil(((double) x + r->offset) / r->step);
+}
+
+static void init_resampler(resampler_t *r, const Sample_t *samp, const double rate, const filter_spec_t *spec)
+{
+    const double in_rate = samp->rate, ratio = in_rate / rate, scale = ratio > 1.0 ? ratio : 1.0;
+
+    int64_t num = 0, den = 0;
+
+    memset(r, 0, sizeof *r);
+
+    r->in         = samp->audio.buffer;
+    r->length     = samp->audio.length;
+    r->samp_start = samp->samp_start;
+    r->loop_start = samp->loop_start;
+    r->loop_end   = samp->loop_end;
+    r->looped     = samp->is_looped && r->loop_start < r->loop_end && r->loop_end <= r->length;
+    r->dot        = get_dot_product();
+    r->fc         = 0.5 * spec->cutoff / scale;
+    r->beta       = spec->beta;
+
+    /* longer when downsampling so the cutoff can follow the lower rate, always a multiple of 16 for the dot product */
+    r->taps = (int) ceil(spec->taps * scale);
+    r->taps = r->taps > RESAMPLE_MAX_TAPS ? RESAMPLE_MAX_TAPS : (r->taps + 15) & ~15;
+
+    /* whole number rates resample on an exact grid of rate / gcd phases */
+    if(in_rate == floor(in_rate) && rate == floor(rate) && in_rate <= INT32_MAX && rate <= INT32_MAX)
+    {
+        const int64_t g = gcd64((int64_t) in_rate, (int64_t) rate);
+
+        num = (int64_t) rate / g;
+        den = (int64_t) in_rate / g;
+
+        r->exact = num <= RESAMPLE_MAX_PHASES && num * r->taps <= RESAMPLE_MAX_BANK;
+    }
+
+    if(r->exact)
+    {
+        r->phases   = (int) num;
+        r->step_num = den;
+
+        r->start_out  = ceil_div(r->samp_start * num, den);
+        r->offset_num = r->start_out * den - r->samp_start * num;
+    }
+    else
+    {
+        r->phases = RESAMPLE_PHASES + 1;
+        r->step   = ratio;
+
+        r->start_out = (int64_t) ceil((double) r->samp_start / ratio);
+        r->offset    = (double) r->start_out * ratio - (double) r->samp_start;
+    }
+
+    r->loop_end_out = get_out_index(r, r->loop_end);
+}
+
+/*
+*   the taps input samples from first on as the output at index i should hear them: silence
+*   before samp_start once i is past it, and the loop start again after the loop end while
+*   i is still inside the loop. only copied into scratch when the window crosses one of those
+*/
+static const int16_t *get_window(const resampler_t *r, const int64_t i, const int64_t first, int16_t *scratch)
+{
+    const bool wrap = r->looped && i < r->loop_end_out;
+    const int64_t lo = i >= r->start_out ? r->samp_start : 0, hi = wrap ? r->loop_end : r->length;
+
+    if(first >= lo && first + r->taps <= hi) return r->in + first;
+
+    for(int j = 0; j < r->taps; j++)
+    {
+        int64_t k = first + j;
+
+        if(k >= hi && wrap) k = r->loop_start + (k - r->loop_end) % (r->loop_end - r->loop_start);
+
+        scratch[j] = (k < lo || k >= hi) ? 0 : r->in[k];
+    }
+
+    return scratch;
+}
+
+static int16_t float_to_s16(float y)
+{
+    y = y > -32768.f ? y : -32768.f;
+    y = y <  32767.f ? y :  32767.f;
+
+    return (int16_t) lrintf(y);
+}
+
+/* outputs first to last - 1, each one only depends on its index */
+static void resample_range(const resampler_t *r, int16_t *out, const int64_t first, const int64_t last, int16_t *scratch)
+{
+    const int centre = r->taps / 2 - 1;
+
+    /* the exact grid steps whole input samples and phases instead of dividing for every output */
+    const int64_t step_whole = r->exact ? r->step_num / r->phases : 0, step_phase = r->exact ? r->step_num % r->phases : 0;
+    int64_t exact_n = 0, exact_phase = 0;
+
+    if(r->exact)
+    {
+        const int64_t pos = first * r->step_num - r->offset_num;
+
+        exact_n = floor_div(pos, r->phases);
+        exact_phase = pos - exact_n * r->phases;
+    }
+
+    for(int64_t i = first; i < last; i++)
+    {
+        const float *h = NULL;
+        const int16_t *x = NULL;
+        float y = 0.f, frac = 0.f;
+        int64_t n = 0;
+
+        if(r->exact)
+        {
+            n = exact_n;
+            h = r->bank + (size_t) exact_phase * (size_t) r->taps;
+
+            exact_n += step_whole;
+            exact_phase += step_phase;
+
+            if(exact_phase >= r->phases)
+            {
+                exact_phase -= r->phases;
+                exact_n++;
+            }
+        }
+        else
+        {
+            const double pos = (double) i * r->step - r->offset;
+            double f = 0.0;
+            int p = 0;
+
+            n = (int64_t) floor(pos);
+            f = (pos - (double) n) * RESAMPLE_PHASES;
+            p = (int) f < RESAMPLE_PHASES ? (int) f : RESAMPLE_PHASES - 1;
+
+            frac = (float) (f - p);
+            h = r->bank + (size_t) p * (size_t) r->taps;
+        }
+
+        x = get_window(r, i, n - centre, scratch);
+        y = r->dot(x, h, r->taps);
+
+        /* the interpolated bank blends the two rows either side of the phase */
+        if(!r->exact) y += frac * (r->dot(x, h + r->taps, r->taps) - y);
+
+        out[i] = float_to_s16(y);
+    }
+}
+
+/* work shared between the pool threads, one scratch window per thread */
+typedef struct Resample_Job_s
+{
+    resampler_t *r;
+    int16_t *out;
+    int64_t length;
+
+    double *tmp;
+    int16_t *scratch;
+} resample_job_t;
+
+static void build_bank_row(void *arg, const int index, const int thread)
+{
+    const resample_job_t *job = arg;
+    const resampler_t *r = job->r;
+    const double phase = r->exact ? (double) index / r->phases : (double) index / RESAMPLE_PHASES;
+
+    build_phase(r->bank + (size_t) index * (size_t) r->taps, job->tmp + (size_t) thread * (size_t) r->taps,
+                r->taps, phase, r->fc, r->beta);
+}
+
+/* every output only depends on its index, so the chunks come out the same whichever thread runs them */
+static void resample_chunk(void *arg, const int index, const int thread)
+{
+    const resample_job_t *job = arg;
+    const int64_t first = (int64_t) index * RESAMPLE_CHUNK,
+                  last  = first + RESAMPLE_CHUNK < job->length ? first + RESAMPLE_CHUNK : job->length;
+
+    resample_range(job->r, job->out, first, last, job->scratch + (size_t) thread * (size_t) job->r->taps);
+}
+
+/* SBC's original decimator */
+static void resample_nearest(const Sample_t *samp, Sample_t *out, const double ratio)
+{
+    double pos = 0.0;
+
+    for(int64_t i = 0; i < out->audio.length; i++)
+    {
+        const int64_t p = (int64_t) floor(pos);
+
+        if(p >= samp->audio.length) break;
+
+        out->audio.buffer[i] = samp->audio.buffer[p];
+
+        pos += ratio;
+    }
+}
+
+static int64_t get_nearest_val(const int64_t in, const double ratio) { return (int64_t) ceil((double) in / ratio); }
+
+Sample_t *resampleSample(const Sample_t *samp, const double rate, const ResampleQuality_t quality, Thread_Pool_t *pool)
+{
+    Sample_t *out = NULL;
+    resampler_t r;
+    resample_job_t job;
+
+    int64_t num_chunks = 0, bank_size = 0;
+    int num_threads = 1;
+
+    assert(samp != NULL && samp->audio.buffer != NULL);
+    assert(rate > 0 && samp->rate > 0);
+
+    SBC_CALLOC(1, sizeof(Sample_t), out);
+
+    out->rate = rate;
+    out->is_looped = samp->is_looped;
+    out->pos = 0.0;
+
+    if(quality == RESAMPLE_NEAREST || quality >= NUM_RESAMPLE_QUALITIES)
+    {
+        const double ratio = samp->rate / rate;
+
+        out->audio.length = get_nearest_val(samp->audio.length, ratio);
+        out->samp_start   = get_nearest_val(samp->samp_start, ratio);
+        out->loop_start   = get_nearest_val(samp->loop_start, ratio);
+        out->loop_end     = get_nearest_val(samp->loop_end,   ratio);
+
+        SBC_CALLOC(out->audio.length, sizeof *out->audio.buffer, out->audio.buffer);
+
+        resample_nearest(samp, out, ratio);
+
+        return out;
+    }
+
+    init_resampler(&r, samp, rate, &filter_specs[quality]);
+
+    out->audio.length = get_out_index(&r, r.length);
+    out->samp_start   = r.start_out;
+    out->loop_start   = get_out_index(&r, r.loop_start);
+    out->loop_end     = get_out_index(&r, r.loop_end);
+
+    SBC_MALLOC(out->audio.length, sizeof *out->audio.buffer, out->audio.buffer);
+
+    /* long samples and big banks are split up between the pool, short ones aren't worth the threads */
+    num_chunks = (out->audio.length + RESAMPLE_CHUNK - 1) / RESAMPLE_CHUNK;
+    bank_size  = (int64_t) r.phases * r.taps;
+
+    if(pool != NULL && (num_chunks > 1 || bank_size >= RESAMPLE_CHUNK * 4)) num_threads = getPoolThreadCount(pool);
+    else pool = NULL;
+
+    memset(&job, 0, sizeof job);
+
+    job.r = &r;
+    job.out = out->audio.buffer;
+    job.length = out->audio.length;
+
+    SBC_MALLOC(bank_size, sizeof *r.bank, r.bank);
+    SBC_MALLOC(num_threads * r.taps, sizeof *job.tmp, job.tmp);
+    SBC_MALLOC(num_threads * r.taps, sizeof *job.scratch, job.scratch);
+
+    poolParallelFor(pool, build_bank_row, &job, r.phases);
+    poolParallelFor(pool, resample_chunk, &job, (int) num_chunks);
+
+    SBC_FREE(job.scratch);
+    SBC_FREE(job.tmp);
+    SBC_FREE(r.bank);
+
+    return out;
+}
+
+/*
+*   the same filters run over a stream instead of a whole sample. the bank is always exact, rates
+*   whose grid would need more than RESAMPLE_MAX_PHASES rows have their step rounded onto that many
+*/
+struct Stream_Resampler_s
+{
+    int taps, phases;
+    int64_t step_num;
+    float *bank;
+    DotProduct_t dot;
+
+    /* the input still needed, x[pos] is the first tap of the next output which is phase / phases further in */
+    int16_t *x;
+    int filled, capacity, pos;
+    int64_t phase;
+};
+
+Stream_Resampler_t *createStreamResampler(const double in_rate, const double out_rate, const ResampleQuality_t quality, const int max_frames)
+{
+    const filter_spec_t *spec = &filter_specs[quality > RESAMPLE_NEAREST && quality < NUM_RESAMPLE_QUALITIES ? quality : RESAMPLE_FAST];
+    const double ratio = in_rate / out_rate, scale = ratio > 1.0 ? ratio : 1.0;
+
+    Stream_Resampler_t *r = NULL;
+    double *tmp = NULL;
+    int64_t num = RESAMPLE_MAX_PHASES, den = 0;
+
+    assert(in_rate > 0 && out_rate > 0 && max_frames > 0);
+
+    if(in_rate == floor(in_rate) && out_rate == floor(out_rate) && in_rate <= INT32_MAX && out_rate <= INT32_MAX)
+    {
+        const int64_t g = gcd64((int64_t) in_rate, (int64_t) out_rate);
+
+        if((int64_t) out_rate / g <= RESAMPLE_MAX_PHASES)
+        {
+            num = (int64_t) out_rate / g;
+            den = (int64_t) in_rate / g;
+        }
+    }
+
+    if(den == 0) den = llround(ratio * (double) num);
+
+    SBC_CALLOC(1, sizeof *r, r);
+
+    r->taps     = (int) ceil(spec->taps * scale);
+    r->taps     = r->taps > RESAMPLE_MAX_TAPS ? RESAMPLE_MAX_TAPS : (r->taps + 15) & ~15;
+    r->phases   = (int) num;
+    r->step_num = den;
+    r->dot      = get_dot_product();
+
+    /* room for the filter and max_frames outputs' worth of new input */
+    r->capacity = r->taps + (int) ((max_frames * den) / num) + 2;
+
+    SBC_MALLOC(r->phases * r->taps, sizeof *r->bank, r->bank);
+    SBC_MALLOC(r->capacity, sizeof *r->x, r->x);
+    SBC_MALLOC(r->taps, sizeof *tmp, tmp);
+
+    for(int p = 0; p < r->phases; p++)
+        build_phase(r->bank + (size_t) p * (size_t) r->taps, tmp, r->taps, (double) p / r->phases, 0.5 * spec->cutoff / scale, spec->beta);
+
+    SBC_FREE(tmp);
+
+    resetStreamResampler(r);
+
+    return r;
+}
+
+void destroyStreamResampler(Stream_Resampler_t **r)
+{
+    if(r == NULL || *r == NULL) return;
+
+    SBC_FREE((*r)->bank);
+    SBC_FREE((*r)->x);
+    SBC_FREE(*r);
+}
+
+void resetStreamResampler(Stream_Resampler_t *r)
+{
+    /* the first output lines up with the first input, so the filter starts half full of silence */
+    r->filled = r->taps / 2 - 1;
+    r->pos    = 0;
+    r->phase  = 0;
+
+    memset(r->x, 0, (size_t) r->filled * sizeof *r->x);
+}
+
+int getStreamInputNeeded(const Stream_Resampler_t *r, const int frames)
+{
+    const int64_t last = r->pos + (r->phase + (int64_t) (frames - 1) * r->step_num) / r->phases;
+    const int64_t need = last + r->taps - r->filled;
+
+    return need > 0 ? (int) need : 0;
+}
+
+void streamResample(Stream_Resampler_t *r, const int16_t *in, float *out, const int frames)
+{
+    const int need = getStreamInputNeeded(r, frames);
+
+    assert(r->filled + need <= r->capacity);
+
+    memcpy(r->x + r->filled, in, (size_t) need * sizeof *in);
+    r->filled += need;
+
+    for(int i = 0; i < frames; i++)
+    {
+        out[i] = r->dot(r->x + r->pos, r->bank + (size_t) r->phase * (size_t) r->taps, r->taps) * (1.f / 32768.f);
+
+        r->phase += r->step_num;
+        r->pos   += (int) (r->phase / r->phases);
+        r->phase %= r->phases;
+    }
+
+    /* only the input the next output still needs is kept */
+    r->filled -= r->pos;
+    memmove(r->x, r->x + r->pos, (size_t) r->filled * sizeof *r->x);
+    r->pos = 0;
+}
+
+ResampleQuality_t getResampleQuality(void) { return resample_quality; }
+
+void setResampleQuality(const ResampleQuality_t quality)
+{
+    resample_quality = (unsigned) quality < NUM_RESAMPLE_QUALITIES ? quality : RESAMPLE_GOOD;
+}
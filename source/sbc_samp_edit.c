@@ -1,17 +1,60 @@
 #include <math.h>
 
-#include "sbc_utils.h"
-#include "sbc_textbox.h"
+#if defined (_WIN32)
+#include <Windows.h>
+#define EXIT_THREAD 0
+#define resample_thread_t DWORD WINAPI
+#else
+#include <pthread.h>
+#define EXIT_THREAD NULL
+#define resample_thread_t void*
+#endif
+
+#include "sbc_common.h"
 #include "sbc_samp_edit.h"
+#include "sbc_resample.h"
 
 #define CLAMP(x, min, max) (x) < (min) ? (min) : (x) > (max) ? (max) : (x)
 
 static Audio_Buffer_t *copy_buffer = NULL;
 static Sample_t *edit_buffer = NULL, *undo_buffer = NULL;
 
+/* 
+*   edit_buffer's audio as the audio thread sees it. a snapshot is never written to once published, 
+*   the one it replaces goes on the retired list until the callback has stopped pointing audio_hazard at it
+*/
+typedef struct Audio_Snapshot_s
+{
+    Audio_Buffer_t audio;
+    struct Audio_Snapshot_s *next;
+} Audio_Snapshot_t;
+
+static Audio_Snapshot_t *_Atomic live_audio = NULL;
+static Audio_Snapshot_t *_Atomic audio_hazard = NULL;
+static Audio_Snapshot_t *retired_audio = NULL;
+
 static char* sample_name = NULL;
 static double resample_rate = 16744.0;
 
+/* 
+*   the GUI's resample, worked out on its own thread and picked up by finishResample. edit_generation
+*   counts every buffer publish_edit_audio puts in place, so a result for audio that's since been
+*   replaced is thrown away rather than swapped in over the edit
+*/
+static _Atomic bool resample_busy = false;
+static double resample_target = 0.0;
+static Sample_t *_Atomic resample_done = NULL;
+static uint64_t edit_generation = 0, resample_generation = 0;
+
+/* kept for the editor's lifetime, so each resample doesn't start and stop a thread for every core */
+static Thread_Pool_t *resample_pool = NULL;
+
+#if defined (_WIN32)
+static HANDLE resample_handle = NULL;
+#else
+static pthread_t resample_handle;
+#endif
+
 void initSampleBuffers(void)
 {
     SBC_CALLOC(1, sizeof *edit_buffer, edit_buffer);
@@ -19,18 +62,75 @@ void initSampleBuffers(void)
     SBC_CALLOC(1, sizeof *copy_buffer, copy_buffer);
 }
 
-void setSampleEdit(const Sample_t *samp)
+/* frees every retired snapshot the audio thread isn't holding, all of them once it's gone */
+static void reclaim_snapshots(const bool audio_closed)
 {
-    assert(samp != NULL && samp->audio.buffer != NULL);
+    const Audio_Snapshot_t *in_use = audio_closed ? NULL : atomic_load(&audio_hazard);
+    Audio_Snapshot_t **link = &retired_audio;
 
-    SBC_FREE(edit_buffer->audio.buffer);
+    while(*link != NULL)
+    {
+        Audio_Snapshot_t *snap = *link;
 
-    memset(edit_buffer, 0, sizeof(Sample_t));
-    edit_buffer->audio.length = samp->audio.length;
+        if(snap == in_use)
+        {
+            link = &snap->next;
+            continue;
+        }
+
+        *link = snap->next;
+
+        SBC_FREE(snap->audio.buffer);
+        SBC_FREE(snap);
+    }
+}
+
+/* buffer becomes the edit buffer's audio, the snapshot owns it from here on and the old one is retired */
+static void publish_edit_audio(int16_t *buffer, const int64_t length)
+{
+    Audio_Snapshot_t *snap = NULL, *old = NULL;
+
+    SBC_CALLOC(1, sizeof *snap, snap);
 
-    SBC_MALLOC(edit_buffer->audio.length, sizeof *edit_buffer->audio.buffer, edit_buffer->audio.buffer);
-    memcpy(edit_buffer->audio.buffer, samp->audio.buffer, samp->audio.length * sizeof *samp->audio.buffer);
+    snap->audio.buffer = buffer;
+    snap->audio.length = length;
 
+    edit_buffer->audio.buffer = buffer;
+    edit_buffer->audio.length = length;
+
+    edit_generation++;
+
+    old = atomic_exchange(&live_audio, snap);
+
+    if(old != NULL)
+    {
+        old->next = retired_audio;
+        retired_audio = old;
+    }
+
+    reclaim_snapshots(false);
+}
+
+const Audio_Buffer_t *acquireSampleAudio(void)
+{
+    Audio_Snapshot_t *snap = NULL;
+
+    /* the snapshot could be retired between the load and the hazard store, so check it's still live after */
+    do
+    {
+        snap = atomic_load(&live_audio);
+        atomic_store(&audio_hazard, snap);
+    } 
+    while(snap != atomic_load(&live_audio));
+
+    return snap == NULL ? NULL : &snap->audio;
+}
+
+void releaseSampleAudio(void) { atomic_store(&audio_hazard, NULL); }
+
+/* everything but the audio buffer, which the caller has already put in place */
+static void set_edit_params(const Sample_t *samp)
+{
     edit_buffer->rate = samp->rate;
     
     setLoopEnable(samp->is_looped);
@@ -39,19 +139,51 @@ void setSampleEdit(const Sample_t *samp)
     setLoopEnd(samp->loop_end);
     setLoopStart(samp->loop_start);
 
-    SBC_LOG(SAMPLE START, %d, edit_buffer->samp_start);
-    SBC_LOG(LOOP START, %d, edit_buffer->loop_start);
-    SBC_LOG(LOOP END, %d, edit_buffer->loop_end);
+    SBC_LOG(SAMPLE START, %lld, (long long) edit_buffer->samp_start);
+    SBC_LOG(LOOP START, %lld, (long long) edit_buffer->loop_start);
+    SBC_LOG(LOOP END, %lld, (long long) edit_buffer->loop_end);
 
-    SBC_LOG(SAMPLE LOOP LENGTH, %d, edit_buffer->loop_end - edit_buffer->loop_start);
+    SBC_LOG(SAMPLE LOOP LENGTH, %lld, (long long) (edit_buffer->loop_end - edit_buffer->loop_start));
 
     edit_buffer->pos = 0.0;
 }
 
+void setSampleEdit(const Sample_t *samp)
+{
+    int16_t *buffer = NULL;
+
+    assert(samp != NULL && samp->audio.buffer != NULL);
+
+    SBC_MALLOC(samp->audio.length, sizeof *buffer, buffer);
+    memcpy(buffer, samp->audio.buffer, samp->audio.length * sizeof *samp->audio.buffer);
+
+    memset(edit_buffer, 0, sizeof(Sample_t));
+    publish_edit_audio(buffer, samp->audio.length);
+
+    set_edit_params(samp);
+}
+
+void adoptSampleEdit(Sample_t *samp)
+{
+    assert(samp != NULL && samp->audio.buffer != NULL);
+
+    memset(edit_buffer, 0, sizeof(Sample_t));
+    publish_edit_audio(samp->audio.buffer, samp->audio.length);
+
+    set_edit_params(samp);
+
+    samp->audio.buffer = NULL;
+    samp->audio.length = 0;
+}
+
 void clearSampleEdit(void)
 {
+    int16_t *buffer = NULL;
+
     SBC_LOG(SAMPLE, %s, "CLEARED");
-    edit_buffer->audio.length = 1;
+    SBC_CALLOC(1, sizeof *buffer, buffer);
+
+    publish_edit_audio(buffer, 1);
     edit_buffer->rate = 16726.0;
     
     edit_buffer->is_looped = 0;
@@ -61,9 +193,6 @@ void clearSampleEdit(void)
     setSampStart(0);
 
     edit_buffer->pos = 0.0;
-
-    SBC_FREE(edit_buffer->audio.buffer);
-    SBC_CALLOC(edit_buffer->audio.length, sizeof *edit_buffer->audio.buffer, edit_buffer->audio.buffer);
 }
 
 void setSampEditName(const char* name)
@@ -97,27 +226,20 @@ void setUndoBuffer(void)
 
 bool handleUndo(void)
 {
-    const size_t buffer_size = sizeof *edit_buffer->audio.buffer;
-
     if(undo_buffer->audio.buffer == NULL || undo_buffer->audio.length <= 1) return false;
 
-    SBC_FREE(edit_buffer->audio.buffer);
-
+    /* the undo buffer is used up either way, so its audio is handed over rather than copied */
     memcpy(edit_buffer, undo_buffer, sizeof *edit_buffer);
-    edit_buffer->audio.length = undo_buffer->audio.length;
-    
-    SBC_CALLOC(undo_buffer->audio.length, buffer_size, edit_buffer->audio.buffer);
-
-    memcpy(edit_buffer->audio.buffer, undo_buffer->audio.buffer, undo_buffer->audio.length * buffer_size);
+    publish_edit_audio(undo_buffer->audio.buffer, undo_buffer->audio.length);
 
-    SBC_FREE(undo_buffer->audio.buffer);
+    undo_buffer->audio.buffer = NULL;
 
     return true;
 }
 
-void copySampleRange(const int start, const int end)
+void copySampleRange(const int64_t start, const int64_t end)
 {
-    const int range = end - start;
+    const int64_t range = end - start;
 
     if(edit_buffer->audio.buffer == NULL || edit_buffer->audio.length <= 1) return;
 
@@ -130,19 +252,19 @@ void copySampleRange(const int start, const int end)
     memcpy(copy_buffer->buffer, edit_buffer->audio.buffer + start, copy_buffer->length * sizeof *copy_buffer->buffer);
 }
 
-bool cutAtCursor(const int index)
+bool cutAtCursor(const int64_t index)
 {
     copySampleRange(index, index);
     return deleteSingleSample(index);
 }
 
-bool cutSampleRange(const int start, const int end)
+bool cutSampleRange(const int64_t start, const int64_t end)
 {
     copySampleRange(start, end);
     return deleteRangeSample(start, end, true);
 }
 
-bool cropSampleRange(const int start, const int end)
+bool cropSampleRange(const int64_t start, const int64_t end)
 {
     Audio_Buffer_t temp_buffer = { NULL, end - start };
     const size_t buffer_size = sizeof *edit_buffer->audio.buffer;
@@ -166,13 +288,7 @@ bool cropSampleRange(const int start, const int end)
     
     memcpy(temp_buffer.buffer, edit_buffer->audio.buffer + start, temp_buffer.length * buffer_size);
 
-    SBC_FREE(edit_buffer->audio.buffer);
-
-    edit_buffer->audio.length = temp_buffer.length;
-
-    SBC_CALLOC(edit_buffer->audio.length, buffer_size, edit_buffer->audio.buffer);
-
-    memcpy(edit_buffer->audio.buffer, temp_buffer.buffer, edit_buffer->audio.length * buffer_size);
+    publish_edit_audio(temp_buffer.buffer, temp_buffer.length);
 
     setSampStart(0);
     
@@ -182,12 +298,10 @@ bool cropSampleRange(const int start, const int end)
     if(edit_buffer->loop_end < end) setLoopEnd(edit_buffer->loop_end - start);
     else setLoopEnd(edit_buffer->audio.length);
 
-    SBC_FREE(temp_buffer.buffer);
-
     return true;
 }
 
-bool pasteAtCursor(const int index, const bool set_undo)
+bool pasteAtCursor(const int64_t index, const bool set_undo)
 {
     Audio_Buffer_t temp_buffer = { NULL, copy_buffer->length + edit_buffer->audio.length };
     const size_t buffer_size = sizeof *edit_buffer->audio.buffer;
@@ -216,23 +330,16 @@ bool pasteAtCursor(const int index, const bool set_undo)
     if (temp_buffer.buffer == NULL) return false;
     memcpy(temp_buffer.buffer + index, copy_buffer->buffer, copy_buffer->length * buffer_size);
 
-    SBC_FREE(edit_buffer->audio.buffer);
-
-    edit_buffer->audio.length = temp_buffer.length;
-    SBC_CALLOC(edit_buffer->audio.length, buffer_size, edit_buffer->audio.buffer);
-
-    memcpy(edit_buffer->audio.buffer, temp_buffer.buffer, temp_buffer.length * buffer_size);
+    publish_edit_audio(temp_buffer.buffer, temp_buffer.length);
 
     if(edit_buffer->samp_start > index) setSampStart(edit_buffer->samp_start + copy_buffer->length);
     if(edit_buffer->loop_start > index) setLoopStart(edit_buffer->loop_start + copy_buffer->length);
     if(edit_buffer->loop_end   > index) setLoopEnd(edit_buffer->loop_end     + copy_buffer->length);
-    
-    SBC_FREE(temp_buffer.buffer);
 
     return true;
 }
 
-bool pasteOverRange(const int start, const int end)
+bool pasteOverRange(const int64_t start, const int64_t end)
 {
     setUndoBuffer();
 
@@ -240,12 +347,12 @@ bool pasteOverRange(const int start, const int end)
     return pasteAtCursor(start, false);
 }
 
-bool deleteSingleSample(const int index)
+bool deleteSingleSample(const int64_t index)
 {
     Audio_Buffer_t temp_buffer = { NULL, edit_buffer->audio.length - 1 };
     const size_t buffer_size = sizeof *edit_buffer->audio.buffer;
 
-    const int byte_index = index * (int) buffer_size;
+    const int64_t byte_index = index * (int64_t) buffer_size;
     
     if(edit_buffer->audio.buffer == NULL || edit_buffer->audio.length <= 1) return false;
     if(index < 0 || index > edit_buffer->audio.length) return false;
@@ -271,25 +378,18 @@ bool deleteSingleSample(const int index)
         memcpy(temp_buffer.buffer, edit_buffer->audio.buffer, byte_index - 1);
     }
 
-    edit_buffer->audio.length = temp_buffer.length;
-
-    SBC_FREE(edit_buffer->audio.buffer);
-
-    SBC_MALLOC(edit_buffer->audio.length, buffer_size, edit_buffer->audio.buffer);
-    memcpy(edit_buffer->audio.buffer, temp_buffer.buffer, temp_buffer.length * buffer_size);
+    publish_edit_audio(temp_buffer.buffer, temp_buffer.length);
 
     if(index <  edit_buffer->samp_start) setSampStart(edit_buffer->samp_start - 1);
     if(index <  edit_buffer->loop_start) setLoopStart(edit_buffer->loop_start - 1);
     if(index <= edit_buffer->loop_end)   setLoopEnd(edit_buffer->loop_end - 1);
 
-    SBC_FREE(temp_buffer.buffer);
-
     return true;
 }
 
-bool deleteRangeSample(const int start, const int end, const bool set_undo)
+bool deleteRangeSample(const int64_t start, const int64_t end, const bool set_undo)
 {
-    const int range = end - start;
+    const int64_t range = end - start;
     Audio_Buffer_t temp_buffer = { NULL, edit_buffer->audio.length - range};
     const size_t buffer_size = sizeof *edit_buffer->audio.buffer;
 
@@ -317,10 +417,7 @@ bool deleteRangeSample(const int start, const int end, const bool set_undo)
         memcpy(temp_buffer.buffer + start, edit_buffer->audio.buffer + end, 
                 (edit_buffer->audio.length - end) * buffer_size);
 
-    edit_buffer->audio.length = temp_buffer.length;
-
-    SBC_MALLOC(edit_buffer->audio.length, sizeof *edit_buffer->audio.buffer, edit_buffer->audio.buffer);
-    memcpy(edit_buffer->audio.buffer, temp_buffer.buffer, temp_buffer.length * buffer_size);
+    publish_edit_audio(temp_buffer.buffer, temp_buffer.length);
     
     if(edit_buffer->samp_start > end) setSampStart(edit_buffer->samp_start - range);
     else if(edit_buffer->samp_start > start) setSampStart(start);
@@ -331,81 +428,171 @@ bool deleteRangeSample(const int start, const int end, const bool set_undo)
     if(edit_buffer->loop_end > end) setLoopEnd(edit_buffer->loop_end - range);
     else if(edit_buffer->loop_end > start) setLoopEnd(start);
 
-    SBC_FREE(temp_buffer.buffer);
-
     return true;
 }
 
 void setResampleRate(const double rate) { resample_rate = rate; }
 
-int get_resample_val(const int in, const double ratio) { return (int) ceil((double) in / ratio); }
+Sample_t *createResampledSample(const Sample_t *samp, const double rate, Thread_Pool_t *pool)
+{
+    return resampleSample(samp, rate, getResampleQuality(), pool);
+}
+
+static Thread_Pool_t *get_resample_pool(void)
+{
+    if(resample_pool == NULL) resample_pool = createThreadPool(getNumCores());
+
+    return resample_pool;
+}
 
 bool handleResample(void)
 {
-    bool success = true;
     Sample_t *resample_buffer = NULL;
 
-    const size_t buffer_size = sizeof *edit_buffer->audio.buffer;
-    const double resample_ratio = edit_buffer->rate / resample_rate;
-
+    /* the resample thread has the pool to itself until it's done */
+    if(atomic_load(&resample_busy)) return false;
     if(resample_rate == edit_buffer->rate) return false;
-    if(resample_rate < 1000 || resample_rate > 48000) return false;
+    if(resample_rate < RESAMPLE_MIN_RATE || resample_rate > RESAMPLE_MAX_RATE) return false;
     if(edit_buffer->audio.buffer == NULL || edit_buffer->audio.length < 2) return false;
     
     setUndoBuffer();
 
-    SBC_CALLOC(1, sizeof(Sample_t), resample_buffer);
+    resample_buffer = createResampledSample(edit_buffer, resample_rate, get_resample_pool());
 
-    resample_buffer->rate = resample_rate;
+    adoptSampleEdit(resample_buffer);
 
-    resample_buffer->audio.length = get_resample_val(edit_buffer->audio.length, resample_ratio);
-  
-    resample_buffer->samp_start   = get_resample_val(edit_buffer->samp_start, resample_ratio);
-    resample_buffer->loop_start   = get_resample_val(edit_buffer->loop_start, resample_ratio);
-    resample_buffer->loop_end     = get_resample_val(edit_buffer->loop_end,   resample_ratio);
+    SBC_FREE(resample_buffer);
 
-    resample_buffer->is_looped = edit_buffer->is_looped;
+    return true;
+}
 
-    resample_buffer->pos = 0.0;
-    
-    SBC_CALLOC(resample_buffer->audio.length, buffer_size, resample_buffer->audio.buffer);
+static resample_thread_t resample_thread(void *arg)
+{
+    Sample_t *snapshot = arg, *resampled = createResampledSample(snapshot, resample_target, resample_pool);
+
+    SBC_FREE(snapshot->audio.buffer);
+    SBC_FREE(snapshot);
+
+    atomic_store(&resample_done, resampled);
+
+    return EXIT_THREAD;
+}
+
+/* waits for the resample thread, only ever called once it's been started */
+static void join_resample_thread(void)
+{
+#if defined (_WIN32)
+    WaitForSingleObject(resample_handle, INFINITE);
+    CloseHandle(resample_handle);
+    resample_handle = NULL;
+#else
+    pthread_join(resample_handle, NULL);
+#endif
+}
+
+/* frees a result nothing is going to swap in */
+static void free_resample_done(void)
+{
+    Sample_t *resample_buffer = atomic_exchange(&resample_done, NULL);
+
+    if(resample_buffer == NULL) return;
+
+    SBC_FREE(resample_buffer->audio.buffer);
+    SBC_FREE(resample_buffer);
+}
+
+bool startResample(void)
+{
+    Sample_t *snapshot = NULL;
+    bool started = true;
 
-    for(int i = 0; i < resample_buffer->audio.length; i++)
+    if(atomic_load(&resample_busy)) return false;
+    if(resample_rate == edit_buffer->rate) return false;
+    if(resample_rate < RESAMPLE_MIN_RATE || resample_rate > RESAMPLE_MAX_RATE) return false;
+    if(edit_buffer->audio.buffer == NULL || edit_buffer->audio.length < 2) return false;
+
+    /* the thread works from its own copy, so editing carries on safely in the meantime */
+    SBC_CALLOC(1, sizeof *snapshot, snapshot);
+    memcpy(snapshot, edit_buffer, sizeof *snapshot);
+    snapshot->audio.length = edit_buffer->audio.length;
+
+    SBC_MALLOC(snapshot->audio.length, sizeof *snapshot->audio.buffer, snapshot->audio.buffer);
+    memcpy(snapshot->audio.buffer, edit_buffer->audio.buffer, edit_buffer->audio.length * sizeof *edit_buffer->audio.buffer);
+
+    resample_target = resample_rate;
+    resample_generation = edit_generation;
+    get_resample_pool();
+    atomic_store(&resample_busy, true);
+
+#if defined (_WIN32)
+    if((resample_handle = CreateThread(NULL, 0, resample_thread, snapshot, 0, NULL)) == NULL) started = false;
+#else
+    errno = 0;
+
+    if(pthread_create(&resample_handle, NULL, resample_thread, snapshot) != 0) started = false;
+#endif
+
+    if(!started)
     {
-        const int pos = (int) floor(resample_buffer->pos);
+        reportError("Threading Error!", "Unable to create resample thread!", strerror(errno));
 
-        if(pos >= edit_buffer->audio.length) break;
+        SBC_FREE(snapshot->audio.buffer);
+        SBC_FREE(snapshot);
 
-        resample_buffer->audio.buffer[i] = edit_buffer->audio.buffer[pos];
+        atomic_store(&resample_busy, false);
+    }
 
-        resample_buffer->pos += resample_ratio;
+    return started;
+}
+
+bool finishResample(void)
+{
+    Sample_t *resample_buffer = NULL;
+
+    if(atomic_load(&resample_done) == NULL) return false;
+
+    /* it's published the result, so this only waits for it to return */
+    join_resample_thread();
+    atomic_store(&resample_busy, false);
+
+    if(resample_generation != edit_generation)
+    {
+        SBC_LOG(RESAMPLE, %s, "DROPPED, SAMPLE EDITED WHILE RESAMPLING");
+
+        free_resample_done();
+        return false;
     }
 
-    setSampleEdit(resample_buffer);
+    resample_buffer = atomic_exchange(&resample_done, NULL);
+
+    setUndoBuffer();
+    adoptSampleEdit(resample_buffer);
 
-    SBC_FREE(resample_buffer->audio.buffer);
     SBC_FREE(resample_buffer);
 
-    return success;
+    return true;
 }
 
+bool resampleIsReady(void) { return atomic_load(&resample_done) != NULL; }
+
 char *getSampEditName(void) { return sample_name; }
 
 Sample_t *getSampleEdit(void) { return edit_buffer; }
+uint64_t getSampleEditGeneration(void) { return edit_generation; }
 int16_t **getSampleEditBuffer(void) { return &edit_buffer->audio.buffer; }
 
 void setLoopEnable(const int enable) { edit_buffer->is_looped = edit_buffer->audio.buffer == NULL ? false : enable; }
 _Atomic bool *isSampEditLoopEnabled(void) { return &edit_buffer->is_looped; }
 
-void setSampStart(const int samp) { edit_buffer->samp_start = CLAMP(samp, 0, edit_buffer->loop_start); }
-void setLoopStart(const int samp) { edit_buffer->loop_start = CLAMP(samp, edit_buffer->samp_start, edit_buffer->loop_end); }
-void setLoopEnd(const int samp)   { edit_buffer->loop_end   = CLAMP(samp, edit_buffer->loop_start, edit_buffer->audio.length); }
+void setSampStart(const int64_t samp) { edit_buffer->samp_start = CLAMP(samp, 0, edit_buffer->loop_start); }
+void setLoopStart(const int64_t samp) { edit_buffer->loop_start = CLAMP(samp, edit_buffer->samp_start, edit_buffer->loop_end); }
+void setLoopEnd(const int64_t samp)   { edit_buffer->loop_end   = CLAMP(samp, edit_buffer->loop_start, edit_buffer->audio.length); }
 
-_Atomic int *getSampStart(void) { return &edit_buffer->samp_start; }
-_Atomic int *getLoopStart(void) { return &edit_buffer->loop_start; }
-_Atomic int *getLoopEnd(void)   { return &edit_buffer->loop_end; }
+_Atomic int64_t *getSampStart(void) { return &edit_buffer->samp_start; }
+_Atomic int64_t *getLoopStart(void) { return &edit_buffer->loop_start; }
+_Atomic int64_t *getLoopEnd(void)   { return &edit_buffer->loop_end; }
 
-_Atomic int *getSampleEditLength(void) 
+_Atomic int64_t *getSampleEditLength(void) 
 { 
     if(edit_buffer->audio.buffer == NULL) 
         edit_buffer->audio.length = 1; 
@@ -420,7 +607,30 @@ void resetSampPos(void) { edit_buffer->pos = (double) edit_buffer->samp_start; }
 
 void cleanUpAndFreeSampleEdit(void)
 {
-    SBC_FREE(edit_buffer->audio.buffer);
+    Audio_Snapshot_t *live = NULL;
+
+    /* a resample still running would publish into resample_done after it's been freed */
+    if(atomic_load(&resample_busy))
+    {
+        join_resample_thread();
+        atomic_store(&resample_busy, false);
+    }
+
+    free_resample_done();
+    destroyThreadPool(&resample_pool);
+
+    live = atomic_exchange(&live_audio, NULL);
+
+    /* the audio device is closed by now, so nothing is left holding a snapshot */
+    if(live != NULL)
+    {
+        live->next = retired_audio;
+        retired_audio = live;
+    }
+
+    reclaim_snapshots(true);
+    edit_buffer->audio.buffer = NULL;
+
     SBC_FREE(sample_name);
 
     SBC_FREE(undo_buffer->audio.buffer);
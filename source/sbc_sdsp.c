@@ -0,0 +1,258 @@
+#include <math.h>
+
+#include "sbc_common.h"
+#include "sbc_sdsp.h"
+#include "sbc_interp.h"
+#include "sbc_fileload.h"
+
+#define SDSP_CLAMP16(s)     ((s) < INT16_MIN ? INT16_MIN : (s) > INT16_MAX ? INT16_MAX : (s))
+
+/* outputs each voice gathers before running the Gaussian over them */
+#define SDSP_BATCH          64
+
+/* the rate counter counts down through 2048 * 5 * 3, so every period divides it */
+#define SDSP_COUNTER_RANGE  30720
+
+/* samples between envelope steps for each of the 32 rates, and where in the count each rate steps */
+static const int counter_rates[32] =
+{
+    SDSP_COUNTER_RANGE + 1,     /* never */
+          2048, 1536,
+    1280, 1024,  768,
+     640,  512,  384,
+     320,  256,  192,
+     160,  128,   96,
+      80,   64,   48,
+      40,   32,   24,
+      20,   16,   12,
+      10,    8,    6,
+       5,    4,    3,
+             2,
+             1
+};
+
+static const int counter_offsets[32] =
+{
+      1, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+    536, 0, 1040,
+         0,
+         0
+};
+
+static bool rate_steps(const int counter, const int rate) { return (counter + counter_offsets[rate]) % counter_rates[rate] == 0; }
+
+uint16_t getSdspPitch(const double samp_rate)
+{
+    const long pitch = lround(samp_rate * 4096.0 / SDSP_RATE);
+
+    return (uint16_t) (pitch < 0 ? 0 : pitch > 0x3FFF ? 0x3FFF : pitch);
+}
+
+void resetSdsp(Sdsp_t *dsp) { memset(dsp, 0, sizeof *dsp); }
+
+void keyOnSdspVoice(Sdsp_Voice_t *v, const uint8_t *brr, const size_t brr_len, const uint16_t pitch, const Sdsp_Envelope_t env)
+{
+    /* a looped file leads with the loop point's byte offset */
+    const size_t header = brr_len % 9 == 2 ? 2 : 0;
+
+    memset(v, 0, sizeof *v);
+
+    if(brr == NULL || brr_len < header + 9) return;
+
+    v->brr        = brr + header;
+    v->num_blocks = (int64_t) ((brr_len - header) / 9);
+    v->loop_block = header ? (int64_t) (brr[0] | brr[1] << 8) / 9 : 0;
+    v->loop_block = v->loop_block < v->num_blocks ? v->loop_block : 0;
+
+    v->pitch    = pitch > 0x3FFF ? 0x3FFF : pitch;
+    v->regs     = env;
+    v->env_mode = SDSP_ENV_ATTACK;
+    v->active   = true;
+
+    decodeBrrBlock(v->brr, v->decoded, v->brr_hist, BRR_DECODE_SDSP);
+}
+
+void keyOffSdspVoice(Sdsp_Voice_t *v) { v->env_mode = SDSP_ENV_RELEASE; }
+
+int64_t getSdspVoicePos(const Sdsp_Voice_t *v) { return v->block * 16 + v->brr_index; }
+
+/* the next sample into the history, moving on to the next block, the loop or the end when this one runs out */
+static void next_sample(Sdsp_Voice_t *v)
+{
+    v->hist[0] = v->hist[1];
+    v->hist[1] = v->hist[2];
+    v->hist[2] = v->hist[3];
+    v->hist[3] = v->decoded[v->brr_index];
+
+    if(++v->brr_index < 16) return;
+
+    v->brr_index = 0;
+
+    /* an end block without the loop flag silences the voice there and then, it still carries on decoding */
+    if(v->brr[v->block * 9] & 1)
+    {
+        if(!(v->brr[v->block * 9] & 2))
+        {
+            v->env_mode = SDSP_ENV_RELEASE;
+            v->env = 0;
+        }
+
+        v->block = v->loop_block;
+    }
+    else if(++v->block >= v->num_blocks) v->block = v->loop_block;
+
+    decodeBrrBlock(v->brr + v->block * 9, v->decoded, v->brr_hist, BRR_DECODE_SDSP);
+}
+
+/* one envelope step at the given rate counter, the same as the hardware's */
+static void run_envelope(Sdsp_Voice_t *v, const int counter)
+{
+    int env = v->env, rate = 0, env_data = v->regs.adsr2;
+
+    if(v->env_mode == SDSP_ENV_RELEASE)
+    {
+        v->env = env - 8 < 0 ? 0 : env - 8;
+        return;
+    }
+
+    if(v->regs.adsr1 & 0x80)
+    {
+        if(v->env_mode >= SDSP_ENV_DECAY)
+        {
+            env--;
+            env -= env >> 8;
+
+            rate = env_data & 0x1F;
+
+            if(v->env_mode == SDSP_ENV_DECAY) rate = (v->regs.adsr1 >> 3 & 0x0E) + 0x10;
+        }
+        else
+        {
+            rate = (v->regs.adsr1 & 0x0F) * 2 + 1;
+            env += rate < 31 ? 0x20 : 0x400;
+        }
+    }
+    else
+    {
+        const int mode = v->regs.gain >> 5;
+
+        env_data = v->regs.gain;
+
+        if(mode < 4)
+        {
+            /* direct gain */
+            env  = env_data * 0x10;
+            rate = 31;
+        }
+        else
+        {
+            rate = env_data & 0x1F;
+
+            if(mode == 4) env -= 0x20;
+            else if(mode < 6)
+            {
+                env--;
+                env -= env >> 8;
+            }
+            else
+            {
+                env += 0x20;
+
+                /* bent line, slows down past 3/4 */
+                if(mode > 6 && (unsigned) v->hidden_env >= 0x600) env += 0x8 - 0x20;
+            }
+        }
+    }
+
+    /* decay turns into sustain at the level in the top 3 bits of ADSR2 */
+    if((env >> 8) == (env_data >> 5) && v->env_mode == SDSP_ENV_DECAY) v->env_mode = SDSP_ENV_SUSTAIN;
+
+    v->hidden_env = env;
+
+    if((unsigned) env > 0x7FF)
+    {
+        env = env < 0 ? 0 : 0x7FF;
+
+        if(v->env_mode == SDSP_ENV_ATTACK) v->env_mode = SDSP_ENV_DECAY;
+    }
+
+    if(rate_steps(counter, rate)) v->env = env;
+}
+
+/*
+*   one voice's next count outputs added into mix. the voice is stepped first, gathering each output's
+*   history, table row and envelope, then the Gaussian runs over all of them and the envelope is applied
+*/
+static void render_voice(Sdsp_Voice_t *voice, int counter, int32_t *mix, const int count)
+{
+    Sdsp_Voice_t v = *voice;
+
+    int16_t s[SDSP_BATCH][4], y[SDSP_BATCH], env[SDSP_BATCH];
+    uint8_t row[SDSP_BATCH];
+
+    for(int done = 0; done < count; done += SDSP_BATCH)
+    {
+        const int n = count - done < SDSP_BATCH ? count - done : SDSP_BATCH;
+
+        for(int k = 0; k < n; k++)
+        {
+            memcpy(s[k], v.hist, sizeof s[k]);
+            row[k] = (uint8_t) (v.interp_pos >> 4);
+            env[k] = (int16_t) v.env;
+
+            if(--counter < 0) counter = SDSP_COUNTER_RANGE - 1;
+            run_envelope(&v, counter);
+
+            v.interp_pos += v.pitch;
+
+            while(v.interp_pos >= 0x1000)
+            {
+                v.interp_pos -= 0x1000;
+                next_sample(&v);
+            }
+        }
+
+        sdspGaussian((const int16_t (*)[4]) s, row, y, n);
+
+        for(int k = 0; k < n; k++) mix[done + k] += (y[k] * env[k] >> 11) & ~1;
+    }
+
+    if(v.env_mode == SDSP_ENV_RELEASE && v.env == 0) v.active = false;
+
+    *voice = v;
+}
+
+bool renderSdsp(Sdsp_t *dsp, int16_t *out, const int frames)
+{
+    int32_t mix[SDSP_BATCH * 4];
+    bool sounding = false;
+
+    for(int done = 0; done < frames; done += SDSP_BATCH * 4)
+    {
+        const int n = frames - done < SDSP_BATCH * 4 ? frames - done : SDSP_BATCH * 4;
+
+        memset(mix, 0, (size_t) n * sizeof *mix);
+
+        for(int i = 0; i < SDSP_NUM_VOICES; i++)
+        {
+            if(dsp->voices[i].active) render_voice(&dsp->voices[i], dsp->counter, mix, n);
+        }
+
+        for(int k = 0; k < n; k++) out[done + k] = (int16_t) SDSP_CLAMP16(mix[k]);
+
+        dsp->counter = (dsp->counter - n) % SDSP_COUNTER_RANGE;
+        if(dsp->counter < 0) dsp->counter += SDSP_COUNTER_RANGE;
+    }
+
+    for(int i = 0; i < SDSP_NUM_VOICES; i++) sounding |= dsp->voices[i].active;
+
+    return sounding;
+}
@@ -34,7 +34,7 @@ int getSliderXPos(const SliderType_t type)
     return s->x_pos;
 }
 
-int getSliderSample(const SliderType_t type)
+int64_t getSliderSample(const SliderType_t type)
 {
     const Slider_t *s = getSlider(type);
     return s->sample;
@@ -77,18 +77,18 @@ void setLoopFromSlider(const SliderType_t type)
         if (s->sample == *getSampStart()) return;
 
         setSampStart(s->sample);
-        SBC_LOG(START SAMP SLIDER, %d, s->sample);
+        SBC_LOG(START SAMP SLIDER, %lld, (long long) s->sample);
 
         if (s->sample > *getLoopStart())
         {
             setLoopStart(s->sample);
-            SBC_LOG(START LOOP SLIDER,  %d, s->sample);
+            SBC_LOG(START LOOP SLIDER,  %lld, (long long) s->sample);
         }
 
         if (s->sample > *getLoopEnd())
         {
             setLoopEnd(s->sample);
-            SBC_LOG(END LOOP SLIDER, %d, s->sample);
+            SBC_LOG(END LOOP SLIDER, %lld, (long long) s->sample);
         }
         
         break;
@@ -97,18 +97,18 @@ void setLoopFromSlider(const SliderType_t type)
         if (s->sample == *getLoopStart()) return;
 
         setLoopStart(s->sample);
-        SBC_LOG(START LOOP SLIDER,  %d, s->sample);
+        SBC_LOG(START LOOP SLIDER,  %lld, (long long) s->sample);
 
         if (s->sample < *getSampStart())
         {
             setSampStart(s->sample);
-            SBC_LOG(END LOOP SLIDER, %d, s->sample);
+            SBC_LOG(END LOOP SLIDER, %lld, (long long) s->sample);
         }
         
         if (s->sample > *getLoopEnd())
         {
             setLoopEnd(s->sample);
-            SBC_LOG(END LOOP SLIDER, %d, s->sample);
+            SBC_LOG(END LOOP SLIDER, %lld, (long long) s->sample);
         }
         
         break;
@@ -117,44 +117,47 @@ void setLoopFromSlider(const SliderType_t type)
         if (s->sample == *getLoopEnd()) return;
 
         setLoopEnd(s->sample);
-        SBC_LOG(END LOOP SLIDER, %d, s->sample);
+        SBC_LOG(END LOOP SLIDER, %lld, (long long) s->sample);
 
         if (s->sample < *getSampStart())
         {
             setSampStart(s->sample);
-            SBC_LOG(END LOOP SLIDER, %d, s->sample);
+            SBC_LOG(END LOOP SLIDER, %lld, (long long) s->sample);
         }
         
         if (s->sample < *getLoopStart())
         {
             setLoopStart(s->sample);
-            SBC_LOG(START LOOP SLIDER,  %d, s->sample);
+            SBC_LOG(START LOOP SLIDER,  %lld, (long long) s->sample);
         }
 
         break;
     }
 }
 
-void setSliderPos(const SliderType_t type, const int samp)
+/* off-screen samples only need to stay off-screen, which keeps their x in int range when zoomed in */
+static int clamp_scr(const int64_t x) { return x < -SCREEN_WIDTH ? -SCREEN_WIDTH : x > SCREEN_WIDTH * 2 ? SCREEN_WIDTH * 2 : (int) x; }
+
+void setSliderPos(const SliderType_t type, const int64_t samp)
 {
     Slider_t *s = getSlider(type);
 
     assert(s != NULL);
 
     s->sample = samp < 0 ? 0 : samp > *getSampleEditLength() ? *getSampleEditLength() : samp;
-    s->x_pos  = samp2scr(samp);    // yes we could base this on mouse x pos but more accurate to base on pos of sample
+    s->x_pos  = clamp_scr(samp2scr(samp));    // yes we could base this on mouse x pos but more accurate to base on pos of sample
     if (s->x_pos == SCREEN_WIDTH) s->x_pos = SCREEN_WIDTH - 1;
 }
 
-void setBRRSlider(const SliderType_t type, const SliderType_t ref, const int samp)
+void setBRRSlider(const SliderType_t type, const SliderType_t ref, const int64_t samp)
 {
-    int new_samp = getRelativeBrrSampBlock(samp, getSliderSample(ref));
+    int64_t new_samp = getRelativeBrrSampBlock(samp, getSliderSample(ref));
     setSliderPos(type, new_samp);
 }
 
 void setSlider(const SliderType_t type, const SliderType_t ref, const int x)
 {
-    const int samp = scr2samp(x);
+    const int64_t samp = scr2samp(x);
     setBRRSlider(type, ref, samp);
 }
 
@@ -165,19 +168,19 @@ void resetSliders(void)
     setSliderPos(END_LOOP_SLIDER,   *getLoopEnd());
 }
 
-static void paintSliderVal(const int s, const int y, const char text[10])
+static void paintSliderVal(const int64_t s, const int y, const char text[10])
 {
-    char val_text[20];
+    char val_text[28];
 
     const Rect_t text_area = { SCREEN_WIDTH - 64, y - 2, 62, 10, SBCDGREY };
     fill_rect(text_area);
-    snprintf(val_text, 20, "%s: %08X", text, s);
+    snprintf(val_text, 28, "%s: %08llX", text, (unsigned long long) s);
     print_string_shadow(val_text, SCREEN_WIDTH - 160, y, (int[]) {1, 0}, (int[]) {SBCDPURPLE, SBCLGREY}, 1);
 }
 
 void paintSliderValues(void)
 {
-    const int smpl_lgth = *getSampleEditLength() > 1 ? *getSampleEditLength() - *getSampStart() : 0;
+    const int64_t smpl_lgth = *getSampleEditLength() > 1 ? *getSampleEditLength() - *getSampStart() : 0;
 
     paintSliderVal(*getSampStart(),                    SAMPLE_HEIGHT + 50, "SMPL STRT");
     paintSliderVal(*getLoopStart() - *getSampStart(),  SAMPLE_HEIGHT + 60, "LOOP STRT");
@@ -189,7 +192,7 @@ void paintSliderValues(void)
 
 void paintSliders(void)
 {
-    if(*audioQueued()) paintSamplePos(samp2scr(*getSamplePos()));
+    if(*audioQueued()) paintSamplePos(clamp_scr(samp2scr(*getSamplePos())));
     
     if(update_slider)
     {
@@ -103,7 +103,7 @@ static void set_rate_text(Textbox_t *t)
     char *rate_text = t->text, *err;
     double rate = strtod(rate_text, &err);
 
-    if(*err != '\0' || rate < 1000 || rate > 48000)
+    if(*err != '\0' || rate < RESAMPLE_MIN_RATE || rate > RESAMPLE_MAX_RATE)
         rate = t == textboxes[SAMPLE_RATE] ? *getSampleEditSampleRate() : 16744.0;
 
     t == textboxes[SAMPLE_RATE] ? setSampleEditSampleRate(rate) : setResampleRate(rate);
@@ -0,0 +1,336 @@
+#include <stdatomic.h>
+
+#if defined (_WIN32)
+#include <Windows.h>
+#define pool_thread_t DWORD WINAPI
+#define EXIT_THREAD 0
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#define pool_thread_t void*
+#define EXIT_THREAD NULL
+#endif
+
+#include "sbc_common.h"
+#include "sbc_threadpool.h"
+
+/* spins before sleeping, pool jobs are often only a few microseconds apart */
+#define POOL_SPIN_COUNT 4096
+
+/* each thread's remaining range, packed as (lo << 32 | hi) so a steal is a single CAS */
+typedef struct Pool_Range_s
+{
+    _Atomic uint64_t range;
+    char pad[64 - sizeof(uint64_t)];
+} pool_range_t;
+
+typedef struct Pool_Worker_s
+{
+    Thread_Pool_t *pool;
+    int index;
+
+#if defined (_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} pool_worker_t;
+
+struct Thread_Pool_s
+{
+    int num_threads;
+
+    pool_worker_t *workers;
+    pool_range_t  *ranges;
+
+    PoolTask_t task;
+    void *arg;
+
+    _Atomic unsigned generation;
+    _Atomic int active;
+    _Atomic bool quit;
+
+#if defined (_WIN32)
+    SRWLOCK lock;
+    CONDITION_VARIABLE work_cond, done_cond;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond, done_cond;
+#endif
+};
+
+#if defined (_WIN32)
+#define POOL_LOCK(p)        AcquireSRWLockExclusive(&(p)->lock)
+#define POOL_UNLOCK(p)      ReleaseSRWLockExclusive(&(p)->lock)
+#define POOL_WAIT(p, c)     SleepConditionVariableSRW(&(p)->c, &(p)->lock, INFINITE, 0)
+#define POOL_WAKE_ALL(p, c) WakeAllConditionVariable(&(p)->c)
+#else
+#define POOL_LOCK(p)        pthread_mutex_lock(&(p)->lock)
+#define POOL_UNLOCK(p)      pthread_mutex_unlock(&(p)->lock)
+#define POOL_WAIT(p, c)     pthread_cond_wait(&(p)->c, &(p)->lock)
+#define POOL_WAKE_ALL(p, c) pthread_cond_broadcast(&(p)->c)
+#endif
+
+#define RANGE_LO(r)         ((uint32_t) ((r) >> 32))
+#define RANGE_HI(r)         ((uint32_t) ((r) & 0xFFFFFFFF))
+#define RANGE(lo, hi)       (((uint64_t) (lo) << 32) | (uint32_t) (hi))
+
+int getNumCores(void)
+{
+#if defined (_WIN32)
+    SYSTEM_INFO sys_info;
+    GetSystemInfo(&sys_info);
+    return sys_info.dwNumberOfProcessors > 0 ? (int) sys_info.dwNumberOfProcessors : 1;
+#else
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int) cores : 1;
+#endif
+}
+
+uint64_t getMonotonicMs(void)
+{
+#if defined (_WIN32)
+    return (uint64_t) GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+#endif
+}
+
+uint64_t getMonotonicNs(void)
+{
+#if defined (_WIN32)
+    LARGE_INTEGER count, freq;
+
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+
+    return (uint64_t) (count.QuadPart / freq.QuadPart) * 1000000000 +
+           (uint64_t) (count.QuadPart % freq.QuadPart) * 1000000000 / (uint64_t) freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+static bool take_own(pool_range_t *r, int *index)
+{
+    uint64_t curr = atomic_load(&r->range);
+
+    while(RANGE_LO(curr) < RANGE_HI(curr))
+    {
+        if(atomic_compare_exchange_weak(&r->range, &curr, RANGE(RANGE_LO(curr) + 1, RANGE_HI(curr))))
+        {
+            *index = (int) RANGE_LO(curr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool steal_half(Thread_Pool_t *pool, const int thief)
+{
+    for(int i = 1; i < pool->num_threads; i++)
+    {
+        pool_range_t *victim = &pool->ranges[(thief + i) % pool->num_threads];
+        uint64_t curr = atomic_load(&victim->range);
+
+        while(RANGE_LO(curr) < RANGE_HI(curr))
+        {
+            const uint32_t lo = RANGE_LO(curr), hi = RANGE_HI(curr), mid = lo + ((hi - lo) >> 1);
+
+            if(atomic_compare_exchange_weak(&victim->range, &curr, RANGE(lo, mid)))
+            {
+                atomic_store(&pool->ranges[thief].range, RANGE(mid, hi));
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void run_ranges(Thread_Pool_t *pool, const int thread)
+{
+    int index = 0;
+
+    do
+    {
+        while(take_own(&pool->ranges[thread], &index))
+            pool->task(pool->arg, index, thread);
+    }
+    while(steal_half(pool, thread));
+}
+
+static pool_thread_t pool_worker(void *arg)
+{
+    pool_worker_t *w = (pool_worker_t*) arg;
+    Thread_Pool_t *pool = w->pool;
+
+    unsigned seen = 0;
+
+    while(true)
+    {
+        int spin = POOL_SPIN_COUNT;
+
+        while(--spin > 0 && atomic_load(&pool->generation) == seen && !atomic_load(&pool->quit)) {}
+
+        if(spin <= 0)
+        {
+            POOL_LOCK(pool);
+
+            while(atomic_load(&pool->generation) == seen && !atomic_load(&pool->quit))
+                POOL_WAIT(pool, work_cond);
+
+            POOL_UNLOCK(pool);
+        }
+
+        if(atomic_load(&pool->quit)) break;
+
+        seen = atomic_load(&pool->generation);
+
+        run_ranges(pool, w->index);
+
+        if(atomic_fetch_sub(&pool->active, 1) == 1)
+        {
+            POOL_LOCK(pool);
+            POOL_WAKE_ALL(pool, done_cond);
+            POOL_UNLOCK(pool);
+        }
+    }
+
+    return EXIT_THREAD;
+}
+
+Thread_Pool_t *createThreadPool(const int num_threads)
+{
+    Thread_Pool_t *pool = NULL;
+
+    SBC_CALLOC(1, sizeof *pool, pool);
+
+    pool->num_threads = num_threads < 1 ? 1 : num_threads;
+
+    SBC_CALLOC(pool->num_threads, sizeof *pool->workers, pool->workers);
+    SBC_CALLOC(pool->num_threads, sizeof *pool->ranges,  pool->ranges);
+
+#if defined (_WIN32)
+    InitializeSRWLock(&pool->lock);
+    InitializeConditionVariable(&pool->work_cond);
+    InitializeConditionVariable(&pool->done_cond);
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+#endif
+
+    /* thread 0 is whoever calls poolParallelFor */
+    for(int i = 1; i < pool->num_threads; i++)
+    {
+        pool_worker_t *w = &pool->workers[i];
+
+        w->pool  = pool;
+        w->index = i;
+
+#if defined (_WIN32)
+        if((w->handle = CreateThread(NULL, 0, pool_worker, w, 0, NULL)) == NULL)
+#else
+        if(pthread_create(&w->handle, NULL, pool_worker, w) != 0)
+#endif
+        {
+            SBC_ERR("Thread Pool", "Unable to create worker thread!");
+            pool->num_threads = i;
+            break;
+        }
+    }
+
+    SBC_LOG(THREAD POOL SIZE, %d, pool->num_threads);
+
+    return pool;
+}
+
+void destroyThreadPool(Thread_Pool_t **pool)
+{
+    Thread_Pool_t *p = NULL;
+
+    if(pool == NULL || *pool == NULL) return;
+
+    p = *pool;
+
+    POOL_LOCK(p);
+    atomic_store(&p->quit, true);
+    POOL_WAKE_ALL(p, work_cond);
+    POOL_UNLOCK(p);
+
+    for(int i = 1; i < p->num_threads; i++)
+    {
+#if defined (_WIN32)
+        WaitForSingleObject(p->workers[i].handle, INFINITE);
+        CloseHandle(p->workers[i].handle);
+#else
+        pthread_join(p->workers[i].handle, NULL);
+#endif
+    }
+
+#if !defined (_WIN32)
+    pthread_cond_destroy(&p->work_cond);
+    pthread_cond_destroy(&p->done_cond);
+    pthread_mutex_destroy(&p->lock);
+#endif
+
+    SBC_FREE(p->workers);
+    SBC_FREE(p->ranges);
+    SBC_FREE(*pool);
+}
+
+int getPoolThreadCount(const Thread_Pool_t *pool) { return pool == NULL ? 1 : pool->num_threads; }
+
+void poolParallelFor(Thread_Pool_t *pool, const PoolTask_t task, void *arg, const int count)
+{
+    assert(task != NULL);
+
+    if(count <= 0) return;
+
+    if(pool == NULL || pool->num_threads < 2 || count < 2)
+    {
+        for(int i = 0; i < count; i++) task(arg, i, 0);
+        return;
+    }
+
+    pool->task = task;
+    pool->arg  = arg;
+
+    for(int i = 0; i < pool->num_threads; i++)
+    {
+        const uint32_t lo = (uint32_t) ((int64_t) count * i / pool->num_threads),
+                       hi = (uint32_t) ((int64_t) count * (i + 1) / pool->num_threads);
+
+        atomic_store(&pool->ranges[i].range, RANGE(lo, hi));
+    }
+
+    atomic_store(&pool->active, pool->num_threads - 1);
+
+    POOL_LOCK(pool);
+    atomic_fetch_add(&pool->generation, 1);
+    POOL_WAKE_ALL(pool, work_cond);
+    POOL_UNLOCK(pool);
+
+    run_ranges(pool, 0);
+
+    if(atomic_load(&pool->active) > 0)
+    {
+        int spin = POOL_SPIN_COUNT;
+
+        while(--spin > 0 && atomic_load(&pool->active) > 0) {}
+
+        POOL_LOCK(pool);
+
+        while(atomic_load(&pool->active) > 0)
+            POOL_WAIT(pool, done_cond);
+
+        POOL_UNLOCK(pool);
+    }
+}
@@ -10,6 +10,7 @@
 #include "sbc_buttons.h"
 #include "sbc_sliders.h"
 
+#include "sbc_pitch.h"
 #include "sbc_fileload.h"
 #include "sbc_filesave.h"
 #include "sbc_filedialog.h"
@@ -41,11 +42,31 @@ int fixedMap(const int64_t x, const int64_t in_min, const int64_t in_max, const
 			(int)((((x - in_min) * ((out_max - out_min) << 32) / (in_max - in_min) + ROUND32) >> 32) + out_min);
 }
 
-void setSampScale(const int64_t samp_len)	{ samp2wave_scale = (samp_len << 32) / SCREEN_WIDTH; }
+/* 
+*   ((x * q) + ROUND32) >> 32 for a 32.32 fixed point q, without the 64-bit overflow
+*   once x * q passes 2^63 (more than 2^31 samples on screen)
+*/
+static int64_t mul_q32(const int64_t x, const int64_t q)
+{
+    const uint64_t ux = x < 0 ? 0 - (uint64_t) x : (uint64_t) x, uq = (uint64_t) q,
+                   x_lo = ux & 0xFFFFFFFF, q_lo = uq & 0xFFFFFFFF,
+                   round = x < 0 ? ROUND32 - 1 : ROUND32;
+
+    /* the arithmetic shift floors, so negative products round their magnitude the other way */
+    const uint64_t mag = (ux >> 32) * uq + x_lo * (uq >> 32) + ((x_lo * q_lo + round) >> 32);
+
+    return x < 0 ? -(int64_t) mag : (int64_t) mag;
+}
+
+void setSampScale(const int64_t samp_len)
+{
+    samp2wave_scale = ((samp_len / SCREEN_WIDTH) << 32) + (((samp_len % SCREEN_WIDTH) << 32) / SCREEN_WIDTH);
+}
+
 void setWaveScale(const int64_t line_len)	{ wave2samp_scale = ((int64_t)SCREEN_WIDTH << 32) / line_len; }
 
-int scr2samp(const int64_t x) { return (((x * samp2wave_scale) + ROUND32) >> 32) + *getWaveStart(); }
-int samp2scr(const int64_t x) { return (((x - *getWaveStart()) * wave2samp_scale) + ROUND32) >> 32; }
+int64_t scr2samp(const int64_t x) { return mul_q32(x, samp2wave_scale) + *getWaveStart(); }
+int64_t samp2scr(const int64_t x) { return mul_q32(x - *getWaveStart(), wave2samp_scale); }
 
 int hitbox(const Rect_t *r, const int x, const int y)
 {
@@ -99,11 +120,19 @@ bool loadSample(const char* file_path)
 {
 	char *file_name = NULL;
 
+	Sample_t samp_load;
+	SampFileType_t file_type = SAMP_FILE_ERROR;
+
 	if((file_path) == NULL) return false;
 
 	SBC_LOG(LOADING FILE, %s, file_path);
 
-	if(!loadFile(file_path)) return false;
+	if((file_type = readSampleFile(file_path, &samp_load)) == SAMP_FILE_ERROR) return false;
+
+	adoptSampleEdit(&samp_load);
+
+	/* raw and BRR files don't store a usable sample rate */
+	if(file_type == SAMP_FILE_RAW || file_type == SAMP_FILE_BRR) detectCenterPitch(false);
 
 	file_name = (char *) getFileNameWithoutExt(file_path);
 	handleSampleNameText(file_name);
@@ -155,7 +184,7 @@ void saveFileDialog(void)
 
 	SBC_LOG(SAVING FILE, %s, file_path);
 	
-	saveFile(file_path);
+	writeSampleFile(file_path, getSampleEdit(), exporting16bit());
 
 	SBC_FREE(file_path);
 }
@@ -183,9 +212,9 @@ char *getWorkingDir(void)
 	return work_dir;
 }
 
-int getRelativeBrrSampBlock(const int samp, const int ref_pos)
+int64_t getRelativeBrrSampBlock(const int64_t samp, const int64_t ref_pos)
 {
-    int new_samp = samp;
+    int64_t new_samp = samp;
 
 	if(!wasButtonClicked(getBrrButton())) return samp;
 
@@ -195,13 +224,6 @@ int getRelativeBrrSampBlock(const int samp, const int ref_pos)
     return new_samp + 1 < *getSampleEditLength() ? new_samp : *getSampleEditLength();
 }
 
-bool isStringEmpty(const char *s)
-{
-	if(s == NULL) return true;
-	if(s[0] == '\0') return true;
-    return false;
-}
-
 void initCursors(void)
 {
 	work_dir = _strndup("", 1);
@@ -258,55 +280,4 @@ void showErrorMsgBox(const char *title, const char *msg, const char *error)
 	SBC_ERR(title, errormsg);
 }
 
-char *_strndup(char *str, size_t chars)
-{
-#if defined (_WIN32)		// MinGW doesn't have strndup but likes to think it does
 
-    char *buffer;
-    size_t n;
-
-    buffer = (char *) malloc(chars +1);
-    if (buffer)
-    {
-        for (n = 0; ((n < chars) && (str[n] != 0)) ; n++) buffer[n] = str[n];
-        buffer[n] = 0;
-    }
-
-    return buffer;
-
-#else
-	return strndup(str, chars);
-#endif
-}
-
-/*
-* 	Cross-platform strcasestr with respect to early SDL2 versions. 
-*/
-char *_strcasestr(const char *haystack, const char *needle)
-{
-
-#ifdef HAVE_STRCASESTR
-        return strcasestr(haystack, needle);
-#elif(SDL_VERSION_ATLEAST(2,26,0))
-        return SDL_strcasestr(haystack, needle);
-#else
-        size_t length = SDL_strlen(needle);
-        while (*haystack) {
-                if (SDL_strncasecmp(haystack, needle, length) == 0) {
-                return (char *) haystack;
-                }
-                ++haystack;
-        }
-        return NULL;
-#endif
-
-}
-
-void print_args(const char *format, const int size, ...)
-{
-	va_list args; 
-	va_start(args, size); 
-	vprintf(format, args); 
-	va_end(args);
-	printf("\n");
-}
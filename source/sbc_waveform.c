@@ -5,6 +5,7 @@
 #include "sbc_screen.h"
 #include "sbc_sliders.h"
 #include "sbc_samp_edit.h"
+#include "sbc_record.h"
 
 /*
 *	TODO: reduce number of static stack variables....
@@ -32,18 +33,23 @@ static Rect_t scroll_bar  =
 };
 
 static struct WaveArea_t {
-	int start, end, width;
+	int64_t start, end, width;
 } wave_area  = { 0, 0, 0}, select_area = { 0, 0, /* unused */ 0};
 
 static int *point_x = NULL, *point_y = NULL;
-static int16_t *sample_buffer = NULL;
+/* the edit buffer itself, edits always swap in a new buffer and call drawNewWave */
+static const int16_t *sample_buffer = NULL;
 
-static int samp_length = 0, mouse_focus = 0, scroll_factor = 0;
+static int64_t samp_length = 0, mouse_focus = 0, scroll_factor = 0;
 static double zoom_divider = 0.0;
 
 static bool wave_changed = true, repaint_wave = true, wave_can_select = false;
 
-bool allocatePoints(const int len)
+/* while recording, the take being drawn in place of the edit buffer and the line printed over it */
+static const Record_Take_t *live_take = NULL;
+static const char *live_status = NULL;
+
+bool allocatePoints(const int64_t len)
 {
 	bool success = true;
 
@@ -66,20 +72,18 @@ void freePoints(void)
 
 void freeDrawingSampleBuffer(void)
 {
-	SBC_FREE(sample_buffer);
+	sample_buffer = NULL;
 	SBC_FREE(point_x);
 	SBC_FREE(point_y);
 }
 
-static void set_point_x(const int index, const int x)
+static void set_point_x(const int64_t index, const int64_t x)
 {
-	point_x[index] = x;
-
-	if(point_x[index] >= SCREEN_WIDTH)
-		point_x[index] = SCREEN_WIDTH;
+	/* anything left of the screen only needs to stay there */
+	point_x[index] = x >= SCREEN_WIDTH ? SCREEN_WIDTH : x < -SCREEN_WIDTH ? -SCREEN_WIDTH : (int) x;
 }
 
-static void set_point_y(const int index, const int y)
+static void set_point_y(const int64_t index, const int y)
 {
 	point_y[index] = y;
 
@@ -91,20 +95,16 @@ static int vert_map(const int x) { return SAMPLE_Y_CENTRE - ((x * SAMPLE_HEIGHT)
 
 void drawNewWave(void)
 {
-	if(*getSampleEditBuffer() == NULL)  return;
+	if((sample_buffer = *getSampleEditBuffer()) == NULL)  return;
 
 	samp_length = *getSampleEditLength();
 	
 	setSampScale(samp_length);
 	setWaveScale(samp_length);
 
-	SBC_FREE(sample_buffer);
-	SBC_MALLOC(samp_length, sizeof *sample_buffer, sample_buffer);
-
-	memcpy(sample_buffer, *getSampleEditBuffer(), samp_length * sizeof *sample_buffer);
 	allocatePoints(samp_length + 1);
 
-	for (int i = 0; i < samp_length; i++)
+	for (int64_t i = 0; i < samp_length; i++)
 		set_point_y(i, vert_map(sample_buffer[i]));
 
 	set_point_y(samp_length, point_y[samp_length - 1]);
@@ -144,7 +144,7 @@ void handleZoom(const bool zoom_in)
 
 	if (mouse_focus > 0) scroll_factor = mouse_focus - (samp_length >> 1);
 
-	SBC_LOG(LINE LENGTH, %d, wave_area.width);
+	SBC_LOG(LINE LENGTH, %lld, (long long) wave_area.width);
 	SBC_LOG(ZOOM DIVIDER, %f, zoom_divider);
 
 	updateSliders();
@@ -172,7 +172,7 @@ void handleScroll(const bool scroll_left)
 		if (scroll_factor >= samp_length / 2) scroll_factor = samp_length / 2 - 1;
 	}
 
-	SBC_LOG(SCROLL FACTOR, %d, scroll_factor);
+	SBC_LOG(SCROLL FACTOR, %lld, (long long) scroll_factor);
 
 	updateSliders();
 	wave_changed = true;
@@ -184,24 +184,24 @@ static int scroll_bar_x(const Rect_t *sb)
 			  scroll_max = SCREEN_WIDTH - sb->w - scroll_min,
 			  offset = sb->w <= 5 ? scroll_min : 0;
 
-	int scroll_x = 0;
+	int64_t scroll_x = 0;
 
 	if(wave_area.start <= 0) return scroll_min;
 	if(wave_area.end   >= samp_length) return scroll_max;
 	
 	// once upon a time, only God and myself knew why this worked. Now, only God knows...
-	scroll_x = (-point_x[0] * wave_area.width / samp_length) + (scroll_min - (14 * wave_area.start / (samp_length - offset)));
+	scroll_x = (-samp2scr(0) * wave_area.width / samp_length) + (scroll_min - (14 * wave_area.start / (samp_length - offset)));
 
-	return scroll_x < scroll_min ? scroll_min : scroll_x > scroll_max ? scroll_max : scroll_x;
+	return scroll_x < scroll_min ? scroll_min : scroll_x > scroll_max ? scroll_max : (int) scroll_x;
 }
 
 static void redraw_wave(void)
 {
-	int wave_adjust = 0;
+	int64_t wave_adjust = 0;
 
     if(point_x == NULL) return;
 	
-	wave_adjust = (int) floor((double) samp_length * zoom_divider);
+	wave_adjust = (int64_t) floor((double) samp_length * zoom_divider);
 
 	if (wave_area.end < 0) wave_area.end = samp_length;
 	if (mouse_focus == 0) mouse_focus = (wave_area.end + wave_area.start) >> 1;
@@ -226,12 +226,12 @@ static void redraw_wave(void)
 	setSampScale(wave_area.width);
 	setWaveScale(wave_area.width);
 
-	for (int i = 0; i < samp_length; i++)   
+	for (int64_t i = 0; i < samp_length; i++)   
 		set_point_x(i, samp2scr(i));
 
 	if(wave_area.end >= samp_length) set_point_x(samp_length, SCREEN_WIDTH);
 
-	scroll_bar.w = (SCREEN_WIDTH - 14) * wave_area.width / samp_length;
+	scroll_bar.w = (int) ((SCREEN_WIDTH - 14) * wave_area.width / samp_length);
 
 	if (scroll_bar.w <= 5) scroll_bar.w = 5;
 
@@ -261,8 +261,8 @@ static void draw_wave_lines(void)
 	{
 		int x1, y1, x2, y2;
 
-		int curr_samp = scr2samp(i + 0);
-		int next_samp = scr2samp(i + 1);
+		int64_t curr_samp = scr2samp(i + 0);
+		int64_t next_samp = scr2samp(i + 1);
 
 		if(curr_samp >= samp_length) curr_samp = samp_length - 1;
 		if(next_samp >= samp_length) next_samp = samp_length;
@@ -276,12 +276,12 @@ static void draw_wave_lines(void)
 	}
 }
 
-static void get_min_max(const int start, const int end, int *ymin, int *ymax)
+static void get_min_max(const int64_t start, const int64_t end, int *ymin, int *ymax)
 {
-	int samp_min = INT16_MAX, samp_max = INT16_MIN,
-		curr_end = end >= samp_length ? samp_length - 1 : end;
+	const int64_t curr_end = end >= samp_length ? samp_length - 1 : end;
+	int samp_min = INT16_MAX, samp_max = INT16_MIN;
 
-	for (int i = start; i <= curr_end; i++)
+	for (int64_t i = start; i <= curr_end; i++)
 	{
 		int curr_samp;
 		
@@ -307,8 +307,8 @@ static void draw_wave_polygons(void)
 
 	for(int i = 0; i <= SCREEN_WIDTH; i++)
 	{
-		int curr_samp = scr2samp(i + 0);
-		int next_samp = scr2samp(i + 1);
+		int64_t curr_samp = scr2samp(i + 0);
+		int64_t next_samp = scr2samp(i + 1);
 
 		if(curr_samp >= samp_length) curr_samp = samp_length - 1;
 		if(next_samp >= samp_length) next_samp = samp_length;
@@ -345,12 +345,66 @@ static void draw_waveform(void)
 	else draw_wave_lines();
 }
 
+/*
+*	one column per peak block until the take is wider than the screen, then each column takes the
+*	min and max of the blocks under it, so drawing never looks at more than the take's peaks
+*/
+static void draw_live_take(void)
+{
+	const int64_t num_peaks = live_take->num_peaks;
+	const int columns = num_peaks > SCREEN_WIDTH ? SCREEN_WIDTH : (int) num_peaks;
+
+	for(int i = 0; i < columns; i++)
+	{
+		const int64_t first = num_peaks > SCREEN_WIDTH ? (int64_t) i * num_peaks / SCREEN_WIDTH : i,
+		              last  = num_peaks > SCREEN_WIDTH ? ((int64_t) i + 1) * num_peaks / SCREEN_WIDTH : i + 1;
+		int lo = INT16_MAX, hi = INT16_MIN, ymin = 0, ymax = 0;
+
+		for(int64_t p = first; p < last; p++)
+		{
+			if(live_take->peaks[p][0] < lo) lo = live_take->peaks[p][0];
+			if(live_take->peaks[p][1] > hi) hi = live_take->peaks[p][1];
+		}
+
+		ymin = vert_map(hi);
+		ymax = vert_map(lo);
+
+		if(ymax >= SAMPLE_HEIGHT) ymax = SAMPLE_HEIGHT - 1;
+
+		draw_line(i, ymin, i, ymax);
+	}
+}
+
+void showRecordingWave(const Record_Take_t *take, const char *status)
+{
+	live_take = take;
+	live_status = status;
+
+	repaint_wave = true;
+}
+
 void updateWaveform(void)
 {
 	if(!repaint_wave) return;
 
 	clearScreenArea(0, SBCLGREY, SCREEN_WIDTH * SAMPLE_HEIGHT);
 
+	if(live_take != NULL)
+	{
+		draw_live_take();
+
+		draw_Hline(0, SAMPLE_Y_CENTRE, SCREEN_WIDTH, SBCDPURPLE);
+
+		if(live_status != NULL) 
+			print_string_shadow(live_status, 6, 6, (int[]) {1, 1}, (int[]) {0xFF121212, SCROLLPINK}, 1);
+
+		paint_bevel((Rect_t) {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0}, 0xFF2E2E2E, 0xFFBEBEBE);
+		draw_rect((Rect_t) {0, 0, SCREEN_WIDTH, SAMPLE_HEIGHT + 1, SBCDPURPLE });
+
+		repaint_wave = false;
+		return;
+	}
+
 	fill_rect(scroll_bar_back);
 
 	draw_waveform();
@@ -377,7 +431,7 @@ void updateWaveform(void)
 void drawLoopWindow(void)
 {
 	const int win_width = 96, win_height = 75;
-	const int loop_end = *getLoopEnd(), loop_start = *getLoopStart();
+	const int64_t loop_end = *getLoopEnd(), loop_start = *getLoopStart();
 
 	Rect_t loopend_win   = { 160, SAMPLE_HEIGHT + 58, win_width, win_height, SBCLPURPLE };
 	Rect_t loopstart_win = { 256, SAMPLE_HEIGHT + 58, win_width + 1, win_height, SBCLPURPLE };
@@ -454,32 +508,32 @@ bool mouseOverScrollBar(const int x, const int y)
 
 void setScrollFactor(const int mouse_x)
 {
-	const int scroll_length = fixedMap(mouse_x, 0, SCREEN_WIDTH, 0, samp_length);
+	const int64_t scroll_length = ((int64_t) mouse_x * samp_length + SCREEN_WIDTH / 2) / SCREEN_WIDTH;
 	scroll_factor = scroll_length - (samp_length >> 1);
 
-	SBC_LOG(SCROLL FACTOR, %d, scroll_factor);
+	SBC_LOG(SCROLL FACTOR, %lld, (long long) scroll_factor);
 	updateSliders();
 
 	wave_changed = true;
 }
 
-int *getWaveStart(void) { return &wave_area.start; }
-void setMouseFocus(const int x)	{ mouse_focus = x;}
+int64_t *getWaveStart(void) { return &wave_area.start; }
+void setMouseFocus(const int64_t x)	{ mouse_focus = x;}
 
-void setCursor(const int x)     
+void setCursor(const int64_t x)     
 { 
 	select_area.start = select_area.end = getRelativeBrrSampBlock(x, *getSampStart());  
-	SBC_LOG(MOUSE CURSOR, %d, select_area.start ); 
+	SBC_LOG(MOUSE CURSOR, %lld, (long long) select_area.start ); 
 }
 
-void setSelEnd(const int x)		
+void setSelEnd(const int64_t x)		
 { 
 	select_area.end = getRelativeBrrSampBlock(x, *getSampStart());
 
 	if (select_area.end < wave_area.start) select_area.end = wave_area.start;
 	else if (select_area.end > wave_area.end) select_area.end = wave_area.end;
 
-	SBC_LOG(SELECT END \t, %d, select_area.end);
+	SBC_LOG(SELECT END \t, %lld, (long long) select_area.end);
 }
 
 void handleSelectAll(void)
@@ -487,22 +541,22 @@ void handleSelectAll(void)
 	select_area.start = 0;
 	select_area.end = samp_length;
 	
-	SBC_LOG(SELECT START, %d, select_area.start);
-	SBC_LOG(SELECT END \t, %d, select_area.end);
+	SBC_LOG(SELECT START, %lld, (long long) select_area.start);
+	SBC_LOG(SELECT END \t, %lld, (long long) select_area.end);
 }
 
 void handleSampleCopy(void)
 {
-	const int start = select_area.start < select_area.end ? select_area.start : select_area.end,
-			  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
+	const int64_t start = select_area.start < select_area.end ? select_area.start : select_area.end,
+				  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
 
 	copySampleRange(start, end);	
 }
 
 bool handleSampleCut(void)
 {
-	const int start = select_area.start < select_area.end ? select_area.start : select_area.end,
-			  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
+	const int64_t start = select_area.start < select_area.end ? select_area.start : select_area.end,
+				  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
 
 	if(start == end) return cutAtCursor(start);
 	else return cutSampleRange(start, end);
@@ -510,8 +564,8 @@ bool handleSampleCut(void)
 
 bool handleSampleCrop(void)
 {
-	const int start = select_area.start < select_area.end ? select_area.start : select_area.end,
-			  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
+	const int64_t start = select_area.start < select_area.end ? select_area.start : select_area.end,
+				  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
 
 	if(start == end) return false;
 	else return cropSampleRange(start, end);
@@ -519,8 +573,8 @@ bool handleSampleCrop(void)
 
 bool handleSamplePaste(void)
 {
-	const int start = select_area.start < select_area.end ? select_area.start : select_area.end,
-			  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
+	const int64_t start = select_area.start < select_area.end ? select_area.start : select_area.end,
+				  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
 
 	if(start == end)  return pasteAtCursor(start, true);
 	return pasteOverRange(start, end);
@@ -530,10 +584,10 @@ bool handleSampleDelete(void)
 {
 	bool update = false;
 
-	const int start = select_area.start < select_area.end ? select_area.start : select_area.end,
-			  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
+	const int64_t start = select_area.start < select_area.end ? select_area.start : select_area.end,
+				  end   = select_area.start < select_area.end ? select_area.end : select_area.start;
 
-	int new_len = 0;
+	int64_t new_len = 0;
 
 	if(start == end) 
 	{
@@ -550,8 +604,8 @@ bool handleSampleDelete(void)
 	if(new_len <= 0) select_area.end = select_area.start = 0;
 	else if(select_area.end >= new_len) select_area.end = select_area.start = new_len - 1;
 	
-	SBC_LOG(SELECT START, %d, select_area.start);
-	SBC_LOG(SELECT END \t, %d, select_area.end);
+	SBC_LOG(SELECT START, %lld, (long long) select_area.start);
+	SBC_LOG(SELECT END \t, %lld, (long long) select_area.end);
 
 	return update;
 }